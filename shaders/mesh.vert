@@ -30,15 +30,28 @@ layout(buffer_reference, std430) readonly buffer VertexBuffer {
     sVertex vertices[];
 };
 
-layout(push_constant) uniform constants {
+// Render::sGPUInstance
+struct sInstance {
     mat4 model_matrix;
+    vec4 position_min;
+    vec4 position_extent;
+};
+
+layout(buffer_reference, std430) readonly buffer InstanceBuffer {
+    sInstance instances[];
+};
+
+layout(push_constant) uniform constants {
     VertexBuffer vertex_buffer;
+    InstanceBuffer instance_buffer;
 } PushConstants;
 
 void main() {
     sVertex v = PushConstants.vertex_buffer.vertices[gl_VertexIndex];
+    // Includes the first instance of the draw
+    sInstance instance = PushConstants.instance_buffer.instances[gl_InstanceIndex];
 
-    gl_Position = scene_data.view_proj * PushConstants.model_matrix * vec4(v.position, 1.0f);
+    gl_Position = scene_data.view_proj * instance.model_matrix * vec4(v.position, 1.0f);
     out_color = v.color.xyz * 0.5 + 0.5;
     out_uv = v.uv;
 }
\ No newline at end of file
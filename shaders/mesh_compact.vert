@@ -0,0 +1,69 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+layout(location = 0) out vec3 out_color;
+layout(location = 1) out vec2 out_uv;
+
+// Render::sCompactVertex
+struct sCompactVertex {
+    uint position_xy;
+    uint position_z;
+    uint normal;
+    uint tangent;
+    uint uv;
+    uint color;
+};
+
+layout(set = 0u, binding = 0u) uniform sSceneData {
+    mat4 view;
+    mat4 proj;
+    mat4 view_proj;
+    vec4 ambient_color;
+    vec3 sunlight_dir;
+    float sun_power;
+    vec4 sunlight_color;
+} scene_data;
+
+layout(buffer_reference, std430) readonly buffer CompactVertexBuffer {
+    sCompactVertex vertices[];
+};
+
+// Render::sGPUInstance
+struct sInstance {
+    mat4 model_matrix;
+    vec4 position_min;
+    vec4 position_extent;
+};
+
+layout(buffer_reference, std430) readonly buffer InstanceBuffer {
+    sInstance instances[];
+};
+
+layout(push_constant) uniform constants {
+    CompactVertexBuffer vertex_buffer;
+    InstanceBuffer instance_buffer;
+} PushConstants;
+
+vec3 octahedral_decode(const vec2 encoded) {
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    const float fold = max(-direction.z, 0.0);
+    direction.x += (direction.x >= 0.0) ? -fold : fold;
+    direction.y += (direction.y >= 0.0) ? -fold : fold;
+    return normalize(direction);
+}
+
+void main() {
+    sCompactVertex v = PushConstants.vertex_buffer.vertices[gl_VertexIndex];
+    // Includes the first instance of the draw
+    sInstance instance = PushConstants.instance_buffer.instances[gl_InstanceIndex];
+
+    const vec3 quantized_position = vec3(unpackUnorm2x16(v.position_xy), unpackUnorm2x16(v.position_z).x);
+    const vec3 position = instance.position_min.xyz + quantized_position * instance.position_extent.xyz;
+
+    gl_Position = scene_data.view_proj * instance.model_matrix * vec4(position, 1.0f);
+    // Alpha 0: no vertex colors, the fallback is the normal as on mesh.vert
+    const vec3 normal = octahedral_decode(unpackSnorm2x16(v.normal));
+    const vec4 color = unpackUnorm4x8(v.color);
+    out_color = ((color.a == 0.0) ? normal : color.xyz) * 0.5 + 0.5;
+    out_uv = unpackHalf2x16(v.uv);
+}
\ No newline at end of file
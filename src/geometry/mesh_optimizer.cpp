@@ -0,0 +1,426 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <glm/glm.hpp>
+
+#include "../utils.h"
+
+#define INVALID_IDX UINT32_MAX
+
+Geometry::sVertexCacheStats Geometry::analyze_vertex_cache( const uint32_t *indices,
+                                                            const uint32_t index_count,
+                                                            const uint32_t vertex_count,
+                                                            const uint32_t cache_size) {
+    sVertexCacheStats stats = {
+        .triangle_count = index_count / 3u,
+        .vertex_count = vertex_count
+    };
+
+    // FIFO cache: a vertex is in the cache if it was pushed less than cache_size misses ago
+    uint32_t *cache_timestamps = (uint32_t*) calloc(vertex_count, sizeof(uint32_t));
+    uint32_t timestamp = cache_size + 1u;
+
+    for(uint32_t i = 0u; i < index_count; i++) {
+        const uint32_t idx = indices[i];
+        if (timestamp - cache_timestamps[idx] > cache_size) {
+            cache_timestamps[idx] = timestamp++;
+            stats.transformed_vertex_count++;
+        }
+    }
+
+    free(cache_timestamps);
+
+    return stats;
+}
+
+// =============================
+// Vertex cache
+// =============================
+
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+#define FORSYTH_VALENCE_TABLE_SIZE 32u
+
+struct sForsythTables {
+    float cache_position[VERTEX_CACHE_OPTIMIZE_SIZE];
+    float valence[FORSYTH_VALENCE_TABLE_SIZE];
+
+    sForsythTables() {
+        for(uint32_t i = 0u; i < VERTEX_CACHE_OPTIMIZE_SIZE; i++) {
+            if (i < 3u) {
+                // The last triangle's vertices, fixed score to avoid favoring strips
+                cache_position[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+            } else {
+                const float scaler = 1.0f / (VERTEX_CACHE_OPTIMIZE_SIZE - 3u);
+                cache_position[i] = powf(1.0f - (i - 3u) * scaler, FORSYTH_CACHE_DECAY_POWER);
+            }
+        }
+
+        valence[0u] = 0.0f;
+        for(uint32_t i = 1u; i < FORSYTH_VALENCE_TABLE_SIZE; i++) {
+            valence[i] = FORSYTH_VALENCE_BOOST_SCALE * powf((float) i, -FORSYTH_VALENCE_BOOST_POWER);
+        }
+    }
+};
+
+static const sForsythTables forsyth_tables;
+
+static inline float get_vertex_score(const int32_t cache_position, const uint32_t remaining_valence) {
+    if (remaining_valence == 0u) {
+        // No triangles left that use it
+        return -1.0f;
+    }
+
+    float score = (cache_position >= 0) ? forsyth_tables.cache_position[cache_position] : 0.0f;
+    score += (remaining_valence < FORSYTH_VALENCE_TABLE_SIZE) ?
+                    forsyth_tables.valence[remaining_valence] :
+                    FORSYTH_VALENCE_BOOST_SCALE * powf((float) remaining_valence, -FORSYTH_VALENCE_BOOST_POWER);
+
+    return score;
+}
+
+void Geometry::optimize_vertex_cache(   uint32_t *indices,
+                                        const uint32_t index_count,
+                                        const uint32_t vertex_count) {
+    const uint32_t triangle_count = index_count / 3u;
+    if (triangle_count == 0u) {
+        return;
+    }
+
+    // Vertex -> triangles adjacency
+    uint32_t *adjacency_offsets = (uint32_t*) calloc(vertex_count + 1u, sizeof(uint32_t));
+    uint32_t *remaining_valence = (uint32_t*) calloc(vertex_count, sizeof(uint32_t));
+    uint32_t *adjacent_triangles = (uint32_t*) malloc(sizeof(uint32_t) * triangle_count * 3u);
+
+    for(uint32_t i = 0u; i < index_count; i++) {
+        remaining_valence[indices[i]]++;
+    }
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        adjacency_offsets[i + 1u] = adjacency_offsets[i] + remaining_valence[i];
+    }
+    {
+        uint32_t *fill_count = (uint32_t*) calloc(vertex_count, sizeof(uint32_t));
+        for(uint32_t i = 0u; i < index_count; i++) {
+            const uint32_t idx = indices[i];
+            adjacent_triangles[adjacency_offsets[idx] + fill_count[idx]++] = i / 3u;
+        }
+        free(fill_count);
+    }
+
+    int32_t *cache_position = (int32_t*) malloc(sizeof(int32_t) * vertex_count);
+    float *vertex_score = (float*) malloc(sizeof(float) * vertex_count);
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        cache_position[i] = -1;
+        vertex_score[i] = get_vertex_score(-1, remaining_valence[i]);
+    }
+
+    bool *is_emitted = (bool*) calloc(triangle_count, sizeof(bool));
+
+    // Starts on the best scored triangle, the next ones are only searched around the cache
+    uint32_t best_triangle = 0u;
+    float best_start_score = -1.0f;
+    for(uint32_t i = 0u; i < triangle_count; i++) {
+        const float score = vertex_score[indices[i * 3u]] + vertex_score[indices[i * 3u + 1u]] + vertex_score[indices[i * 3u + 2u]];
+        if (score > best_start_score) {
+            best_start_score = score;
+            best_triangle = i;
+        }
+    }
+
+    uint32_t *result = (uint32_t*) malloc(sizeof(uint32_t) * index_count);
+
+    uint32_t cache[VERTEX_CACHE_OPTIMIZE_SIZE + 3u];
+    uint32_t cache_count = 0u;
+    uint32_t new_cache[VERTEX_CACHE_OPTIMIZE_SIZE + 3u];
+
+    uint32_t input_cursor = 0u;
+
+    for(uint32_t emitted_count = 0u; emitted_count < triangle_count; emitted_count++) {
+        if (best_triangle == INVALID_IDX) {
+            // Nothing in the cache has triangles left, continue on input order
+            while(is_emitted[input_cursor]) {
+                input_cursor++;
+            }
+            best_triangle = input_cursor;
+        }
+
+        const uint32_t *triangle = &indices[best_triangle * 3u];
+        memcpy(&result[emitted_count * 3u], triangle, sizeof(uint32_t) * 3u);
+        is_emitted[best_triangle] = true;
+
+        // Remove the triangle from its vertices' adjacency
+        for(uint32_t k = 0u; k < 3u; k++) {
+            const uint32_t idx = triangle[k];
+            uint32_t *adjacent = &adjacent_triangles[adjacency_offsets[idx]];
+            const uint32_t count = remaining_valence[idx];
+
+            for(uint32_t j = 0u; j < count; j++) {
+                if (adjacent[j] == best_triangle) {
+                    adjacent[j] = adjacent[count - 1u];
+                    break;
+                }
+            }
+            remaining_valence[idx]--;
+        }
+
+        // The triangle's vertices go to the front, the rest keep their order
+        uint32_t new_cache_count = 0u;
+        new_cache[new_cache_count++] = triangle[0u];
+        new_cache[new_cache_count++] = triangle[1u];
+        new_cache[new_cache_count++] = triangle[2u];
+        for(uint32_t j = 0u; j < cache_count; j++) {
+            const uint32_t idx = cache[j];
+            if (idx != triangle[0u] && idx != triangle[1u] && idx != triangle[2u]) {
+                new_cache[new_cache_count++] = idx;
+            }
+        }
+
+        // Entries past the cache size were evicted, update them too
+        for(uint32_t j = 0u; j < new_cache_count; j++) {
+            const uint32_t idx = new_cache[j];
+            cache_position[idx] = (j < VERTEX_CACHE_OPTIMIZE_SIZE) ? (int32_t) j : -1;
+            vertex_score[idx] = get_vertex_score(cache_position[idx], remaining_valence[idx]);
+        }
+
+        best_triangle = INVALID_IDX;
+        float best_score = -1.0f;
+        for(uint32_t j = 0u; j < new_cache_count; j++) {
+            const uint32_t idx = new_cache[j];
+            const uint32_t *adjacent = &adjacent_triangles[adjacency_offsets[idx]];
+
+            for(uint32_t t = 0u; t < remaining_valence[idx]; t++) {
+                const uint32_t tri = adjacent[t];
+                const float score = vertex_score[indices[tri * 3u]] + vertex_score[indices[tri * 3u + 1u]] + vertex_score[indices[tri * 3u + 2u]];
+
+                if (score > best_score) {
+                    best_score = score;
+                    best_triangle = tri;
+                }
+            }
+        }
+
+        cache_count = std::min(new_cache_count, VERTEX_CACHE_OPTIMIZE_SIZE);
+        memcpy(cache, new_cache, sizeof(uint32_t) * cache_count);
+    }
+
+    memcpy(indices, result, sizeof(uint32_t) * index_count);
+
+    free(result);
+    free(is_emitted);
+    free(vertex_score);
+    free(cache_position);
+    free(adjacent_triangles);
+    free(remaining_valence);
+    free(adjacency_offsets);
+}
+
+// =============================
+// Overdraw
+// =============================
+
+struct sTriangleCluster {
+    uint32_t    first_triangle;
+    uint32_t    triangle_count;
+    float       sort_key;
+};
+
+static inline glm::vec3 get_position(const uint8_t *positions, const uint32_t stride, const uint32_t idx) {
+    glm::vec3 position;
+    memcpy(&position, positions + (uint64_t) idx * stride, sizeof(glm::vec3));
+    return position;
+}
+
+void Geometry::optimize_overdraw(   uint32_t *indices,
+                                    const uint32_t index_count,
+                                    const uint8_t *positions,
+                                    const uint32_t position_stride,
+                                    const uint32_t vertex_count,
+                                    const float acmr_threshold) {
+    const uint32_t triangle_count = index_count / 3u;
+    if (triangle_count < 2u) {
+        return;
+    }
+
+    // Split the cache ordered triangles where the cache starts over (all of the triangle's vertices miss),
+    // moving clusters around does not break the order inside of them
+    sTriangleCluster *clusters = (sTriangleCluster*) malloc(sizeof(sTriangleCluster) * triangle_count);
+    uint32_t cluster_count = 0u;
+    {
+        uint32_t *cache_timestamps = (uint32_t*) calloc(vertex_count, sizeof(uint32_t));
+        uint32_t timestamp = VERTEX_CACHE_ANALYZE_SIZE + 1u;
+
+        for(uint32_t i = 0u; i < triangle_count; i++) {
+            uint32_t misses = 0u;
+            for(uint32_t k = 0u; k < 3u; k++) {
+                const uint32_t idx = indices[i * 3u + k];
+                if (timestamp - cache_timestamps[idx] > VERTEX_CACHE_ANALYZE_SIZE) {
+                    cache_timestamps[idx] = timestamp++;
+                    misses++;
+                }
+            }
+
+            if (i == 0u || misses == 3u) {
+                clusters[cluster_count++] = { .first_triangle = i, .triangle_count = 0u };
+            }
+            clusters[cluster_count - 1u].triangle_count++;
+        }
+
+        free(cache_timestamps);
+    }
+
+    if (cluster_count < 2u) {
+        free(clusters);
+        return;
+    }
+
+    // Area weighted mesh center
+    glm::vec3 mesh_center = {0.0f, 0.0f, 0.0f};
+    float mesh_area = 0.0f;
+    for(uint32_t i = 0u; i < triangle_count; i++) {
+        const glm::vec3 p0 = get_position(positions, position_stride, indices[i * 3u]);
+        const glm::vec3 p1 = get_position(positions, position_stride, indices[i * 3u + 1u]);
+        const glm::vec3 p2 = get_position(positions, position_stride, indices[i * 3u + 2u]);
+        const float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+
+        mesh_center += (p0 + p1 + p2) * (area / 3.0f);
+        mesh_area += area;
+    }
+    mesh_center = (mesh_area > 0.0f) ? mesh_center / mesh_area : mesh_center;
+
+    // Clusters that face away from the center are on the outside, and occlude the rest
+    for(uint32_t c = 0u; c < cluster_count; c++) {
+        sTriangleCluster &cluster = clusters[c];
+
+        glm::vec3 cluster_center = {0.0f, 0.0f, 0.0f};
+        glm::vec3 cluster_normal = {0.0f, 0.0f, 0.0f};
+        float cluster_area = 0.0f;
+        for(uint32_t i = cluster.first_triangle; i < cluster.first_triangle + cluster.triangle_count; i++) {
+            const glm::vec3 p0 = get_position(positions, position_stride, indices[i * 3u]);
+            const glm::vec3 p1 = get_position(positions, position_stride, indices[i * 3u + 1u]);
+            const glm::vec3 p2 = get_position(positions, position_stride, indices[i * 3u + 2u]);
+            const glm::vec3 weighted_normal = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(weighted_normal);
+
+            cluster_center += (p0 + p1 + p2) * (area / 3.0f);
+            cluster_normal += weighted_normal;
+            cluster_area += area;
+        }
+
+        cluster_center = (cluster_area > 0.0f) ? cluster_center / cluster_area : cluster_center;
+        const float normal_length = glm::length(cluster_normal);
+        cluster_normal = (normal_length > 0.0f) ? cluster_normal / normal_length : cluster_normal;
+
+        cluster.sort_key = glm::dot(cluster_center - mesh_center, cluster_normal);
+    }
+
+    std::stable_sort(   clusters,
+                        clusters + cluster_count,
+                        [](const sTriangleCluster &a, const sTriangleCluster &b) { return a.sort_key > b.sort_key; });
+
+    uint32_t *result = (uint32_t*) malloc(sizeof(uint32_t) * index_count);
+    uint32_t result_count = 0u;
+    for(uint32_t c = 0u; c < cluster_count; c++) {
+        const uint32_t cluster_index_count = clusters[c].triangle_count * 3u;
+        memcpy(&result[result_count], &indices[clusters[c].first_triangle * 3u], sizeof(uint32_t) * cluster_index_count);
+        result_count += cluster_index_count;
+    }
+
+    // Keep the cache order if the new one costs too many vertex transforms
+    const float cache_acmr = analyze_vertex_cache(indices, index_count, vertex_count, VERTEX_CACHE_ANALYZE_SIZE).get_acmr();
+    const float overdraw_acmr = analyze_vertex_cache(result, index_count, vertex_count, VERTEX_CACHE_ANALYZE_SIZE).get_acmr();
+    if (overdraw_acmr <= cache_acmr * acmr_threshold) {
+        memcpy(indices, result, sizeof(uint32_t) * index_count);
+    }
+
+    free(result);
+    free(clusters);
+}
+
+// =============================
+// Vertex fetch
+// =============================
+
+void Geometry::optimize_vertex_fetch(   uint32_t *indices,
+                                        const uint32_t index_count,
+                                        uint8_t *vertices,
+                                        const uint32_t vertex_size,
+                                        const uint32_t vertex_count) {
+    uint32_t *remap = (uint32_t*) malloc(sizeof(uint32_t) * vertex_count);
+    memset(remap, 0xff, sizeof(uint32_t) * vertex_count);
+
+    uint8_t *result = (uint8_t*) malloc((uint64_t) vertex_size * vertex_count);
+
+    uint32_t next_vertex = 0u;
+    for(uint32_t i = 0u; i < index_count; i++) {
+        const uint32_t idx = indices[i];
+        if (remap[idx] == INVALID_IDX) {
+            remap[idx] = next_vertex;
+            memcpy(result + (uint64_t) next_vertex * vertex_size, vertices + (uint64_t) idx * vertex_size, vertex_size);
+            next_vertex++;
+        }
+        indices[i] = remap[idx];
+    }
+
+    // Unreferenced vertices are kept, so the mesh ranges do not change
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        if (remap[i] == INVALID_IDX) {
+            memcpy(result + (uint64_t) next_vertex * vertex_size, vertices + (uint64_t) i * vertex_size, vertex_size);
+            next_vertex++;
+        }
+    }
+
+    memcpy(vertices, result, (uint64_t) vertex_size * vertex_count);
+
+    free(result);
+    free(remap);
+}
+
+uint32_t Geometry::weld_vertices(   uint32_t *indices,
+                                    const uint32_t index_count,
+                                    uint8_t *vertices,
+                                    const uint32_t vertex_size,
+                                    const uint32_t vertex_count) {
+    // Open addressing table of the kept vertices, by the hash of their bytes
+    uint32_t table_size = 64u;
+    while(table_size < vertex_count * 2u) {
+        table_size *= 2u;
+    }
+    uint32_t *table = (uint32_t*) malloc(sizeof(uint32_t) * table_size);
+    memset(table, 0xff, sizeof(uint32_t) * table_size);
+
+    uint32_t *remap = (uint32_t*) malloc(sizeof(uint32_t) * vertex_count);
+
+    uint32_t welded_count = 0u;
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        const uint8_t *vertex = vertices + (uint64_t) i * vertex_size;
+        uint32_t slot = (uint32_t) hash_bytes(vertex, vertex_size) & (table_size - 1u);
+
+        while(table[slot] != INVALID_IDX && memcmp(vertices + (uint64_t) table[slot] * vertex_size, vertex, vertex_size) != 0) {
+            slot = (slot + 1u) & (table_size - 1u);
+        }
+
+        if (table[slot] == INVALID_IDX) {
+            // First appearance, moved to the end of the compacted vertices (never ahead of i)
+            if (welded_count != i) {
+                memcpy(vertices + (uint64_t) welded_count * vertex_size, vertex, vertex_size);
+            }
+            table[slot] = welded_count;
+            welded_count++;
+        }
+        remap[i] = table[slot];
+    }
+
+    for(uint32_t i = 0u; i < index_count; i++) {
+        indices[i] = remap[indices[i]];
+    }
+
+    free(remap);
+    free(table);
+
+    return welded_count;
+}
\ No newline at end of file
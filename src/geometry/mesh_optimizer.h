@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+// Cache size the triangle order is optimized for (Forsyth)
+#define VERTEX_CACHE_OPTIMIZE_SIZE 32u
+// FIFO size for the ACMR/ATVR stats, close to what current GPUs behave like
+#define VERTEX_CACHE_ANALYZE_SIZE 16u
+// How much ACMR the overdraw pass can give up
+#define OVERDRAW_ACMR_THRESHOLD 1.05f
+
+namespace Geometry {
+
+    struct sVertexCacheStats {
+        uint32_t    transformed_vertex_count = 0u;
+        uint32_t    triangle_count = 0u;
+        uint32_t    vertex_count = 0u;
+
+        // Average cache miss ratio, vertex shader invocations per triangle (0.5 - 3.0)
+        inline float get_acmr() const {
+            return (triangle_count == 0u) ? 0.0f : (float) transformed_vertex_count / (float) triangle_count;
+        }
+
+        // Average transform to vertex ratio, 1.0 is optimal
+        inline float get_atvr() const {
+            return (vertex_count == 0u) ? 0.0f : (float) transformed_vertex_count / (float) vertex_count;
+        }
+
+        inline void add(const sVertexCacheStats &other) {
+            transformed_vertex_count += other.transformed_vertex_count;
+            triangle_count += other.triangle_count;
+            vertex_count += other.vertex_count;
+        }
+    };
+
+    sVertexCacheStats analyze_vertex_cache( const uint32_t *indices,
+                                            const uint32_t index_count,
+                                            const uint32_t vertex_count,
+                                            const uint32_t cache_size);
+
+    /**
+    * Merges the bit identical vertices (compares all the vertex_size bytes, so the padding
+    * needs to be cleared), compacting the vertices in place on first appearance order.
+    * Runs before the other optimizations. Returns the new vertex count.
+    */
+    uint32_t weld_vertices( uint32_t *indices,
+                            const uint32_t index_count,
+                            uint8_t *vertices,
+                            const uint32_t vertex_size,
+                            const uint32_t vertex_count);
+
+    /**
+    * Import time mesh optimizations, run in this order:
+    *   1. Triangle order for the post-transform cache (Forsyth's greedy scoring)
+    *   2. Triangle clusters sorted front to back from the mesh center for less overdraw,
+    *      kept only if the ACMR does not get worse than the threshold
+    *   3. Vertices sorted on first use, for fetch locality (unused vertices go to the end)
+    * All of them work on indices relative to the mesh's first vertex.
+    */
+    void optimize_vertex_cache( uint32_t *indices,
+                                const uint32_t index_count,
+                                const uint32_t vertex_count);
+
+    void optimize_overdraw( uint32_t *indices,
+                            const uint32_t index_count,
+                            const uint8_t *positions,
+                            const uint32_t position_stride,
+                            const uint32_t vertex_count,
+                            const float acmr_threshold);
+
+    void optimize_vertex_fetch( uint32_t *indices,
+                                const uint32_t index_count,
+                                uint8_t *vertices,
+                                const uint32_t vertex_size,
+                                const uint32_t vertex_count);
+};
\ No newline at end of file
@@ -0,0 +1,335 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <glm/glm.hpp>
+
+#define SIMPLIFY_MAX_PASSES 32u
+// Cosine of the max rotation of a triangle's normal on a collapse, also rejects the slivers folding on edge
+#define SIMPLIFY_MIN_NORMAL_COS 0.25f
+
+// Symmetric 4x4 plane quadric, weighted by the triangles' area
+struct sQuadric {
+    float a00, a11, a22;
+    float a01, a02, a12;
+    float b0, b1, b2;
+    float c;
+    float weight;
+
+    void add_plane(const glm::vec3 &normal, const float distance, const float plane_weight) {
+        a00 += normal.x * normal.x * plane_weight;
+        a11 += normal.y * normal.y * plane_weight;
+        a22 += normal.z * normal.z * plane_weight;
+        a01 += normal.x * normal.y * plane_weight;
+        a02 += normal.x * normal.z * plane_weight;
+        a12 += normal.y * normal.z * plane_weight;
+        b0 += normal.x * distance * plane_weight;
+        b1 += normal.y * distance * plane_weight;
+        b2 += normal.z * distance * plane_weight;
+        c += distance * distance * plane_weight;
+        weight += plane_weight;
+    }
+
+    void add(const sQuadric &other) {
+        a00 += other.a00; a11 += other.a11; a22 += other.a22;
+        a01 += other.a01; a02 += other.a02; a12 += other.a12;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    // Weighted sum of the squared distances to the planes
+    float evaluate(const glm::vec3 &p) const {
+        const float rx = a00 * p.x + a01 * p.y + a02 * p.z;
+        const float ry = a01 * p.x + a11 * p.y + a12 * p.z;
+        const float rz = a02 * p.x + a12 * p.y + a22 * p.z;
+
+        const float result = p.x * rx + p.y * ry + p.z * rz + 2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+        return (result > 0.0f) ? result : 0.0f;
+    }
+};
+
+struct sCollapse {
+    uint32_t    from;
+    uint32_t    to;
+    float       cost;
+};
+
+// Open addressing set of 64 bit keys, for the edge & position lookups
+struct sKeyCounter {
+    uint64_t    *keys = nullptr;
+    uint32_t    *counts = nullptr;
+    uint32_t    capacity = 0u;
+
+    void init(const uint32_t element_count) {
+        capacity = 64u;
+        while(capacity < element_count * 2u) {
+            capacity *= 2u;
+        }
+        keys = (uint64_t*) malloc(sizeof(uint64_t) * capacity);
+        counts = (uint32_t*) calloc(capacity, sizeof(uint32_t));
+        memset(keys, 0xff, sizeof(uint64_t) * capacity);
+    }
+
+    void clean() {
+        free(keys);
+        free(counts);
+    }
+
+    uint32_t find_slot(const uint64_t key) const {
+        uint64_t hash = key * 0x9e3779b97f4a7c15ull;
+        uint32_t slot = (uint32_t) (hash >> 32u) & (capacity - 1u);
+        while(keys[slot] != key && keys[slot] != UINT64_MAX) {
+            slot = (slot + 1u) & (capacity - 1u);
+        }
+        return slot;
+    }
+
+    void add(const uint64_t key) {
+        const uint32_t slot = find_slot(key);
+        keys[slot] = key;
+        counts[slot]++;
+    }
+
+    uint32_t get_count(const uint64_t key) const {
+        const uint32_t slot = find_slot(key);
+        return (keys[slot] == key) ? counts[slot] : 0u;
+    }
+};
+
+static inline glm::vec3 get_position(const uint8_t *positions, const uint32_t stride, const uint32_t idx) {
+    glm::vec3 position;
+    memcpy(&position, positions + (uint64_t) idx * stride, sizeof(glm::vec3));
+    return position;
+}
+
+static inline uint64_t get_edge_key(const uint32_t a, const uint32_t b) {
+    return (a < b) ? ((uint64_t) a << 32u) | b : ((uint64_t) b << 32u) | a;
+}
+
+static inline uint64_t get_position_key(const glm::vec3 &position) {
+    uint32_t bits[3u];
+    memcpy(bits, &position, sizeof(bits));
+    return ((uint64_t) bits[0u] * 73856093u) ^ ((uint64_t) bits[1u] * 19349663u << 16u) ^ ((uint64_t) bits[2u] * 83492791u << 32u);
+}
+
+// The triangles around from that do not collapse, must keep their facing after the move
+static bool collapse_keeps_orientation( const uint32_t *triangles,
+                                        const uint32_t *adjacency_offsets,
+                                        const uint32_t *adjacent_triangles,
+                                        const glm::vec3 *vertex_positions,
+                                        const uint32_t from,
+                                        const uint32_t to) {
+    for(uint32_t i = adjacency_offsets[from]; i < adjacency_offsets[from + 1u]; i++) {
+        const uint32_t *triangle = &triangles[adjacent_triangles[i] * 3u];
+        if (triangle[0u] == to || triangle[1u] == to || triangle[2u] == to) {
+            continue;
+        }
+
+        glm::vec3 p[3u], moved[3u];
+        for(uint32_t k = 0u; k < 3u; k++) {
+            p[k] = vertex_positions[triangle[k]];
+            moved[k] = (triangle[k] == from) ? vertex_positions[to] : p[k];
+        }
+
+        const glm::vec3 normal = glm::cross(p[1u] - p[0u], p[2u] - p[0u]);
+        const glm::vec3 moved_normal = glm::cross(moved[1u] - moved[0u], moved[2u] - moved[0u]);
+        if (glm::dot(normal, moved_normal) <= SIMPLIFY_MIN_NORMAL_COS * glm::length(normal) * glm::length(moved_normal)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+float Geometry::simplify(   const uint32_t *indices,
+                            const uint32_t index_count,
+                            const uint8_t *positions,
+                            const uint32_t position_stride,
+                            const uint32_t vertex_count,
+                            const uint32_t target_index_count,
+                            uint32_t *result,
+                            uint32_t *result_index_count) {
+    memcpy(result, indices, sizeof(uint32_t) * index_count);
+    uint32_t current_index_count = index_count;
+
+    glm::vec3 *vertex_positions = (glm::vec3*) malloc(sizeof(glm::vec3) * vertex_count);
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        vertex_positions[i] = get_position(positions, position_stride, i);
+    }
+
+    // Lock the borders & the attribute seams
+    bool *is_locked = (bool*) calloc(vertex_count, sizeof(bool));
+    {
+        sKeyCounter edges = {};
+        edges.init(index_count);
+        for(uint32_t i = 0u; i < index_count; i += 3u) {
+            edges.add(get_edge_key(result[i], result[i + 1u]));
+            edges.add(get_edge_key(result[i + 1u], result[i + 2u]));
+            edges.add(get_edge_key(result[i + 2u], result[i]));
+        }
+        for(uint32_t i = 0u; i < index_count; i += 3u) {
+            for(uint32_t k = 0u; k < 3u; k++) {
+                const uint32_t a = result[i + k], b = result[i + (k + 1u) % 3u];
+                if (edges.get_count(get_edge_key(a, b)) == 1u) {
+                    is_locked[a] = true;
+                    is_locked[b] = true;
+                }
+            }
+        }
+        edges.clean();
+
+        sKeyCounter vertex_positions_set = {};
+        vertex_positions_set.init(vertex_count);
+        for(uint32_t i = 0u; i < vertex_count; i++) {
+            vertex_positions_set.add(get_position_key(vertex_positions[i]));
+        }
+        for(uint32_t i = 0u; i < vertex_count; i++) {
+            is_locked[i] |= vertex_positions_set.get_count(get_position_key(vertex_positions[i])) > 1u;
+        }
+        vertex_positions_set.clean();
+    }
+
+    sQuadric *quadrics = (sQuadric*) calloc(vertex_count, sizeof(sQuadric));
+    for(uint32_t i = 0u; i < index_count; i += 3u) {
+        const glm::vec3 p0 = vertex_positions[result[i]];
+        const glm::vec3 normal = glm::cross(vertex_positions[result[i + 1u]] - p0, vertex_positions[result[i + 2u]] - p0);
+        const float area = glm::length(normal);
+        if (area <= 0.0f) {
+            continue;
+        }
+
+        const glm::vec3 unit_normal = normal / area;
+        for(uint32_t k = 0u; k < 3u; k++) {
+            quadrics[result[i + k]].add_plane(unit_normal, -glm::dot(unit_normal, p0), area);
+        }
+    }
+
+    uint32_t *adjacency_offsets = (uint32_t*) malloc(sizeof(uint32_t) * (vertex_count + 1u));
+    uint32_t *adjacent_triangles = (uint32_t*) malloc(sizeof(uint32_t) * index_count);
+    uint32_t *remap = (uint32_t*) malloc(sizeof(uint32_t) * vertex_count);
+    bool *is_touched = (bool*) malloc(sizeof(bool) * vertex_count);
+    sCollapse *collapses = (sCollapse*) malloc(sizeof(sCollapse) * index_count * 2u);
+
+    float max_error = 0.0f;
+
+    for(uint32_t pass = 0u; pass < SIMPLIFY_MAX_PASSES && current_index_count > target_index_count; pass++) {
+        const uint32_t triangle_count = current_index_count / 3u;
+
+        // Vertex -> triangles of this pass
+        memset(adjacency_offsets, 0, sizeof(uint32_t) * (vertex_count + 1u));
+        for(uint32_t i = 0u; i < current_index_count; i++) {
+            adjacency_offsets[result[i] + 1u]++;
+        }
+        for(uint32_t i = 0u; i < vertex_count; i++) {
+            adjacency_offsets[i + 1u] += adjacency_offsets[i];
+        }
+        for(uint32_t i = 0u; i < current_index_count; i++) {
+            // Use the next slot of the vertex, and restore the offsets after
+            adjacent_triangles[adjacency_offsets[result[i]]++] = i / 3u;
+        }
+        for(uint32_t i = vertex_count; i > 0u; i--) {
+            adjacency_offsets[i] = adjacency_offsets[i - 1u];
+        }
+        adjacency_offsets[0u] = 0u;
+
+        // Every directed edge is a candidate, sorted by the error of the merged quadric on the target
+        uint32_t collapse_count = 0u;
+        for(uint32_t i = 0u; i < current_index_count; i++) {
+            const uint32_t from = result[i];
+            const uint32_t to = result[(i % 3u == 2u) ? i - 2u : i + 1u];
+            const uint32_t other_from = to, other_to = from;
+
+            if (!is_locked[from]) {
+                sQuadric merged = quadrics[from];
+                merged.add(quadrics[to]);
+                collapses[collapse_count++] = { from, to, merged.evaluate(vertex_positions[to]) };
+            }
+            if (!is_locked[other_from]) {
+                sQuadric merged = quadrics[other_from];
+                merged.add(quadrics[other_to]);
+                collapses[collapse_count++] = { other_from, other_to, merged.evaluate(vertex_positions[other_to]) };
+            }
+        }
+
+        if (collapse_count == 0u) {
+            break;
+        }
+
+        std::sort(  collapses,
+                    collapses + collapse_count,
+                    [](const sCollapse &a, const sCollapse &b) { return a.cost < b.cost; });
+
+        for(uint32_t i = 0u; i < vertex_count; i++) {
+            remap[i] = i;
+        }
+        memset(is_touched, 0, sizeof(bool) * vertex_count);
+
+        // The removed triangles on this pass
+        const uint32_t triangles_to_remove = (current_index_count - target_index_count) / 3u;
+        uint32_t removed_triangles = 0u;
+        uint32_t applied_collapses = 0u;
+
+        for(uint32_t c = 0u; c < collapse_count && removed_triangles < triangles_to_remove; c++) {
+            const sCollapse &collapse = collapses[c];
+            if (is_touched[collapse.from] || is_touched[collapse.to]) {
+                continue;
+            }
+
+            if (!collapse_keeps_orientation(result, adjacency_offsets, adjacent_triangles, vertex_positions, collapse.from, collapse.to)) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            applied_collapses++;
+
+            // Freeze the neighbourhood, so the orientation checks of this pass stay valid
+            for(uint32_t j = adjacency_offsets[collapse.from]; j < adjacency_offsets[collapse.from + 1u]; j++) {
+                const uint32_t *triangle = &result[adjacent_triangles[j] * 3u];
+                is_touched[triangle[0u]] = true;
+                is_touched[triangle[1u]] = true;
+                is_touched[triangle[2u]] = true;
+
+                removed_triangles += (triangle[0u] == collapse.to || triangle[1u] == collapse.to || triangle[2u] == collapse.to) ? 1u : 0u;
+            }
+
+            const float weight = quadrics[collapse.to].weight;
+            const float error = (weight > 0.0f) ? sqrtf(collapse.cost / weight) : 0.0f;
+            max_error = (error > max_error) ? error : max_error;
+        }
+
+        if (applied_collapses == 0u) {
+            break;
+        }
+
+        // Apply the collapses & remove the degenerated triangles
+        uint32_t new_index_count = 0u;
+        for(uint32_t i = 0u; i < triangle_count; i++) {
+            const uint32_t a = remap[result[i * 3u]];
+            const uint32_t b = remap[result[i * 3u + 1u]];
+            const uint32_t c = remap[result[i * 3u + 2u]];
+
+            if (a != b && b != c && a != c) {
+                result[new_index_count++] = a;
+                result[new_index_count++] = b;
+                result[new_index_count++] = c;
+            }
+        }
+        current_index_count = new_index_count;
+    }
+
+    free(collapses);
+    free(is_touched);
+    free(remap);
+    free(adjacent_triangles);
+    free(adjacency_offsets);
+    free(quadrics);
+    free(is_locked);
+    free(vertex_positions);
+
+    *result_index_count = current_index_count;
+    return max_error;
+}
\ No newline at end of file
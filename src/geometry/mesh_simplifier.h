@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Geometry {
+
+    /**
+    * Quadric error edge collapse, moving vertices onto existing ones, so the result
+    * only has new indices and reuses the mesh vertices.
+    * Open borders and vertices split on attribute seams (same position, different vertex)
+    * are locked, so the silhouette and the UVs do not tear.
+    * result needs room for index_count indices.
+    * Returns the error of the result on mesh units (aproximated distance to the original surface).
+    */
+    float simplify( const uint32_t *indices,
+                    const uint32_t index_count,
+                    const uint8_t *positions,
+                    const uint32_t position_stride,
+                    const uint32_t vertex_count,
+                    const uint32_t target_index_count,
+                    uint32_t *result,
+                    uint32_t *result_index_count);
+};
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "meshlet_builder.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static inline glm::vec3 get_position(const uint8_t *positions, const uint32_t stride, const uint32_t idx) {
+    glm::vec3 position;
+    memcpy(&position, positions + (uint64_t) idx * stride, sizeof(glm::vec3));
+    return position;
+}
+
+static void compute_meshlet_bounds( const uint32_t *indices,
+                                    const uint8_t *positions,
+                                    const uint32_t position_stride,
+                                    const uint32_t *meshlet_vertices,
+                                    const uint32_t meshlet_vertex_count,
+                                    Geometry::sMeshlet *meshlet) {
+    // Sphere around the AABB center, loose but cheap
+    glm::vec3 aabb_min = get_position(positions, position_stride, meshlet_vertices[0u]);
+    glm::vec3 aabb_max = aabb_min;
+    for(uint32_t i = 1u; i < meshlet_vertex_count; i++) {
+        const glm::vec3 position = get_position(positions, position_stride, meshlet_vertices[i]);
+        aabb_min = glm::min(aabb_min, position);
+        aabb_max = glm::max(aabb_max, position);
+    }
+
+    meshlet->center = (aabb_min + aabb_max) * 0.5f;
+    meshlet->radius = 0.0f;
+    for(uint32_t i = 0u; i < meshlet_vertex_count; i++) {
+        const float distance = glm::length(get_position(positions, position_stride, meshlet_vertices[i]) - meshlet->center);
+        meshlet->radius = (distance > meshlet->radius) ? distance : meshlet->radius;
+    }
+
+    // Normal cone, around the area weighted normal
+    const uint32_t *triangles = &indices[meshlet->first_index];
+    glm::vec3 axis = {0.0f, 0.0f, 0.0f};
+    for(uint32_t i = 0u; i < meshlet->triangle_count; i++) {
+        const glm::vec3 p0 = get_position(positions, position_stride, triangles[i * 3u]);
+        const glm::vec3 p1 = get_position(positions, position_stride, triangles[i * 3u + 1u]);
+        const glm::vec3 p2 = get_position(positions, position_stride, triangles[i * 3u + 2u]);
+        axis += glm::cross(p1 - p0, p2 - p0);
+    }
+
+    const float axis_length = glm::length(axis);
+    if (axis_length <= 0.0f) {
+        meshlet->cone_axis = {0.0f, 0.0f, 1.0f};
+        meshlet->cone_cutoff = 1.0f;
+        return;
+    }
+    meshlet->cone_axis = axis / axis_length;
+
+    float min_dot = 1.0f;
+    for(uint32_t i = 0u; i < meshlet->triangle_count; i++) {
+        const glm::vec3 p0 = get_position(positions, position_stride, triangles[i * 3u]);
+        const glm::vec3 p1 = get_position(positions, position_stride, triangles[i * 3u + 1u]);
+        const glm::vec3 p2 = get_position(positions, position_stride, triangles[i * 3u + 2u]);
+        const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const float normal_length = glm::length(normal);
+
+        if (normal_length > 0.0f) {
+            const float cone_dot = glm::dot(meshlet->cone_axis, normal / normal_length);
+            min_dot = (cone_dot < min_dot) ? cone_dot : min_dot;
+        }
+    }
+
+    // Almost a half sphere of normals, there is no view where all of them are back facing
+    // Stored as the sine of the spread angle, for the culling test
+    meshlet->cone_cutoff = (min_dot <= 0.1f) ? 1.0f : sqrtf(1.0f - min_dot * min_dot);
+}
+
+uint32_t Geometry::build_meshlets(  const uint32_t *indices,
+                                    const uint32_t index_count,
+                                    const uint8_t *positions,
+                                    const uint32_t position_stride,
+                                    const uint32_t vertex_count,
+                                    sDynamicArray<sMeshlet> *result) {
+    const uint32_t triangle_count = index_count / 3u;
+    if (triangle_count == 0u) {
+        return 0u;
+    }
+
+    // Id of the last meshlet that used each vertex
+    uint32_t *vertex_meshlet = (uint32_t*) malloc(sizeof(uint32_t) * vertex_count);
+    memset(vertex_meshlet, 0xff, sizeof(uint32_t) * vertex_count);
+
+    uint32_t meshlet_vertices[MESHLET_MAX_VERTICES];
+    uint32_t meshlet_vertex_count = 0u;
+
+    uint32_t meshlet_count = 0u;
+    sMeshlet current = { .first_index = 0u, .triangle_count = 0u };
+
+    for(uint32_t i = 0u; i < triangle_count; i++) {
+        const uint32_t *triangle = &indices[i * 3u];
+
+        uint32_t new_vertex_count = 0u;
+        for(uint32_t k = 0u; k < 3u; k++) {
+            const bool is_repeated = (k > 0u && triangle[k] == triangle[0u]) || (k > 1u && triangle[k] == triangle[1u]);
+            new_vertex_count += (vertex_meshlet[triangle[k]] != meshlet_count && !is_repeated) ? 1u : 0u;
+        }
+
+        if (meshlet_vertex_count + new_vertex_count > MESHLET_MAX_VERTICES || current.triangle_count == MESHLET_MAX_TRIANGLES) {
+            compute_meshlet_bounds(indices, positions, position_stride, meshlet_vertices, meshlet_vertex_count, &current);
+            result->push(current);
+
+            meshlet_count++;
+            meshlet_vertex_count = 0u;
+            current = { .first_index = i * 3u, .triangle_count = 0u };
+        }
+
+        for(uint32_t k = 0u; k < 3u; k++) {
+            if (vertex_meshlet[triangle[k]] != meshlet_count) {
+                vertex_meshlet[triangle[k]] = meshlet_count;
+                meshlet_vertices[meshlet_vertex_count++] = triangle[k];
+            }
+        }
+        current.triangle_count++;
+    }
+
+    compute_meshlet_bounds(indices, positions, position_stride, meshlet_vertices, meshlet_vertex_count, &current);
+    result->push(current);
+    meshlet_count++;
+
+    free(vertex_meshlet);
+
+    return meshlet_count;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "../utils/dynamic_array.h"
+
+#define MESHLET_MAX_VERTICES 64u
+#define MESHLET_MAX_TRIANGLES 124u
+
+namespace Geometry {
+
+    // Same layout as the GPU side (std430), so it is uploaded as is
+    struct sMeshlet {
+        // Bounding sphere, on the mesh's space
+        glm::vec3   center;
+        float       radius;
+        // Normal cone, cutoff of 1.0 when the triangles are too spread to be culled
+        glm::vec3   cone_axis;
+        float       cone_cutoff;
+        // Triangles of the meshlet, as a range of the mesh's index list
+        uint32_t    first_index;
+        uint32_t    triangle_count;
+        uint32_t    pad0;
+        uint32_t    pad1;
+    };
+
+    /**
+    * Splits the mesh index list on consecutive runs of triangles that fit the meshlet limits,
+    * so the index data is not duplicated. Run it after the vertex cache optimization,
+    * that order keeps the triangles of a run close together.
+    * Returns the number of meshlets added to the result.
+    */
+    uint32_t build_meshlets(const uint32_t *indices,
+                            const uint32_t index_count,
+                            const uint8_t *positions,
+                            const uint32_t position_stride,
+                            const uint32_t vertex_count,
+                            sDynamicArray<sMeshlet> *result);
+};
\ No newline at end of file
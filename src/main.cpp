@@ -19,6 +19,7 @@
 #include "render/vk_helpers.h"
 
 #include "resource_manager.h"
+#include "utils/job_system.h"
 
 int main() {
     spdlog::info("Initalizing render");
@@ -36,6 +37,8 @@ int main() {
     renderer.scene_global_data.view = camera.view_mat;
     renderer.scene_global_data.proj = camera.proj_mat;
     renderer.scene_global_data.view_proj = camera.view_proj_mat;
+    renderer.scene_global_data.camera_position = glm::vec4(camera.position, 1.0f);
+    camera.get_frustum_planes(renderer.scene_global_data.frustum_planes);
 
     spdlog::info("Starting the render loop");
     while(!glfwWindowShouldClose(renderer.gpu_instance.window)) {
@@ -52,5 +55,7 @@ int main() {
     spdlog::info("Cleaning the render");
     renderer.clean();
 
+    sJobSystem::get().clean();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "baked_mesh.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#include "mesh_parser.h"
+#include "../geometry/meshlet_builder.h"
+#include "../render/resources/gpu_mesh.h"
+#include "../utils/mapped_file.h"
+
+// Parent & mesh indices, and the local TRS
+#define BAKED_NODE_SIZE (sizeof(uint32_t) * 2u + sizeof(glm::vec3) * 2u + sizeof(glm::quat))
+
+static inline uint64_t align_offset(const uint64_t offset) {
+    return (offset + BAKED_MESH_DATA_ALIGNMENT - 1u) & ~((uint64_t) BAKED_MESH_DATA_ALIGNMENT - 1u);
+}
+
+// count elements of element_size from offset are inside the file, without overflowing on corrupt values
+static inline bool is_range_in_file(const uint64_t offset, const uint64_t count, const uint64_t element_size, const uint64_t file_size) {
+    return offset <= file_size && 
+            (offset % sizeof(uint32_t)) == 0u &&
+            count <= (file_size - offset) / element_size;
+}
+
+// Every offset, count & index of the bake is checked before the import view points to it
+static bool is_baked_data_valid(const uint8_t *data, const uint64_t size) {
+    const Parsers::sBakedMeshHeader *header = (const Parsers::sBakedMeshHeader*) data;
+
+    if (!is_range_in_file(sizeof(Parsers::sBakedMeshHeader), header->mesh_count, sizeof(Parsers::sBakedMeshEntry), size) ||
+        !is_range_in_file(header->source_remap_offset, header->source_mesh_count, sizeof(uint32_t), size) ||
+        !is_range_in_file(header->vertex_data_offset, header->total_vertex_count, sizeof(Render::sVertex), size) ||
+        !is_range_in_file(header->index_data_offset, header->total_index_count, sizeof(uint32_t), size) ||
+        !is_range_in_file(header->meshlet_data_offset, header->total_meshlet_count, sizeof(Geometry::sMeshlet), size) ||
+        !is_range_in_file(header->node_data_offset, header->node_count, BAKED_NODE_SIZE, size)) {
+        return false;
+    }
+
+    const Parsers::sBakedMeshEntry *mesh_table = (const Parsers::sBakedMeshEntry*) (data + sizeof(Parsers::sBakedMeshHeader));
+    for(uint32_t i = 0u; i < header->mesh_count; i++) {
+        const Parsers::sBakedMeshEntry &entry = mesh_table[i];
+        if ((uint64_t) entry.first_index + entry.index_count > header->total_index_count ||
+            (uint64_t) entry.first_vertex + entry.vertex_count > header->total_vertex_count ||
+            (uint64_t) entry.first_meshlet + entry.meshlet_count > header->total_meshlet_count ||
+            entry.lod_count == 0u || entry.lod_count > MESH_MAX_LODS) {
+            return false;
+        }
+
+        // The LOD ranges are relative to the mesh
+        for(uint32_t j = 0u; j < entry.lod_count; j++) {
+            const Render::sMeshLOD &lod = entry.lods[j];
+            if ((uint64_t) lod.first_index + lod.index_count > entry.index_count ||
+                (uint64_t) lod.first_meshlet + lod.meshlet_count > entry.meshlet_count) {
+                return false;
+            }
+        }
+    }
+
+    const uint32_t *source_remap = (const uint32_t*) (data + header->source_remap_offset);
+    for(uint32_t i = 0u; i < header->source_mesh_count; i++) {
+        if (source_remap[i] >= header->mesh_count) {
+            return false;
+        }
+    }
+
+    // Depth sorted, the transform hierarchy reads the parents before their children
+    const uint32_t *node_parents = (const uint32_t*) (data + header->node_data_offset);
+    for(uint32_t i = 0u; i < header->node_count; i++) {
+        if (node_parents[i] != TRANSFORM_ROOT && node_parents[i] >= i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Parsers::open_baked_meshes(const char* baked_file_dir,
+                                const uint64_t source_hash,
+                                sMeshImport *import) {
+    sMappedFile baked_file = {};
+    if (!baked_file.open(baked_file_dir)) {
+        return false;
+    }
+
+    if (baked_file.size < sizeof(sBakedMeshHeader)) {
+        baked_file.close();
+        return false;
+    }
+
+    const sBakedMeshHeader *header = (const sBakedMeshHeader*) baked_file.data;
+
+    if (header->magic != BAKED_MESH_MAGIC ||
+        header->version != BAKED_MESH_VERSION ||
+        header->vertex_size != sizeof(Render::sVertex) ||
+        header->source_hash != source_hash) {
+        spdlog::info("Discarding outdated baked mesh {}", baked_file_dir);
+        baked_file.close();
+        return false;
+    }
+
+    // Truncated or corrupt: the source is imported again, and the bake rewritten
+    if (!is_baked_data_valid(baked_file.data, baked_file.size)) {
+        spdlog::warn("Discarding corrupt baked mesh {}", baked_file_dir);
+        baked_file.close();
+        return false;
+    }
+
+    const sBakedMeshEntry *mesh_table = (const sBakedMeshEntry*) (baked_file.data + sizeof(sBakedMeshHeader));
+
+    // Import view of the mapped data, so the upload is the same as for a fresh import
+    // Straight from the mapped pages to the staging ring
+    *import = {
+        .mesh_count = header->mesh_count,
+        .total_index_count = header->total_index_count,
+        .total_vertex_count = header->total_vertex_count,
+        .indices = (uint32_t*) (baked_file.data + header->index_data_offset),
+        .vertices = (Render::sVertex*) (baked_file.data + header->vertex_data_offset),
+        .source_mesh_count = header->source_mesh_count,
+        .source_mesh_remap = (uint32_t*) (baked_file.data + header->source_remap_offset),
+        .total_meshlet_count = header->total_meshlet_count,
+        .meshlets = (Geometry::sMeshlet*) (baked_file.data + header->meshlet_data_offset),
+        .node_count = header->node_count,
+        .baked_file = baked_file
+    };
+
+    import->node_parents = (uint32_t*) (baked_file.data + header->node_data_offset);
+    import->node_meshes = import->node_parents + header->node_count;
+    import->node_positions = (glm::vec3*) (import->node_meshes + header->node_count);
+    import->node_rotations = (glm::quat*) (import->node_positions + header->node_count);
+    import->node_scales = (glm::vec3*) (import->node_rotations + header->node_count);
+
+    import->mesh_first_index = (uint32_t*) malloc(sizeof(uint32_t) * header->mesh_count * 7u);
+    import->mesh_index_count = import->mesh_first_index + header->mesh_count;
+    import->mesh_first_vertex = import->mesh_index_count + header->mesh_count;
+    import->mesh_vertex_count = import->mesh_first_vertex + header->mesh_count;
+    import->mesh_first_meshlet = import->mesh_vertex_count + header->mesh_count;
+    import->mesh_meshlet_count = import->mesh_first_meshlet + header->mesh_count;
+    import->mesh_lod_count = import->mesh_meshlet_count + header->mesh_count;
+    import->mesh_lods = (Render::sMeshLOD*) malloc(sizeof(Render::sMeshLOD) * header->mesh_count * MESH_MAX_LODS);
+
+    for(uint32_t i = 0u; i < header->mesh_count; i++) {
+        const sBakedMeshEntry &entry = mesh_table[i];
+        import->mesh_first_index[i] = entry.first_index;
+        import->mesh_index_count[i] = entry.index_count;
+        import->mesh_first_vertex[i] = entry.first_vertex;
+        import->mesh_vertex_count[i] = entry.vertex_count;
+        import->mesh_first_meshlet[i] = entry.first_meshlet;
+        import->mesh_meshlet_count[i] = entry.meshlet_count;
+        import->mesh_lod_count[i] = entry.lod_count;
+        memcpy(&import->mesh_lods[i * MESH_MAX_LODS], entry.lods, sizeof(entry.lods));
+    }
+
+    return true;
+}
+
+bool Parsers::bake_meshes(  const char* baked_file_dir,
+                            const uint64_t source_hash,
+                            const sMeshImport &import) {
+    FILE *baked_file = fopen(baked_file_dir, "wb");
+    if (baked_file == nullptr) {
+        spdlog::warn("Could not create the baked mesh {}", baked_file_dir);
+        return false;
+    }
+
+    const uint64_t table_end = sizeof(sBakedMeshHeader) + sizeof(sBakedMeshEntry) * import.mesh_count;
+
+    sBakedMeshHeader header = {
+        .magic = BAKED_MESH_MAGIC,
+        .version = BAKED_MESH_VERSION,
+        .source_hash = source_hash,
+        .vertex_size = sizeof(Render::sVertex),
+        .mesh_count = import.mesh_count,
+        .total_vertex_count = import.total_vertex_count,
+        .total_index_count = import.total_index_count,
+        .total_meshlet_count = import.total_meshlet_count,
+        .source_mesh_count = import.source_mesh_count,
+        .source_remap_offset = table_end,
+    };
+    const uint64_t remap_end = table_end + sizeof(uint32_t) * import.source_mesh_count;
+    header.vertex_data_offset = align_offset(remap_end);
+    header.index_data_offset = align_offset(header.vertex_data_offset + sizeof(Render::sVertex) * import.total_vertex_count);
+    header.meshlet_data_offset = align_offset(header.index_data_offset + sizeof(uint32_t) * import.total_index_count);
+    header.node_count = import.node_count;
+    header.node_data_offset = align_offset(header.meshlet_data_offset + sizeof(Geometry::sMeshlet) * import.total_meshlet_count);
+
+    const uint8_t padding[BAKED_MESH_DATA_ALIGNMENT] = {};
+
+    fwrite(&header, sizeof(sBakedMeshHeader), 1u, baked_file);
+
+    for(uint32_t i = 0u; i < import.mesh_count; i++) {
+        sBakedMeshEntry entry = {
+            .first_index = import.mesh_first_index[i],
+            .index_count = import.mesh_index_count[i],
+            .first_vertex = import.mesh_first_vertex[i],
+            .vertex_count = import.mesh_vertex_count[i],
+            .first_meshlet = import.mesh_first_meshlet[i],
+            .meshlet_count = import.mesh_meshlet_count[i],
+            .lod_count = import.mesh_lod_count[i]
+        };
+        memcpy(entry.lods, &import.mesh_lods[i * MESH_MAX_LODS], sizeof(entry.lods));
+        fwrite(&entry, sizeof(sBakedMeshEntry), 1u, baked_file);
+    }
+
+    fwrite(import.source_mesh_remap, sizeof(uint32_t), import.source_mesh_count, baked_file);
+
+    fwrite(padding, header.vertex_data_offset - remap_end, 1u, baked_file);
+    fwrite(import.vertices, sizeof(Render::sVertex), import.total_vertex_count, baked_file);
+
+    const uint64_t vertex_end = header.vertex_data_offset + sizeof(Render::sVertex) * import.total_vertex_count;
+    fwrite(padding, header.index_data_offset - vertex_end, 1u, baked_file);
+    fwrite(import.indices, sizeof(uint32_t), import.total_index_count, baked_file);
+
+    const uint64_t index_end = header.index_data_offset + sizeof(uint32_t) * import.total_index_count;
+    fwrite(padding, header.meshlet_data_offset - index_end, 1u, baked_file);
+    fwrite(import.meshlets, sizeof(Geometry::sMeshlet), import.total_meshlet_count, baked_file);
+
+    const uint64_t meshlet_end = header.meshlet_data_offset + sizeof(Geometry::sMeshlet) * import.total_meshlet_count;
+    fwrite(padding, header.node_data_offset - meshlet_end, 1u, baked_file);
+    fwrite(import.node_parents, sizeof(uint32_t), import.node_count, baked_file);
+    fwrite(import.node_meshes, sizeof(uint32_t), import.node_count, baked_file);
+    fwrite(import.node_positions, sizeof(glm::vec3), import.node_count, baked_file);
+    fwrite(import.node_rotations, sizeof(glm::quat), import.node_count, baked_file);
+    fwrite(import.node_scales, sizeof(glm::vec3), import.node_count, baked_file);
+
+    const bool write_success = ferror(baked_file) == 0;
+    fclose(baked_file);
+
+    if (!write_success) {
+        spdlog::warn("Error writing the baked mesh {}", baked_file_dir);
+        remove(baked_file_dir);
+    }
+
+    return write_success;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../render/resources/gpu_mesh.h"
+
+#define BAKED_MESH_MAGIC 0x48534d42u // "BMSH"
+#define BAKED_MESH_VERSION 6u
+#define BAKED_MESH_EXTENSION ".bmesh"
+// Start of the vertex & index blocks
+#define BAKED_MESH_DATA_ALIGNMENT 16u
+
+namespace Parsers {
+    struct sMeshImport;
+
+    /**
+    * Baked meshes: the import result stored as is, so loading is a mmap plus
+    * a copy to the staging ring per mesh.
+    * Layout: header | mesh table | source mesh remap | vertices (sVertex) | indices (uint32_t, relative to the mesh) | meshlets | nodes
+    * The nodes are stored as the import's arrays: parents | meshes | positions | rotations | scales
+    * Only the deduplicated meshes are stored, the remap table has the mesh of each source mesh
+    * The header keeps the hash of the source file, if it does not match the bake is discarded.
+    */
+    struct sBakedMeshHeader {
+        uint32_t    magic;
+        uint32_t    version;
+        uint64_t    source_hash;
+        uint32_t    vertex_size;
+        uint32_t    mesh_count;
+        uint32_t    total_vertex_count;
+        uint32_t    total_index_count;
+        uint32_t    total_meshlet_count;
+        uint32_t    source_mesh_count;
+        uint64_t    source_remap_offset;
+        uint64_t    vertex_data_offset;
+        uint64_t    index_data_offset;
+        uint64_t    meshlet_data_offset;
+        uint32_t    node_count;
+        uint64_t    node_data_offset;
+    };
+
+    struct sBakedMeshEntry {
+        uint32_t    first_index;
+        uint32_t    index_count;
+        uint32_t    first_vertex;
+        uint32_t    vertex_count;
+        uint32_t    first_meshlet;
+        uint32_t    meshlet_count;
+        uint32_t            lod_count;
+        Render::sMeshLOD    lods[MESH_MAX_LODS];
+    };
+
+    // Import view of the mapped bake, released with sMeshImport::clean
+    // Returns false if there is no valid bake for the source hash
+    bool open_baked_meshes( const char* baked_file_dir,
+                            const uint64_t source_hash,
+                            sMeshImport *import);
+
+    bool bake_meshes(   const char* baked_file_dir,
+                        const uint64_t source_hash,
+                        const sMeshImport &import);
+};
\ No newline at end of file
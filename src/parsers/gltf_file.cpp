@@ -0,0 +1,65 @@
+#include "gltf_file.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+
+Parsers::sGltfFile* Parsers::open_gltf_file(const char* file_dir, const char* directory, const bool load_external_buffers) {
+    auto gltf_file = fastgltf::MappedGltfFile::FromPath(file_dir);
+    if (gltf_file.error() != fastgltf::Error::None) {
+        spdlog::error("Could not open the glTF file {}", file_dir);
+        return nullptr;
+    }
+
+    // Every extension any of the imports reads
+    fastgltf::Parser parser(fastgltf::Extensions::KHR_texture_basisu);
+    const fastgltf::Options options = (load_external_buffers) ? fastgltf::Options::LoadExternalBuffers | fastgltf::Options::GenerateMeshIndices
+                                                              : fastgltf::Options::GenerateMeshIndices;
+    auto load_result = parser.loadGltf(gltf_file.get(), directory, options);
+    if (load_result.error() != fastgltf::Error::None) {
+        spdlog::error("Could not parse the glTF file {}: {}", file_dir, fastgltf::getErrorMessage(load_result.error()));
+        return nullptr;
+    }
+
+    sGltfFile *file = new sGltfFile();
+    file->asset = std::move(load_result.get());
+    file->file_dir = strdup(file_dir);
+    file->directory = strdup(directory);
+
+    return file;
+}
+
+bool Parsers::has_unloaded_buffers(const sGltfFile &file) {
+    for(const fastgltf::Buffer &buffer : file.asset.buffers) {
+        if (std::holds_alternative<fastgltf::sources::URI>(buffer.data)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Parsers::acquire_gltf_file(sGltfFile *file) {
+    file->reference_count.fetch_add(1u);
+}
+
+void Parsers::release_gltf_file(sGltfFile *file) {
+    if (file->reference_count.fetch_sub(1u) != 1u) {
+        return;
+    }
+
+    free(file->file_dir);
+    free(file->directory);
+    delete file;
+}
+
+bool Parsers::get_gltf_uri_path(const sGltfFile &file, const fastgltf::URI &uri, char *path, const uint32_t path_size) {
+    if (!uri.isLocalPath()) {
+        return false;
+    }
+
+    const std::filesystem::path uri_path = std::filesystem::path(file.directory) / uri.fspath();
+    snprintf(path, path_size, "%s", uri_path.string().c_str());
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <fastgltf/core.hpp>
+
+namespace Parsers {
+    /**
+    * glTF parsed once (images left as sources), shared by the texture & mesh imports of the file.
+    * The JSON only parse keeps the external buffers as URIs (the GLB chunk is always there, from the mapped file):
+    * enough for the bake key & the textures, the mesh import only loads them when its bake is outdated.
+    * Reference counted: the imports on the workers keep it alive until they are done, the last release frees it.
+    */
+    struct sGltfFile {
+        fastgltf::Asset         asset;
+        char                    *file_dir = nullptr;
+        char                    *directory = nullptr;
+        std::atomic<uint32_t>   reference_count = 1u;
+    };
+
+    // With a reference for the caller, nullptr if the file could not be parsed
+    sGltfFile* open_gltf_file(const char* file_dir, const char* directory, const bool load_external_buffers = false);
+
+    // True if a buffer is still a URI to load
+    bool has_unloaded_buffers(const sGltfFile &file);
+    void acquire_gltf_file(sGltfFile *file);
+    void release_gltf_file(sGltfFile *file);
+
+    // Path of a local URI (percent-decoded), relative to the glTF's directory. False for remote URIs
+    bool get_gltf_uri_path(const sGltfFile &file, const fastgltf::URI &uri, char *path, const uint32_t path_size);
+};
\ No newline at end of file
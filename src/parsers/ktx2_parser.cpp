@@ -0,0 +1,223 @@
+#include "ktx2_parser.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+
+#ifdef TEXTURE_BASISU_TRANSCODING
+#include <basisu_transcoder.h>
+#endif
+
+#include "texture_loader.h"
+#include "../render/resources/resources.h"
+
+static const uint8_t KTX2_IDENTIFIER[KTX2_IDENTIFIER_SIZE] = { 0xABu, 'K', 'T', 'X', ' ', '2', '0', 0xBBu, '\r', '\n', 0x1Au, '\n' };
+
+// Formats that can be uploaded as they are stored
+static bool is_ktx2_native_format(const uint32_t vk_format) {
+    switch ((eImageFormats) vk_format) {
+        case IMG_FORMAT_RGBA_8BIT_UNORM:
+        case IMG_FORMAT_BRGA_8BIT_UNORM:
+        case IMG_FORMAT_RGBA_8BIT_SRGB:
+        case IMG_FORMAT_BRGA_8BIT_SRGB:
+        case IMG_FORMAT_R_16BIT_SFLOAT:
+        case IMG_FORMAT_R_32BIT_SFLOAT:
+        case IMG_FORMAT_RGBA_16BIT_SFLOAT:
+        case IMG_FORMAT_RGBA_32BIT_SFLOAT:
+        case IMG_FORMAT_BC1_RGBA_UNORM:
+        case IMG_FORMAT_BC3_RGBA_UNORM:
+        case IMG_FORMAT_BC5_RG_UNORM:
+        case IMG_FORMAT_BC7_RGBA_UNORM:
+        case IMG_FORMAT_BC1_RGBA_SRGB:
+        case IMG_FORMAT_BC3_RGBA_SRGB:
+        case IMG_FORMAT_BC7_RGBA_SRGB:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline VkExtent3D get_level_dims(const uint32_t width, const uint32_t height, const uint32_t level) {
+    return { glm::max(width >> level, 1u), glm::max(height >> level, 1u), 1u };
+}
+
+bool Parsers::is_ktx2(const uint8_t *data, const uint64_t size) {
+    return size >= sizeof(sKTX2Header) && memcmp(data, KTX2_IDENTIFIER, KTX2_IDENTIFIER_SIZE) == 0;
+}
+
+static bool decode_ktx2_native(     const uint8_t *data,
+                                    const uint64_t size,
+                                    const Parsers::sKTX2Header &header,
+                                    const Parsers::sTranscodeFormats &transcode_formats,
+                                    Parsers::sDecodedTexture *result) {
+    const eImageFormats format = (eImageFormats) header.vk_format;
+    if (!is_ktx2_native_format(header.vk_format)) {
+        spdlog::error("Unsupported KTX2 format {}", header.vk_format);
+        return false;
+    }
+
+    if (is_block_compressed(format) && !transcode_formats.supports_bc) {
+        spdlog::error("KTX2 texture on a BC format, not supported by the device");
+        return false;
+    }
+
+    if (header.supercompression_scheme != KTX2_SUPERCOMPRESSION_NONE) {
+        spdlog::error("Unsupported KTX2 supercompression {}", header.supercompression_scheme);
+        return false;
+    }
+
+    // No levels stored: the chain is generated on upload, if the format can be filtered
+    const uint32_t level_count = glm::max(header.level_count, 1u);
+    const Parsers::sKTX2LevelIndex *level_index = (const Parsers::sKTX2LevelIndex*) (data + sizeof(Parsers::sKTX2Header));
+    if (sizeof(Parsers::sKTX2Header) + sizeof(Parsers::sKTX2LevelIndex) * level_count > size) {
+        return false;
+    }
+
+    uint64_t total_size = 0u;
+    for(uint32_t level = 0u; level < level_count; level++) {
+        const uint64_t level_size = get_image_data_size(format, get_level_dims(header.pixel_width, header.pixel_height, level));
+        if (level_index[level].byte_length != level_size ||
+            level_index[level].byte_offset + level_size > size) {
+            spdlog::error("Corrupted KTX2 level {}", level);
+            return false;
+        }
+        total_size += level_size;
+    }
+
+    result->pixels = (uint8_t*) malloc(total_size);
+    uint64_t dst_offset = 0u;
+    for(uint32_t level = 0u; level < level_count; level++) {
+        memcpy(result->pixels + dst_offset, data + level_index[level].byte_offset, level_index[level].byte_length);
+        dst_offset += level_index[level].byte_length;
+    }
+
+    result->format = format;
+    result->width = header.pixel_width;
+    result->height = header.pixel_height;
+    result->level_count = level_count;
+    result->generate_mips = header.level_count == 0u && !is_block_compressed(format);
+    result->data_size = total_size;
+
+    return true;
+}
+
+#ifdef TEXTURE_BASISU_TRANSCODING
+// Same bits, decoded to linear by the sampler. BC5 has no sRGB variant
+static eImageFormats get_srgb_format(const eImageFormats format) {
+    switch (format) {
+        case IMG_FORMAT_RGBA_8BIT_UNORM:
+            return IMG_FORMAT_RGBA_8BIT_SRGB;
+        case IMG_FORMAT_BC1_RGBA_UNORM:
+            return IMG_FORMAT_BC1_RGBA_SRGB;
+        case IMG_FORMAT_BC3_RGBA_UNORM:
+            return IMG_FORMAT_BC3_RGBA_SRGB;
+        case IMG_FORMAT_BC7_RGBA_UNORM:
+            return IMG_FORMAT_BC7_RGBA_SRGB;
+        default:
+            return format;
+    }
+}
+
+static basist::transcoder_texture_format get_basis_format(const eImageFormats format) {
+    switch (format) {
+        case IMG_FORMAT_BC1_RGBA_UNORM:
+        case IMG_FORMAT_BC1_RGBA_SRGB:
+            return basist::transcoder_texture_format::cTFBC1_RGB;
+        case IMG_FORMAT_BC3_RGBA_UNORM:
+        case IMG_FORMAT_BC3_RGBA_SRGB:
+            return basist::transcoder_texture_format::cTFBC3_RGBA;
+        case IMG_FORMAT_BC5_RG_UNORM:
+            return basist::transcoder_texture_format::cTFBC5_RG;
+        case IMG_FORMAT_BC7_RGBA_UNORM:
+        case IMG_FORMAT_BC7_RGBA_SRGB:
+            return basist::transcoder_texture_format::cTFBC7_RGBA;
+        default:
+            return basist::transcoder_texture_format::cTFRGBA32;
+    }
+}
+
+static bool decode_ktx2_basis(  const uint8_t *data,
+                                const uint64_t size,
+                                const Parsers::sTranscodeFormats &transcode_formats,
+                                const bool is_normal_map,
+                                Parsers::sDecodedTexture *result) {
+    basist::ktx2_transcoder transcoder;
+    if (!transcoder.init(data, (uint32_t) size) || !transcoder.start_transcoding()) {
+        spdlog::error("Could not start the Basis Universal transcoding");
+        return false;
+    }
+
+    eImageFormats format = (transcoder.get_has_alpha()) ? transcode_formats.color_alpha : transcode_formats.color;
+    if (is_normal_map) {
+        format = transcode_formats.normal;
+    } else if (transcoder.get_dfd_transfer_func() == basist::KTX2_KHR_DF_TRANSFER_SRGB) {
+        // Color data encoded with the sRGB curve, as the base color & emissive textures
+        format = get_srgb_format(format);
+    }
+    const basist::transcoder_texture_format basis_format = get_basis_format(format);
+
+    const uint32_t width = transcoder.get_width();
+    const uint32_t height = transcoder.get_height();
+    const uint32_t level_count = glm::max(transcoder.get_levels(), 1u);
+
+    uint64_t total_size = 0u;
+    for(uint32_t level = 0u; level < level_count; level++) {
+        total_size += get_image_data_size(format, get_level_dims(width, height, level));
+    }
+
+    result->pixels = (uint8_t*) malloc(total_size);
+    uint64_t dst_offset = 0u;
+    for(uint32_t level = 0u; level < level_count; level++) {
+        const VkExtent3D level_dims = get_level_dims(width, height, level);
+        // The output size is in blocks for the block formats, in pixels for the rest
+        const uint32_t output_size = (is_block_compressed(format)) ? ((level_dims.width + 3u) / 4u) * ((level_dims.height + 3u) / 4u)
+                                                                    : level_dims.width * level_dims.height;
+
+        if (!transcoder.transcode_image_level(level, 0u, 0u, result->pixels + dst_offset, output_size, basis_format)) {
+            spdlog::error("Could not transcode the level {}", level);
+            free(result->pixels);
+            result->pixels = nullptr;
+            return false;
+        }
+        dst_offset += get_image_data_size(format, level_dims);
+    }
+
+    result->format = format;
+    result->width = width;
+    result->height = height;
+    result->level_count = level_count;
+    result->generate_mips = false;
+    result->data_size = total_size;
+
+    return true;
+}
+#endif
+
+bool Parsers::decode_ktx2( const uint8_t *data,
+                            const uint64_t size,
+                            const sTranscodeFormats &transcode_formats,
+                            const bool is_normal_map,
+                            sDecodedTexture *result) {
+    if (!is_ktx2(data, size)) {
+        return false;
+    }
+
+    const sKTX2Header *header = (const sKTX2Header*) data;
+    if (header->pixel_depth > 1u || header->layer_count > 1u || header->face_count != 1u) {
+        spdlog::error("Only 2D KTX2 textures are supported");
+        return false;
+    }
+
+    // Undefined format: Basis Universal payload
+    if (header->vk_format != VK_FORMAT_UNDEFINED) {
+        return decode_ktx2_native(data, size, *header, transcode_formats, result);
+    }
+
+#ifdef TEXTURE_BASISU_TRANSCODING
+    return decode_ktx2_basis(data, size, transcode_formats, is_normal_map, result);
+#else
+    spdlog::error("Basis Universal KTX2 texture, built without TEXTURE_BASISU_TRANSCODING");
+    return false;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../render/resources/image_formats.h"
+
+#define KTX2_IDENTIFIER_SIZE 12u
+#define KTX2_SUPERCOMPRESSION_NONE 0u
+#define KTX2_SUPERCOMPRESSION_BASISLZ 1u
+#define KTX2_SUPERCOMPRESSION_ZSTD 2u
+
+// Basis Universal (BasisLZ & UASTC) textures need the transcoder, built with TEXTURE_BASISU_TRANSCODING
+// Without it only the KTX2 files already on a GPU format are loaded
+
+namespace Parsers {
+    struct sDecodedTexture;
+
+    // Formats the Basis Universal textures are transcoded to, picked from the device support
+    // Their sRGB variant is used when the DFD transfer function of the texture is sRGB
+    struct sTranscodeFormats {
+        eImageFormats   color = IMG_FORMAT_RGBA_8BIT_UNORM;
+        eImageFormats   color_alpha = IMG_FORMAT_RGBA_8BIT_UNORM;
+        // Two channels, the shader rebuilds z
+        eImageFormats   normal = IMG_FORMAT_RGBA_8BIT_UNORM;
+        // The KTX2 files already on a BC format can only be loaded with device support
+        bool            supports_bc = false;
+    };
+
+    struct sKTX2Header {
+        uint8_t     identifier[KTX2_IDENTIFIER_SIZE];
+        uint32_t    vk_format;
+        uint32_t    type_size;
+        uint32_t    pixel_width;
+        uint32_t    pixel_height;
+        uint32_t    pixel_depth;
+        uint32_t    layer_count;
+        uint32_t    face_count;
+        uint32_t    level_count;
+        uint32_t    supercompression_scheme;
+        uint32_t    dfd_byte_offset;
+        uint32_t    dfd_byte_length;
+        uint32_t    kvd_byte_offset;
+        uint32_t    kvd_byte_length;
+        uint64_t    sgd_byte_offset;
+        uint64_t    sgd_byte_length;
+    };
+
+    // Right after the header, one per level, from the level 0
+    struct sKTX2LevelIndex {
+        uint64_t    byte_offset;
+        uint64_t    byte_length;
+        uint64_t    uncompressed_byte_length;
+    };
+
+    bool is_ktx2(const uint8_t *data, const uint64_t size);
+
+    // Only 2D textures, without layers nor faces. The levels are packed one after the other on the result pixels
+    bool decode_ktx2(   const uint8_t *data,
+                        const uint64_t size,
+                        const sTranscodeFormats &transcode_formats,
+                        const bool is_normal_map,
+                        sDecodedTexture *result);
+};
\ No newline at end of file
@@ -4,112 +4,941 @@
 #include "../render/resources/mesh.h"
 #include "../render/renderer.h"
 
+#include "../geometry/mesh_optimizer.h"
+#include "../geometry/meshlet_builder.h"
+#include "../geometry/mesh_simplifier.h"
+#include "../utils/job_system.h"
+#include "../utils/mapped_file.h"
+#include "../utils.h"
+#include "vertex_interleave.h"
+#include "baked_mesh.h"
+#include "gltf_file.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <spdlog/spdlog.h>
 #include <glm/glm.hpp>
 #include <fastgltf/core.hpp>
 #include <fastgltf/glm_element_traits.hpp>
 #include <fastgltf/tools.hpp>
 
+// Decodes every primitive with both paths after an import and logs the throughput
+#define MESH_DECODE_BENCHMARK false
+
+// Each LOD targets this fraction of the triangles of the previous one
+#define LOD_TARGET_RATIO 0.5f
+// The chain stops when a level cannot remove at least this fraction of the previous one
+#define LOD_MIN_REDUCTION 0.15f
+#define LOD_MIN_TRIANGLE_COUNT 32u
+
 const char* get_directory_of_file(const char* file_dir);
 
-// This only loads the meshes, do not care for the scene part of the GLTF
-uint32_t Parsers::gltf_to_mesh( const char* gltf_file_dir, 
-                                const char* gltf_directory, 
-                                Render::sGPUMesh meshes_to_fill[100u], 
-                                Render::sBackend *renderer, 
-                                Render::sFrame *frame_to_upload) {
-    uint32_t mesh_count = 0u;
+struct sPrimitiveDecode {
+    const fastgltf::Primitive *primitive;
+    uint32_t            first_index;
+    uint32_t            first_vertex;
+    // Offset of the primitive inside its mesh, for rebasing its indices
+    uint32_t            mesh_base_vertex;
+};
 
-    fastgltf::GltfDataBuffer data;
-    fastgltf::Parser parser(fastgltf::Extensions::None);
+void Parsers::sMeshImport::clean() {
+    // Views of a baked file: only the tables are owned, on a single block
+    if (baked_file.data != nullptr) {
+        free(mesh_first_index);
+        free(mesh_lods);
+        baked_file.close();
 
-    auto gltf_file = fastgltf::MappedGltfFile::FromPath(gltf_file_dir);
-    // ! gltf_file
+        *this = {};
+        return;
+    }
 
-    auto load_result = parser.loadGltf(gltf_file.get(), gltf_directory, fastgltf::Options::LoadExternalBuffers | fastgltf::Options::GenerateMeshIndices);
+    free(mesh_first_index);
+    free(mesh_index_count);
+    free(mesh_first_vertex);
+    free(mesh_vertex_count);
+    free(indices);
+    free(vertices);
+    free(source_mesh_remap);
+    free(mesh_lod_count);
+    free(mesh_lods);
+    free(mesh_first_meshlet);
+    free(mesh_meshlet_count);
+    free(meshlets);
+    free(node_parents);
 
-    // asset.error() != fastgltf::Error::None
+    *this = {};
+}
 
-    // !load
-    fastgltf::Asset &gltf = load_result.get();
+// Attribute by attribute decode through fastgltf, for the accessors the kernel cannot read
+static void decode_primitive_generic(   const fastgltf::Asset &gltf, 
+                                const sPrimitiveDecode &decode, 
+                                Parsers::sMeshImport *import) {
+    const fastgltf::Primitive &p = *decode.primitive;
+    uint32_t *indices = &import->indices[decode.first_index];
+    Render::sVertex *vertices = &import->vertices[decode.first_vertex];
+    const uint32_t base_vertex = decode.mesh_base_vertex;
+    const uint32_t vertex_count = (uint32_t) gltf.accessors[p.findAttribute("POSITION")->accessorIndex].count;
 
-    uint32_t total_index_buffer_size = 0u;
-    uint32_t *tmp_index_buffer = nullptr;
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        vertices[i] = {};
+    }
 
-    uint32_t total_vertex_buffer_size = 0u;
-    Render::sVertex *tmp_vertex_buffer = nullptr;
-    for(fastgltf::Mesh& mesh : gltf.meshes) {
-        // Our meshes are the gltf's primitives
-        uint32_t mesh_index_count = 0u;
-        uint32_t mesh_vertex_count = 0u;
+    fastgltf::iterateAccessorWithIndex<uint32_t>(gltf, gltf.accessors[p.indicesAccessor.value()],
+            [indices, base_vertex](uint32_t idx, size_t buffer_idx) {
+                indices[buffer_idx] = idx + base_vertex;
+            });
+
+    fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[p.findAttribute("POSITION")->accessorIndex],
+            [vertices](glm::vec3 pos, size_t buffer_idx) {
+                vertices[buffer_idx].position = pos;
+            });
+
+    const fastgltf::Attribute *normal = p.findAttribute("NORMAL");
+    if (normal != p.attributes.end()) {
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[normal->accessorIndex],
+                [vertices](glm::vec3 pos, size_t buffer_idx) {
+                    vertices[buffer_idx].normal = pos;
+                    vertices[buffer_idx].color = {pos.x, pos.y, pos.z, 1.0f};
+                });
+    }
+
+    const fastgltf::Attribute *tangent = p.findAttribute("TANGENT");
+    if (tangent != p.attributes.end()) {
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[tangent->accessorIndex],
+                [vertices](glm::vec3 tan, size_t buffer_idx) {
+                    vertices[buffer_idx].tangent = tan;
+                });
+    }
+
+    const fastgltf::Attribute *uv = p.findAttribute("TEXCOORD_0");
+    if (uv != p.attributes.end()) {
+        fastgltf::iterateAccessorWithIndex<glm::vec2>(gltf, gltf.accessors[uv->accessorIndex],
+                [vertices](glm::vec2 tex_coord, size_t buffer_idx) {
+                    vertices[buffer_idx].uv = tex_coord;
+                });
+    }
+
+    const fastgltf::Attribute *vertex_color = p.findAttribute("COLOR_0");
+    if (vertex_color != p.attributes.end()) {
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[vertex_color->accessorIndex],
+            [vertices](glm::vec3 color, size_t buffer_idx) {
+                vertices[buffer_idx].color = glm::vec4(color, 1.0f);
+            });
+    }
+}
+
+// The byte range starting at offset, of count elements stride bytes apart, fits on the buffer view (and it on its buffer)
+static bool is_view_range_in_bounds(const fastgltf::Asset &gltf, 
+                                    const size_t view_idx, 
+                                    const size_t offset, 
+                                    const size_t count, 
+                                    const size_t stride, 
+                                    const size_t element_size) {
+    if (view_idx >= gltf.bufferViews.size()) {
+        return false;
+    }
+
+    const fastgltf::BufferView &view = gltf.bufferViews[view_idx];
+    if (view.bufferIndex >= gltf.buffers.size() || view.byteOffset + view.byteLength > gltf.buffers[view.bufferIndex].byteLength) {
+        return false;
+    }
+
+    return count == 0u || offset + (count - 1u) * stride + element_size <= view.byteLength;
+}
+
+// Accessors that would read past the end of their buffer
+static bool is_accessor_in_bounds(const fastgltf::Asset &gltf, const size_t accessor_idx) {
+    if (accessor_idx >= gltf.accessors.size()) {
+        return false;
+    }
+
+    const fastgltf::Accessor &accessor = gltf.accessors[accessor_idx];
+    const size_t element_size = fastgltf::getElementByteSize(accessor.type, accessor.componentType);
+
+    // Without a view the elements are zeros, only the sparse values (if any) are read
+    if (accessor.bufferViewIndex.has_value()) {
+        const size_t view_idx = accessor.bufferViewIndex.value();
+        if (view_idx >= gltf.bufferViews.size()) {
+            return false;
+        }
+
+        const size_t stride = gltf.bufferViews[view_idx].byteStride.value_or(element_size);
+        if (!is_view_range_in_bounds(gltf, view_idx, accessor.byteOffset, accessor.count, stride, element_size)) {
+            return false;
+        }
+    }
+
+    if (accessor.sparse.has_value()) {
+        const fastgltf::SparseAccessor &sparse = accessor.sparse.value();
+        const size_t index_size = fastgltf::getElementByteSize(fastgltf::AccessorType::Scalar, sparse.indexComponentType);
+        if (sparse.count > accessor.count || 
+            !is_view_range_in_bounds(gltf, sparse.indicesBufferView, sparse.indicesByteOffset, sparse.count, index_size, index_size) ||
+            !is_view_range_in_bounds(gltf, sparse.valuesBufferView, sparse.valuesByteOffset, sparse.count, element_size, element_size)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool are_primitive_accessors_in_bounds(const fastgltf::Asset &gltf, const fastgltf::Primitive &p) {
+    if (!p.indicesAccessor.has_value() || !is_accessor_in_bounds(gltf, p.indicesAccessor.value())) {
+        return false;
+    }
+
+    const char *attribute_names[] = { "POSITION", "NORMAL", "TANGENT", "TEXCOORD_0", "COLOR_0" };
+    for(uint32_t i = 0u; i < sizeof(attribute_names) / sizeof(attribute_names[0u]); i++) {
+        const fastgltf::Attribute *attribute = p.findAttribute(attribute_names[i]);
+        if (attribute == p.attributes.end()) {
+            // Only the position is required
+            if (i == 0u) {
+                return false;
+            }
+            continue;
+        }
+        if (!is_accessor_in_bounds(gltf, attribute->accessorIndex)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Raw bytes of the accessor, only for the plain float (or unsigned int for indices) case
+static bool get_accessor_view(  const fastgltf::Asset &gltf, 
+                                const fastgltf::Accessor &accessor, 
+                                const uint8_t **data, 
+                                uint32_t *stride) {
+    if (accessor.sparse.has_value() || accessor.normalized || !accessor.bufferViewIndex.has_value()) {
+        return false;
+    }
+
+    const fastgltf::DefaultBufferDataAdapter adapter = {};
+    const auto view_bytes = adapter(gltf, accessor.bufferViewIndex.value());
+    if (view_bytes.data() == nullptr) {
+        return false;
+    }
+
+    const fastgltf::BufferView &view = gltf.bufferViews[accessor.bufferViewIndex.value()];
+    const uint32_t element_size = (uint32_t) fastgltf::getElementByteSize(accessor.type, accessor.componentType);
+
+    *data = ((const uint8_t*) view_bytes.data()) + accessor.byteOffset;
+    *stride = (uint32_t) view.byteStride.value_or(element_size);
+    return true;
+}
+
+static bool get_attribute_stream(   const fastgltf::Asset &gltf, 
+                                    const fastgltf::Primitive &p, 
+                                    const char* attribute_name, 
+                                    const fastgltf::AccessorType min_type,
+                                    Parsers::sAttributeStream *stream) {
+    const fastgltf::Attribute *attribute = p.findAttribute(attribute_name);
+    if (attribute == p.attributes.end()) {
+        // Missing attributes are fine, the kernel writes the defaults
+        *stream = {};
+        return true;
+    }
+
+    const fastgltf::Accessor &accessor = gltf.accessors[attribute->accessorIndex];
+    if (accessor.componentType != fastgltf::ComponentType::Float || 
+        fastgltf::getNumComponents(accessor.type) < fastgltf::getNumComponents(min_type)) {
+        return false;
+    }
+
+    return get_accessor_view(gltf, accessor, &stream->data, &stream->stride);
+}
+
+static bool decode_primitive_fast(  const fastgltf::Asset &gltf, 
+                                    const sPrimitiveDecode &decode, 
+                                    Parsers::sMeshImport *import) {
+    const fastgltf::Primitive &p = *decode.primitive;
+
+    Parsers::sVertexStreams streams = {};
+    if (!get_attribute_stream(gltf, p, "POSITION", fastgltf::AccessorType::Vec3, &streams.position) || 
+        !get_attribute_stream(gltf, p, "NORMAL", fastgltf::AccessorType::Vec3, &streams.normal) || 
+        !get_attribute_stream(gltf, p, "TANGENT", fastgltf::AccessorType::Vec3, &streams.tangent) || 
+        !get_attribute_stream(gltf, p, "TEXCOORD_0", fastgltf::AccessorType::Vec2, &streams.uv) || 
+        !get_attribute_stream(gltf, p, "COLOR_0", fastgltf::AccessorType::Vec3, &streams.color)) {
+        return false;
+    }
+
+    const fastgltf::Accessor &index_accessor = gltf.accessors[p.indicesAccessor.value()];
+    const uint32_t index_size = (uint32_t) fastgltf::getElementByteSize(index_accessor.type, index_accessor.componentType);
+    const uint8_t *index_data = nullptr;
+    uint32_t index_stride = 0u;
+    if (!get_accessor_view(gltf, index_accessor, &index_data, &index_stride) || index_stride != index_size) {
+        return false;
+    }
+
+    const uint32_t vertex_count = (uint32_t) gltf.accessors[p.findAttribute("POSITION")->accessorIndex].count;
+
+    Parsers::interleave_vertices(streams, vertex_count, &import->vertices[decode.first_vertex]);
+    Parsers::widen_indices( index_data, 
+                            index_size, 
+                            (uint32_t) index_accessor.count, 
+                            decode.mesh_base_vertex, 
+                            &import->indices[decode.first_index]);
+
+    return true;
+}
+
+// Runs on the workers, only writes on the primitive's own slice of the import buffers
+static void decode_primitive(   const fastgltf::Asset &gltf, 
+                                const sPrimitiveDecode &decode, 
+                                Parsers::sMeshImport *import) {
+    if (!decode_primitive_fast(gltf, decode, import)) {
+        decode_primitive_generic(gltf, decode, import);
+    }
+}
+
+// Decodes on scratch buffers, the import ones are already welded & compacted
+static void benchmark_primitive_decode( const fastgltf::Asset &gltf, 
+                                        const sDynamicArray<sPrimitiveDecode> &primitives, 
+                                        const uint32_t decoded_index_count, 
+                                        const uint32_t decoded_vertex_count) {
+    Parsers::sMeshImport scratch = {};
+    scratch.total_index_count = decoded_index_count;
+    scratch.total_vertex_count = decoded_vertex_count;
+    scratch.indices = (uint32_t*) malloc(sizeof(uint32_t) * decoded_index_count);
+    scratch.vertices = (Render::sVertex*) malloc(sizeof(Render::sVertex) * decoded_vertex_count);
+    Parsers::sMeshImport *import = &scratch;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0u; i < primitives.count; i++) {
+        decode_primitive_generic(gltf, primitives[i], import);
+    }
+    const double generic_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t fast_primitive_count = 0u;
+    start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0u; i < primitives.count; i++) {
+        fast_primitive_count += (decode_primitive_fast(gltf, primitives[i], import)) ? 1u : 0u;
+    }
+    const double fast_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    spdlog::info("Vertex decode, generic path: {:.2f} Mverts/s, interleave kernel: {:.2f} Mverts/s ({}/{} primitives on the kernel)",
+                    import->total_vertex_count / generic_time * 1e-6,
+                    import->total_vertex_count / fast_time * 1e-6,
+                    fast_primitive_count,
+                    primitives.count);
+
+    scratch.clean();
+}
+
+// Bit identical vertices are merged per mesh on the workers, then the vertex buffer is compacted
+static void weld_import_vertices(Parsers::sMeshImport *import) {
+    sJobSystem::get().parallel_for(import->mesh_count, 1u, [&](uint32_t mesh_idx) {
+        Render::sVertex *vertices = &import->vertices[import->mesh_first_vertex[mesh_idx]];
+        const uint32_t vertex_count = import->mesh_vertex_count[mesh_idx];
+
+        // The padding is not written by the decode, and the welding compares whole vertices
+        for(uint32_t i = 0u; i < vertex_count; i++) {
+            vertices[i].pad0 = 0.0f;
+            vertices[i].pad1 = 0.0f;
+            vertices[i].pad2 = 0.0f;
+            vertices[i].pad3 = {0.0f, 0.0f};
+        }
+
+        import->mesh_vertex_count[mesh_idx] = Geometry::weld_vertices(  &import->indices[import->mesh_first_index[mesh_idx]], 
+                                                                        import->mesh_index_count[mesh_idx], 
+                                                                        (uint8_t*) vertices, 
+                                                                        sizeof(Render::sVertex), 
+                                                                        vertex_count);
+    });
+
+    uint32_t vertex_count = 0u;
+    for(uint32_t i = 0u; i < import->mesh_count; i++) {
+        memmove(&import->vertices[vertex_count], &import->vertices[import->mesh_first_vertex[i]], sizeof(Render::sVertex) * import->mesh_vertex_count[i]);
+        import->mesh_first_vertex[i] = vertex_count;
+        vertex_count += import->mesh_vertex_count[i];
+    }
+
+    spdlog::info("Vertex welding: {} -> {} vertices", import->total_vertex_count, vertex_count);
+    import->total_vertex_count = vertex_count;
+}
+
+// Meshes with the same vertices & indices are stored once, the file's meshes are remaped to them
+static void deduplicate_meshes(Parsers::sMeshImport *import) {
+    uint64_t *mesh_hashes = (uint64_t*) malloc(sizeof(uint64_t) * import->mesh_count);
+
+    sJobSystem::get().parallel_for(import->mesh_count, 1u, [&](uint32_t mesh_idx) {
+        const uint64_t vertex_hash = hash_bytes(&import->vertices[import->mesh_first_vertex[mesh_idx]], sizeof(Render::sVertex) * import->mesh_vertex_count[mesh_idx]);
+        const uint64_t index_hash = hash_bytes(&import->indices[import->mesh_first_index[mesh_idx]], sizeof(uint32_t) * import->mesh_index_count[mesh_idx]);
+        mesh_hashes[mesh_idx] = vertex_hash ^ (index_hash * 0x9e3779b97f4a7c15ull);
+    });
+
+    // Open addressing table of the unique meshes, by their hash
+    uint32_t table_size = 64u;
+    while(table_size < import->mesh_count * 2u) {
+        table_size *= 2u;
+    }
+    uint32_t *table = (uint32_t*) malloc(sizeof(uint32_t) * table_size);
+    memset(table, 0xff, sizeof(uint32_t) * table_size);
+
+    import->source_mesh_count = import->mesh_count;
+    import->source_mesh_remap = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+
+    // The unique meshes are compacted in place, their data only moves backwards
+    uint32_t unique_count = 0u, index_count = 0u, vertex_count = 0u;
+    for(uint32_t i = 0u; i < import->source_mesh_count; i++) {
+        const uint32_t *indices = &import->indices[import->mesh_first_index[i]];
+        const Render::sVertex *vertices = &import->vertices[import->mesh_first_vertex[i]];
+
+        uint32_t slot = (uint32_t) mesh_hashes[i] & (table_size - 1u);
+        while(table[slot] != UINT32_MAX) {
+            const uint32_t unique_idx = table[slot];
+            if (mesh_hashes[unique_idx] == mesh_hashes[i] &&
+                import->mesh_index_count[unique_idx] == import->mesh_index_count[i] &&
+                import->mesh_vertex_count[unique_idx] == import->mesh_vertex_count[i] &&
+                memcmp(&import->indices[import->mesh_first_index[unique_idx]], indices, sizeof(uint32_t) * import->mesh_index_count[i]) == 0 &&
+                memcmp(&import->vertices[import->mesh_first_vertex[unique_idx]], vertices, sizeof(Render::sVertex) * import->mesh_vertex_count[i]) == 0) {
+                break;
+            }
+            slot = (slot + 1u) & (table_size - 1u);
+        }
+
+        if (table[slot] != UINT32_MAX) {
+            import->source_mesh_remap[i] = table[slot];
+            continue;
+        }
+
+        memmove(&import->indices[index_count], indices, sizeof(uint32_t) * import->mesh_index_count[i]);
+        memmove(&import->vertices[vertex_count], vertices, sizeof(Render::sVertex) * import->mesh_vertex_count[i]);
+
+        mesh_hashes[unique_count] = mesh_hashes[i];
+        import->mesh_first_index[unique_count] = index_count;
+        import->mesh_index_count[unique_count] = import->mesh_index_count[i];
+        import->mesh_first_vertex[unique_count] = vertex_count;
+        import->mesh_vertex_count[unique_count] = import->mesh_vertex_count[i];
+        index_count += import->mesh_index_count[i];
+        vertex_count += import->mesh_vertex_count[i];
+
+        table[slot] = unique_count;
+        import->source_mesh_remap[i] = unique_count;
+        unique_count++;
+    }
+
+    spdlog::info("Mesh deduplication: {} -> {} meshes, {} -> {} indices",
+                    import->source_mesh_count,
+                    unique_count,
+                    import->total_index_count,
+                    index_count);
+
+    import->mesh_count = unique_count;
+    import->total_index_count = index_count;
+    import->total_vertex_count = vertex_count;
+
+    free(table);
+    free(mesh_hashes);
+}
+
+// Post-transform cache, overdraw & vertex fetch order, per mesh on the workers
+static void optimize_meshes(Parsers::sMeshImport *import) {
+    Geometry::sVertexCacheStats *stats_before = (Geometry::sVertexCacheStats*) malloc(sizeof(Geometry::sVertexCacheStats) * import->mesh_count);
+    Geometry::sVertexCacheStats *stats_after = (Geometry::sVertexCacheStats*) malloc(sizeof(Geometry::sVertexCacheStats) * import->mesh_count);
+
+    sJobSystem::get().parallel_for(import->mesh_count, 1u, [&](uint32_t mesh_idx) {
+        uint32_t *indices = &import->indices[import->mesh_first_index[mesh_idx]];
+        Render::sVertex *vertices = &import->vertices[import->mesh_first_vertex[mesh_idx]];
+        const uint32_t index_count = import->mesh_index_count[mesh_idx];
+        const uint32_t vertex_count = import->mesh_vertex_count[mesh_idx];
+
+        stats_before[mesh_idx] = Geometry::analyze_vertex_cache(indices, index_count, vertex_count, VERTEX_CACHE_ANALYZE_SIZE);
+
+        Geometry::optimize_vertex_cache(indices, index_count, vertex_count);
+        Geometry::optimize_overdraw(indices, 
+                                    index_count, 
+                                    (const uint8_t*) &vertices->position, 
+                                    sizeof(Render::sVertex), 
+                                    vertex_count, 
+                                    OVERDRAW_ACMR_THRESHOLD);
+        Geometry::optimize_vertex_fetch(indices, index_count, (uint8_t*) vertices, sizeof(Render::sVertex), vertex_count);
+
+        stats_after[mesh_idx] = Geometry::analyze_vertex_cache(indices, index_count, vertex_count, VERTEX_CACHE_ANALYZE_SIZE);
+    });
+
+    Geometry::sVertexCacheStats total_before = {}, total_after = {};
+    for(uint32_t i = 0u; i < import->mesh_count; i++) {
+        total_before.add(stats_before[i]);
+        total_after.add(stats_after[i]);
+    }
+
+    spdlog::info("Mesh optimization: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                    total_before.get_acmr(),
+                    total_after.get_acmr(),
+                    total_before.get_atvr(),
+                    total_after.get_atvr());
+
+    free(stats_before);
+    free(stats_after);
+}
 
-        for (auto&& p : mesh.primitives) {
-            mesh_index_count += (uint32_t) (gltf.accessors[p.indicesAccessor.value()].count);
-            mesh_vertex_count += (uint32_t) (gltf.accessors[p.findAttribute("POSITION")->accessorIndex].count);
+// LOD chain per mesh on the workers, each level is simplified from the previous one
+// Then the index buffer is repacked, so the levels of a mesh follow its full detail indices
+static void build_import_lods(Parsers::sMeshImport *import) {
+    uint32_t **mesh_lod_indices = (uint32_t**) calloc(import->mesh_count, sizeof(uint32_t*));
+    uint32_t *mesh_total_index_count = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+
+    import->mesh_lod_count = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+    import->mesh_lods = (Render::sMeshLOD*) calloc(import->mesh_count * MESH_MAX_LODS, sizeof(Render::sMeshLOD));
+
+    sJobSystem::get().parallel_for(import->mesh_count, 1u, [&](uint32_t mesh_idx) {
+        const uint32_t *base_indices = &import->indices[import->mesh_first_index[mesh_idx]];
+        const Render::sVertex *vertices = &import->vertices[import->mesh_first_vertex[mesh_idx]];
+        const uint32_t base_index_count = import->mesh_index_count[mesh_idx];
+        const uint32_t vertex_count = import->mesh_vertex_count[mesh_idx];
+        Render::sMeshLOD *lods = &import->mesh_lods[mesh_idx * MESH_MAX_LODS];
+
+        // Worst case, every level has all the triangles of the full detail one
+        uint32_t *lod_indices = (uint32_t*) malloc(sizeof(uint32_t) * base_index_count * MESH_MAX_LODS);
+        memcpy(lod_indices, base_indices, sizeof(uint32_t) * base_index_count);
+
+        lods[0u] = { .first_index = 0u, .index_count = base_index_count, .error = 0.0f };
+        uint32_t lod_count = 1u;
+        uint32_t total_index_count = base_index_count;
+
+        while(lod_count < MESH_MAX_LODS) {
+            const Render::sMeshLOD &prev_lod = lods[lod_count - 1u];
+            if (prev_lod.index_count / 3u <= LOD_MIN_TRIANGLE_COUNT) {
+                break;
+            }
+
+            const uint32_t target_index_count = (uint32_t) (prev_lod.index_count / 3u * LOD_TARGET_RATIO) * 3u;
+            uint32_t *result = &lod_indices[total_index_count];
+            uint32_t result_index_count = 0u;
+            const float error = Geometry::simplify( &lod_indices[prev_lod.first_index], 
+                                                    prev_lod.index_count, 
+                                                    (const uint8_t*) &vertices->position, 
+                                                    sizeof(Render::sVertex), 
+                                                    vertex_count, 
+                                                    target_index_count, 
+                                                    result, 
+                                                    &result_index_count);
+
+            if (result_index_count == 0u || result_index_count > prev_lod.index_count * (1.0f - LOD_MIN_REDUCTION)) {
+                break;
+            }
+
+            Geometry::optimize_vertex_cache(result, result_index_count, vertex_count);
+
+            // The errors are from the previous level, so they add up along the chain
+            lods[lod_count] = {
+                .first_index = total_index_count,
+                .index_count = result_index_count,
+                .error = prev_lod.error + error
+            };
+            lod_count++;
+            total_index_count += result_index_count;
         }
 
-        // Resize if necesary the index or vertex buffers
-        {
-            if (mesh_index_count > total_index_buffer_size) {
-                total_index_buffer_size = mesh_index_count;
+        import->mesh_lod_count[mesh_idx] = lod_count;
+        mesh_lod_indices[mesh_idx] = lod_indices;
+        mesh_total_index_count[mesh_idx] = total_index_count;
+    });
+
+    uint32_t total_index_count = 0u, lod_total = 0u;
+    for(uint32_t i = 0u; i < import->mesh_count; i++) {
+        total_index_count += mesh_total_index_count[i];
+        lod_total += import->mesh_lod_count[i];
+    }
+
+    uint32_t *indices = (uint32_t*) malloc(sizeof(uint32_t) * total_index_count);
+    uint32_t first_index = 0u;
+    for(uint32_t i = 0u; i < import->mesh_count; i++) {
+        memcpy(&indices[first_index], mesh_lod_indices[i], sizeof(uint32_t) * mesh_total_index_count[i]);
+        free(mesh_lod_indices[i]);
+
+        import->mesh_first_index[i] = first_index;
+        import->mesh_index_count[i] = mesh_total_index_count[i];
+        first_index += mesh_total_index_count[i];
+    }
+
+    spdlog::info("Built {} LODs for {} meshes: {} -> {} indices",
+                    lod_total,
+                    import->mesh_count,
+                    import->total_index_count,
+                    total_index_count);
+
+    free(import->indices);
+    import->indices = indices;
+    import->total_index_count = total_index_count;
+
+    free(mesh_lod_indices);
+    free(mesh_total_index_count);
+}
+
+// After the optimizations, the meshlets are runs of the final triangle order
+// Each LOD gets its own meshlets, so the culling works on any of them
+static void build_import_meshlets(Parsers::sMeshImport *import) {
+    sDynamicArray<Geometry::sMeshlet> *mesh_meshlets = (sDynamicArray<Geometry::sMeshlet>*) calloc(import->mesh_count, sizeof(sDynamicArray<Geometry::sMeshlet>));
 
-                if (!tmp_index_buffer) {
-                    free(tmp_index_buffer);
-                }
-                tmp_index_buffer = (uint32_t*) malloc(sizeof(uint32_t) * total_index_buffer_size);
+    sJobSystem::get().parallel_for(import->mesh_count, 1u, [&](uint32_t mesh_idx) {
+        const Render::sVertex *vertices = &import->vertices[import->mesh_first_vertex[mesh_idx]];
+        const uint32_t *indices = &import->indices[import->mesh_first_index[mesh_idx]];
+        Render::sMeshLOD *lods = &import->mesh_lods[mesh_idx * MESH_MAX_LODS];
+
+        for(uint32_t lod_idx = 0u; lod_idx < import->mesh_lod_count[mesh_idx]; lod_idx++) {
+            Render::sMeshLOD &lod = lods[lod_idx];
+            lod.first_meshlet = mesh_meshlets[mesh_idx].count;
+            lod.meshlet_count = Geometry::build_meshlets(   &indices[lod.first_index], 
+                                                            lod.index_count, 
+                                                            (const uint8_t*) &vertices->position, 
+                                                            sizeof(Render::sVertex), 
+                                                            import->mesh_vertex_count[mesh_idx], 
+                                                            &mesh_meshlets[mesh_idx]);
+
+            // The meshlet ranges are relative to the mesh, not to the level
+            for(uint32_t i = lod.first_meshlet; i < lod.first_meshlet + lod.meshlet_count; i++) {
+                mesh_meshlets[mesh_idx][i].first_index += lod.first_index;
             }
+        }
+    });
+
+    import->mesh_first_meshlet = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+    import->mesh_meshlet_count = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+    import->total_meshlet_count = 0u;
+    for(uint32_t i = 0u; i < import->mesh_count; i++) {
+        import->mesh_first_meshlet[i] = import->total_meshlet_count;
+        import->mesh_meshlet_count[i] = mesh_meshlets[i].count;
+        import->total_meshlet_count += mesh_meshlets[i].count;
+    }
+
+    import->meshlets = (Geometry::sMeshlet*) malloc(sizeof(Geometry::sMeshlet) * import->total_meshlet_count);
+    for(uint32_t i = 0u; i < import->mesh_count; i++) {
+        memcpy(&import->meshlets[import->mesh_first_meshlet[i]], mesh_meshlets[i].data, sizeof(Geometry::sMeshlet) * mesh_meshlets[i].count);
+        mesh_meshlets[i].clean();
+    }
+    free(mesh_meshlets);
+
+    spdlog::info("Built {} meshlets for {} meshes", import->total_meshlet_count, import->mesh_count);
+}
+
+static void alloc_import_nodes(Parsers::sMeshImport *import, const uint32_t node_count) {
+    uint8_t *node_data = (uint8_t*) malloc((sizeof(uint32_t) * 2u + sizeof(glm::vec3) * 2u + sizeof(glm::quat)) * node_count);
+
+    import->node_count = node_count;
+    import->node_parents = (uint32_t*) node_data;
+    import->node_meshes = import->node_parents + node_count;
+    import->node_positions = (glm::vec3*) (import->node_meshes + node_count);
+    import->node_rotations = (glm::quat*) (import->node_positions + node_count);
+    import->node_scales = (glm::vec3*) (import->node_rotations + node_count);
+}
+
+// Breadth first from the roots of the default scene, so the nodes end up depth sorted
+static void import_gltf_nodes(const fastgltf::Asset &gltf, Parsers::sMeshImport *import) {
+    const uint32_t gltf_node_count = (uint32_t) gltf.nodes.size();
+    if (gltf.scenes.empty() || gltf_node_count == 0u) {
+        // No scene: a root node per mesh, on the origin
+        alloc_import_nodes(import, import->source_mesh_count);
+        for(uint32_t i = 0u; i < import->source_mesh_count; i++) {
+            import->node_parents[i] = TRANSFORM_ROOT;
+            import->node_meshes[i] = i;
+            import->node_positions[i] = glm::vec3(0.0f);
+            import->node_rotations[i] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            import->node_scales[i] = glm::vec3(1.0f);
+        }
+        return;
+    }
+
+    const fastgltf::Scene &scene = gltf.scenes[gltf.defaultScene.value_or(0u)];
+
+    uint32_t *gltf_node_order = (uint32_t*) malloc(sizeof(uint32_t) * gltf_node_count);
+    uint32_t *order_parents = (uint32_t*) malloc(sizeof(uint32_t) * gltf_node_count);
+    // Broken files can list a node twice
+    bool *is_visited = (bool*) calloc(gltf_node_count, sizeof(bool));
+
+    uint32_t ordered_count = 0u;
+    for(const size_t root : scene.nodeIndices) {
+        if (root < gltf_node_count && !is_visited[root]) {
+            is_visited[root] = true;
+            order_parents[ordered_count] = TRANSFORM_ROOT;
+            gltf_node_order[ordered_count++] = (uint32_t) root;
+        }
+    }
+
+    for(uint32_t i = 0u; i < ordered_count; i++) {
+        for(const size_t child : gltf.nodes[gltf_node_order[i]].children) {
+            if (child < gltf_node_count && !is_visited[child]) {
+                is_visited[child] = true;
+                order_parents[ordered_count] = i;
+                gltf_node_order[ordered_count++] = (uint32_t) child;
+            }
+        }
+    }
+
+    alloc_import_nodes(import, ordered_count);
+    for(uint32_t i = 0u; i < ordered_count; i++) {
+        const fastgltf::Node &node = gltf.nodes[gltf_node_order[i]];
+
+        import->node_parents[i] = order_parents[i];
+        import->node_meshes[i] = (node.meshIndex.has_value()) ? (uint32_t) node.meshIndex.value() : UINT32_MAX;
+
+        fastgltf::math::fvec3 position, scale;
+        fastgltf::math::fquat rotation;
+        if (const fastgltf::TRS *trs = std::get_if<fastgltf::TRS>(&node.transform)) {
+            position = trs->translation;
+            rotation = trs->rotation;
+            scale = trs->scale;
+        } else {
+            fastgltf::math::decomposeTransformMatrix(std::get<fastgltf::math::fmat4x4>(node.transform), scale, rotation, position);
+        }
+
+        import->node_positions[i] = glm::vec3(position[0u], position[1u], position[2u]);
+        import->node_rotations[i] = glm::quat(rotation[3u], rotation[0u], rotation[1u], rotation[2u]);
+        import->node_scales[i] = glm::vec3(scale[0u], scale[1u], scale[2u]);
+    }
+
+    free(is_visited);
+    free(order_parents);
+    free(gltf_node_order);
+}
+
+void Parsers::sMeshImportUpload::init(const sMeshImport &import) {
+    next_node = 0u;
+    first_transform = UINT32_MAX;
+    uploaded_mesh_idx = (uint32_t*) malloc(sizeof(uint32_t) * import.mesh_count);
+    memset(uploaded_mesh_idx, 0xff, sizeof(uint32_t) * import.mesh_count);
+    shared_count = 0u;
+    shared_bytes = 0u;
+    uploaded_bytes = 0u;
+}
+
+void Parsers::sMeshImportUpload::clean() {
+    free(uploaded_mesh_idx);
 
-            if (mesh_vertex_count > total_vertex_buffer_size) {
-                total_vertex_buffer_size = mesh_vertex_count;
+    *this = {};
+}
 
-                if (!tmp_vertex_buffer) {
-                    free(tmp_vertex_buffer);
-                }
-                tmp_vertex_buffer = (Render::sVertex*) malloc(sizeof(Render::sVertex) * total_vertex_buffer_size);
+uint32_t Parsers::upload_import_meshes(const sMeshImport &import, 
+                                        sMeshImportUpload *upload,
+                                        const uint64_t byte_budget,
+                                        sDynamicArray<Render::sGPUMesh> *meshes_to_fill, 
+                                        Render::sBackend *renderer, 
+                                        Render::sFrame *frame_to_upload) {
+    uint32_t *uploaded_mesh_idx = upload->uploaded_mesh_idx;
+
+    if (upload->first_transform == UINT32_MAX) {
+        upload->first_transform = renderer->scene_transforms.add_nodes( import.node_count, 
+                                                                        import.node_parents, 
+                                                                        import.node_positions, 
+                                                                        import.node_rotations, 
+                                                                        import.node_scales);
+    }
+
+    uint32_t instance_count = 0u;
+    uint64_t staged_bytes = 0u;
+    // At least an instance per call, so a mesh bigger than the budget is still uploaded
+    while(upload->next_node < import.node_count && (staged_bytes < byte_budget || instance_count == 0u)) {
+        const uint32_t node = upload->next_node++;
+        if (import.node_meshes[node] >= import.source_mesh_count) {
+            continue;
+        }
+        const uint32_t mesh_idx = import.source_mesh_remap[import.node_meshes[node]];
+
+        if (uploaded_mesh_idx[mesh_idx] != UINT32_MAX) {
+            upload->shared_count++;
+            upload->shared_bytes += renderer->geometry_pool.get_mesh_size((*meshes_to_fill)[uploaded_mesh_idx[mesh_idx]]);
+        } else {
+            Render::sGPUMesh new_mesh = {};
+            if (!renderer->create_gpu_mesh( &new_mesh, 
+                                            &import.indices[import.mesh_first_index[mesh_idx]], 
+                                            import.mesh_index_count[mesh_idx], 
+                                            &import.vertices[import.mesh_first_vertex[mesh_idx]], 
+                                            import.mesh_vertex_count[mesh_idx], 
+                                            &import.meshlets[import.mesh_first_meshlet[mesh_idx]], 
+                                            import.mesh_meshlet_count[mesh_idx], 
+                                            &import.mesh_lods[mesh_idx * MESH_MAX_LODS], 
+                                            import.mesh_lod_count[mesh_idx], 
+                                            frame_to_upload )) {
+                continue;
             }
+            uploaded_mesh_idx[mesh_idx] = meshes_to_fill->count;
+            meshes_to_fill->push(new_mesh);
+
+            const uint64_t mesh_size = renderer->geometry_pool.get_mesh_size(new_mesh);
+            staged_bytes += mesh_size;
+            upload->uploaded_bytes += mesh_size;
+        }
+
+        // Repeated & deduplicated meshes are more instances of the same GPU mesh
+        renderer->mesh_instances.push({
+            .mesh_idx = uploaded_mesh_idx[mesh_idx],
+            .transform_idx = upload->first_transform + node
+        });
+        instance_count++;
+    }
+
+    if (upload->is_done(import) && upload->shared_count > 0u) {
+        spdlog::info("{} instances share the GPU data of a previous one, {:.2f} MB saved", upload->shared_count, upload->shared_bytes / (1024.0 * 1024.0));
+    }
+
+    return instance_count;
+}
+
+// Size & modification time of a file the glTF references, mixed into the bake key
+static uint64_t hash_external_source(const uint64_t hash, const Parsers::sGltfFile &file, const fastgltf::URI &uri) {
+    uint64_t key[3u] = { hash, UINT64_MAX, 0u };
+
+    char source_path[512u] = {};
+    if (Parsers::get_gltf_uri_path(file, uri, source_path, sizeof(source_path))) {
+        std::error_code error = {};
+        const uint64_t file_size = (uint64_t) std::filesystem::file_size(source_path, error);
+        const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(source_path, error);
+        if (!error) {
+            key[1u] = file_size;
+            key[2u] = (uint64_t) write_time.time_since_epoch().count();
         }
+    }
+    return hash_bytes(key, sizeof(key));
+}
+
+// Bake key: the glTF file bytes (the GLB chunk included), and the external buffers & images it references,
+// from the JSON of the shared parse, without loading them
+static bool hash_gltf_sources(const Parsers::sGltfFile &file, uint64_t *source_hash) {
+    sMappedFile source_file = {};
+    if (!source_file.open(file.file_dir)) {
+        return false;
+    }
+    uint64_t hash = hash_bytes(source_file.data, source_file.size);
+    source_file.close();
+
+    const fastgltf::Asset &gltf = file.asset;
+    for(const fastgltf::Buffer &buffer : gltf.buffers) {
+        if (const fastgltf::sources::URI *uri = std::get_if<fastgltf::sources::URI>(&buffer.data)) {
+            hash = hash_external_source(hash, file, uri->uri);
+        }
+    }
+    for(const fastgltf::Image &image : gltf.images) {
+        if (const fastgltf::sources::URI *uri = std::get_if<fastgltf::sources::URI>(&image.data)) {
+            hash = hash_external_source(hash, file, uri->uri);
+        }
+    }
+
+    *source_hash = hash;
+    return true;
+}
+
+// Parse & process of the meshes, baked with the source hash
+static bool decode_gltf_meshes( const Parsers::sGltfFile &file, 
+                                const char* baked_file_dir, 
+                                const uint64_t source_hash, 
+                                Parsers::sMeshImport *import) {
+    const char *gltf_file_dir = file.file_dir;
+    const fastgltf::Asset &gltf = file.asset;
+
+    const std::chrono::steady_clock::time_point import_start = std::chrono::steady_clock::now();
+
+    // Size everything up front, so each primitive can be decoded on its own slice
+    *import = {};
+    import->mesh_count = (uint32_t) gltf.meshes.size();
+    import->mesh_first_index = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+    import->mesh_index_count = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+    import->mesh_first_vertex = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
+    import->mesh_vertex_count = (uint32_t*) malloc(sizeof(uint32_t) * import->mesh_count);
 
-        for (auto&& p : mesh.primitives) {
-            fastgltf::iterateAccessorWithIndex<uint32_t>(gltf, gltf.accessors[p.indicesAccessor.value()],
-                    [&tmp_index_buffer](uint32_t idx, size_t buffer_idx) {
-                        tmp_index_buffer[buffer_idx] = idx;
-                    });
-
-            fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[p.findAttribute("POSITION")->accessorIndex],
-                    [&tmp_vertex_buffer](glm::vec3 pos, size_t buffer_idx) {
-                        tmp_vertex_buffer[buffer_idx].position = pos;
-                    });
-            fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[p.findAttribute("NORMAL")->accessorIndex],
-                    [&tmp_vertex_buffer](glm::vec3 pos, size_t buffer_idx) {
-                        tmp_vertex_buffer[buffer_idx].normal = pos;
-                        tmp_vertex_buffer[buffer_idx].color = {pos.x, pos.y, pos.z, 1.0f};
-                    });
-            fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[p.findAttribute("TANGENT")->accessorIndex],
-                    [&tmp_vertex_buffer](glm::vec3 tan, size_t buffer_idx) {
-                        tmp_vertex_buffer[buffer_idx].tangent = tan;
-                    });
-            fastgltf::iterateAccessorWithIndex<glm::vec2>(gltf, gltf.accessors[p.findAttribute("TEXCOORD_0")->accessorIndex],
-                    [&tmp_vertex_buffer](glm::vec2 uv, size_t buffer_idx) {
-                        tmp_vertex_buffer[buffer_idx].uv = uv;
-                    });
-            fastgltf::Attribute *vertex_color = p.findAttribute("COLOR_0");
-            if (vertex_color) {
-                fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[vertex_color->accessorIndex],
-                    [&tmp_vertex_buffer](glm::vec3 color, size_t buffer_idx) {
-                        tmp_vertex_buffer[buffer_idx].color = glm::vec4(color, 1.0f);
-                    });
+    sDynamicArray<sPrimitiveDecode> primitives = {};
+    for(uint32_t i = 0u; i < import->mesh_count; i++) {
+        // Our meshes are the gltf's primitives
+        import->mesh_first_index[i] = import->total_index_count;
+        import->mesh_first_vertex[i] = import->total_vertex_count;
+
+        for (const fastgltf::Primitive& p : gltf.meshes[i].primitives) {
+            // The decode trusts the accessors, malformed files are rejected as a whole
+            if (!are_primitive_accessors_in_bounds(gltf, p)) {
+                spdlog::error("Mesh {} of {} has accessors out of the bounds of its buffers", i, gltf_file_dir);
+                primitives.clean();
+                import->clean();
+                return false;
             }
+
+            const uint32_t index_count = (uint32_t) (gltf.accessors[p.indicesAccessor.value()].count);
+            const uint32_t vertex_count = (uint32_t) (gltf.accessors[p.findAttribute("POSITION")->accessorIndex].count);
+
+            primitives.push({
+                .primitive = &p,
+                .first_index = import->total_index_count,
+                .first_vertex = import->total_vertex_count,
+                .mesh_base_vertex = import->total_vertex_count - import->mesh_first_vertex[i]
+            });
+
+            import->total_index_count += index_count;
+            import->total_vertex_count += vertex_count;
         }
 
-        renderer->create_gpu_mesh(  &meshes_to_fill[mesh_count++], 
-                                    tmp_index_buffer, 
-                                    mesh_index_count, 
-                                    tmp_vertex_buffer, 
-                                    mesh_vertex_count, 
-                                    frame_to_upload );
+        import->mesh_index_count[i] = import->total_index_count - import->mesh_first_index[i];
+        import->mesh_vertex_count[i] = import->total_vertex_count - import->mesh_first_vertex[i];
     }
 
-    free(tmp_index_buffer);
-    free(tmp_vertex_buffer);
+    import->indices = (uint32_t*) malloc(sizeof(uint32_t) * import->total_index_count);
+    import->vertices = (Render::sVertex*) malloc(sizeof(Render::sVertex) * import->total_vertex_count);
+
+    sJobSystem::get().parallel_for(primitives.count, 1u, [&](uint32_t primitive_idx) {
+        decode_primitive(gltf, primitives[primitive_idx], import);
+    });
+
+    const uint32_t decoded_index_count = import->total_index_count;
+    const uint32_t decoded_vertex_count = import->total_vertex_count;
+
+    weld_import_vertices(import);
+    deduplicate_meshes(import);
+    optimize_meshes(import);
+    build_import_lods(import);
+    build_import_meshlets(import);
+    import_gltf_nodes(gltf, import);
+
+    spdlog::info("Imported {} meshes ({} primitives, {} vertices) from {}: decode {} ms",
+                    import->source_mesh_count,
+                    primitives.count,
+                    decoded_vertex_count,
+                    gltf_file_dir,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - import_start).count());
+
+    if (MESH_DECODE_BENCHMARK) {
+        benchmark_primitive_decode(gltf, primitives, decoded_index_count, decoded_vertex_count);
+    }
+
+    if (Parsers::bake_meshes(baked_file_dir, source_hash, *import)) {
+        spdlog::info("Baked {} meshes on {}", import->mesh_count, baked_file_dir);
+    }
+
+    primitives.clean();
+
+    return true;
+}
+
+// Meshes & the node hierarchy, the rest of the scene (cameras, lights...) is ignored
+bool Parsers::import_gltf_meshes(const sGltfFile &file, sMeshImport *import) {
+    const char *gltf_file_dir = file.file_dir;
+
+    // Skip the whole import if there is an up to date bake of the source files
+    uint64_t source_hash = 0u;
+    if (!hash_gltf_sources(file, &source_hash)) {
+        spdlog::error("Could not open the mesh file {}", gltf_file_dir);
+        return false;
+    }
+
+    char baked_file_dir[512u] = {};
+    snprintf(baked_file_dir, sizeof(baked_file_dir), "%s%s", gltf_file_dir, BAKED_MESH_EXTENSION);
+
+    if (open_baked_meshes(baked_file_dir, source_hash, import)) {
+        spdlog::info("Loaded {} baked meshes from {}", import->source_mesh_count, baked_file_dir);
+        return true;
+    }
+
+    // Outdated bake: the external buffers are only loaded now, on a parse of its own
+    sGltfFile *loaded_file = nullptr;
+    if (has_unloaded_buffers(file)) {
+        loaded_file = open_gltf_file(file.file_dir, file.directory, true);
+        if (loaded_file == nullptr) {
+            return false;
+        }
+    }
+    const bool is_imported = decode_gltf_meshes(*((loaded_file != nullptr) ? loaded_file : &file), baked_file_dir, source_hash, import);
+    if (loaded_file != nullptr) {
+        release_gltf_file(loaded_file);
+    }
 
-    return mesh_count;
+    return is_imported;
 }
\ No newline at end of file
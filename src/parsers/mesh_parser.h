@@ -1,17 +1,100 @@
 #pragma once
 
 #include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../utils/dynamic_array.h"
+#include "../utils/mapped_file.h"
 
 namespace Render {
     struct sGPUMesh;
+    struct sMeshLOD;
+    struct sVertex;
     struct sBackend;
     struct sFrame;
 };
 
+namespace Geometry {
+    struct sMeshlet;
+};
+
 namespace Parsers {
-    uint32_t gltf_to_mesh(  const char* gltf_file_dir, 
-                            const char* gltf_directory, 
-                            Render::sGPUMesh meshes_to_fill[100u], 
-                            Render::sBackend *renderer, 
-                            Render::sFrame *frame_to_upload);
+    struct sGltfFile;
+
+    // CPU side result of a decode: all the meshes packed on the same buffers,
+    // each mesh is a range inside of them. Indices are relative to the mesh's first vertex
+    // A mesh's index range holds all its LODs, one after the other
+    struct sMeshImport {
+        uint32_t        mesh_count = 0u;
+        uint32_t        *mesh_first_index = nullptr;
+        uint32_t        *mesh_index_count = nullptr;
+        uint32_t        *mesh_first_vertex = nullptr;
+        uint32_t        *mesh_vertex_count = nullptr;
+
+        uint32_t        total_index_count = 0u;
+        uint32_t        total_vertex_count = 0u;
+        uint32_t        *indices = nullptr;
+        Render::sVertex *vertices = nullptr;
+
+        // Meshes of the file, pointing to the deduplicated mesh that has their data
+        uint32_t            source_mesh_count = 0u;
+        uint32_t            *source_mesh_remap = nullptr;
+
+        // MESH_MAX_LODS slots per mesh, with ranges relative to the mesh
+        uint32_t            *mesh_lod_count = nullptr;
+        Render::sMeshLOD    *mesh_lods = nullptr;
+
+        // Meshlet triangle ranges are relative to the mesh's first index
+        uint32_t            *mesh_first_meshlet = nullptr;
+        uint32_t            *mesh_meshlet_count = nullptr;
+        uint32_t            total_meshlet_count = 0u;
+        Geometry::sMeshlet  *meshlets = nullptr;
+
+        // Scene nodes, depth sorted (the parent is always before its children, TRANSFORM_ROOT for the roots)
+        // Each node draws its source mesh, UINT32_MAX if it has none. One array block, starting on node_parents
+        uint32_t            node_count = 0u;
+        uint32_t            *node_parents = nullptr;
+        uint32_t            *node_meshes = nullptr;
+        glm::vec3           *node_positions = nullptr;
+        glm::quat           *node_rotations = nullptr;
+        glm::vec3           *node_scales = nullptr;
+
+        // Open if the data is a view of a baked file, then only the tables are owned
+        sMappedFile         baked_file = {};
+
+        void clean();
+    };
+
+    // Progress of an import upload spread over several frames
+    struct sMeshImportUpload {
+        uint32_t            next_node = 0u;
+        // The import's nodes on the renderer's transform hierarchy, added on the first upload
+        uint32_t            first_transform = UINT32_MAX;
+        // Index on the mesh list of each deduplicated mesh once uploaded, UINT32_MAX before
+        uint32_t            *uploaded_mesh_idx = nullptr;
+        uint32_t            shared_count = 0u;
+        uint64_t            shared_bytes = 0u;
+        // Staged so far, the shared meshes do not count
+        uint64_t            uploaded_bytes = 0u;
+
+        void init(const sMeshImport &import);
+        void clean();
+
+        inline bool is_done(const sMeshImport &import) const {
+            return next_node >= import.node_count;
+        }
+    };
+
+    // Creates an instance (on the renderer's list) per node with a mesh, on node order, and uploads each deduplicated mesh once
+    // Stops once byte_budget has been staged (at least one mesh per call), returns the number of instances created
+    uint32_t upload_import_meshes(  const sMeshImport &import, 
+                                    sMeshImportUpload *upload,
+                                    const uint64_t byte_budget,
+                                    sDynamicArray<Render::sGPUMesh> *meshes_to_fill, 
+                                    Render::sBackend *renderer, 
+                                    Render::sFrame *frame_to_upload);
+
+    // CPU side only (baked file, or process of the parsed glTF), can run on a worker
+    bool import_gltf_meshes(const sGltfFile &file, sMeshImport *import);
 };
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "mesh_streamer.h"
+
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "../render/renderer.h"
+#include "../utils/job_system.h"
+#include "gltf_file.h"
+
+void Parsers::sMeshStreamer::load_gltf(sGltfFile *file) {
+    acquire_gltf_file(file);
+
+    sStreamedImport *streamed = new sStreamedImport();
+    requested_imports.push(streamed);
+
+    pending_count++;
+    parsing_count++;
+    sJobSystem::get().submit([this, streamed, file]() {
+        streamed->is_valid = import_gltf_meshes(*file, &streamed->import);
+        if (!streamed->is_valid) {
+            spdlog::error("Could not import the meshes of {}", file->file_dir);
+        } else {
+            streamed->upload.init(streamed->import);
+        }
+        release_gltf_file(file);
+
+        streamed->is_ready.store(true, std::memory_order_release);
+        parsing_count--;
+    });
+}
+
+uint32_t Parsers::sMeshStreamer::poll_uploads(Render::sBackend *renderer, Render::sFrame *frame_to_upload) {
+    uint32_t instance_count = 0u;
+    uint64_t upload_bytes = 0u;
+
+    // FIFO, a later import never goes ahead of one still on a worker
+    while(next_import < requested_imports.count && upload_bytes < upload_budget_bytes) {
+        sStreamedImport *streamed = requested_imports[next_import];
+        if (!streamed->is_ready.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        if (streamed->is_valid) {
+            const uint64_t bytes_before = streamed->upload.uploaded_bytes;
+            instance_count += upload_import_meshes( streamed->import, 
+                                                &streamed->upload, 
+                                                upload_budget_bytes - upload_bytes, 
+                                                &renderer->meshes, 
+                                                renderer, 
+                                                frame_to_upload);
+            upload_bytes += streamed->upload.uploaded_bytes - bytes_before;
+
+            if (!streamed->upload.is_done(streamed->import)) {
+                break;
+            }
+        }
+
+        // Fully staged, the import data is not needed anymore
+        streamed->upload.clean();
+        streamed->import.clean();
+        delete streamed;
+        requested_imports[next_import++] = nullptr;
+        pending_count--;
+    }
+
+    if (next_import == requested_imports.count) {
+        requested_imports.clear();
+        next_import = 0u;
+    }
+
+    return instance_count;
+}
+
+void Parsers::sMeshStreamer::clean() {
+    // Help the workers, the import jobs reference the queued imports
+    while(parsing_count.load() > 0u) {
+        if (!sJobSystem::get().try_run_queued_job()) {
+            std::this_thread::yield();
+        }
+    }
+
+    for(uint32_t i = next_import; i < requested_imports.count; i++) {
+        sStreamedImport *streamed = requested_imports[i];
+        streamed->upload.clean();
+        streamed->import.clean();
+        delete streamed;
+    }
+    requested_imports.clean();
+    next_import = 0u;
+    pending_count = 0u;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+#include "mesh_parser.h"
+#include "../utils/dynamic_array.h"
+
+// Default geometry staged per frame, at least one mesh is uploaded per frame
+#define MESH_UPLOAD_BYTES_PER_FRAME (8u * 1024u * 1024u)
+
+namespace Parsers {
+    // An import done on a worker, and how much of it has been uploaded
+    struct sStreamedImport {
+        sMeshImport         import = {};
+        sMeshImportUpload   upload = {};
+        bool                is_valid = false;
+        // Set by the worker once the import is filled
+        std::atomic<bool>   is_ready = false;
+    };
+
+    /**
+    * glTF mesh import (baked file or parse & process) on the job system workers.
+    * The imports are queued on completion, and poll_uploads() stages their meshes from the render thread
+    * under upload_budget_bytes per frame, on request order. The meshes & their instances are appended to the renderer's lists,
+    * and drawn once their upload is resident, so the first frames do not depend on the scene size.
+    */
+    struct sMeshStreamer {
+        // Render thread only, on request order so the mesh list does not depend on the scheduling
+        sDynamicArray<sStreamedImport*>     requested_imports = {};
+        uint32_t                            next_import = 0u;
+
+        // Requested but not fully uploaded yet, & still on a worker
+        std::atomic<uint32_t>               pending_count = 0u;
+        std::atomic<uint32_t>               parsing_count = 0u;
+
+        uint64_t                            upload_budget_bytes = MESH_UPLOAD_BYTES_PER_FRAME;
+
+        // Keeps a reference to the parsed file until the import on the worker is done
+        void load_gltf(sGltfFile *file);
+
+        // Render thread only. Returns the number of instances added to the renderer's list
+        uint32_t poll_uploads(Render::sBackend *renderer, Render::sFrame *frame_to_upload);
+
+        inline bool is_idle() const {
+            return pending_count.load() == 0u;
+        }
+
+        // Waits for the imports in flight, and drops the meshes not uploaded
+        void clean();
+    };
+};
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "texture_loader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <fastgltf/core.hpp>
+#include <fastgltf/tools.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#ifdef TEXTURE_BASISU_TRANSCODING
+#include <basisu_transcoder.h>
+#endif
+
+#include "../render/renderer.h"
+#include "../render/resources/resources.h"
+#include "../utils/job_system.h"
+#include "../utils/mapped_file.h"
+#include "gltf_file.h"
+
+// Decodes from memory, or from the file if there is no encoded data
+// The result is on the closest format stb_image outputs, converted to the target one on the upload
+static uint8_t* decode_image(   const uint8_t *encoded_data,
+                                const uint64_t encoded_size,
+                                const char* file_dir,
+                                const eImageFormats format,
+                                eImageFormats *decoded_format,
+                                uint32_t *width,
+                                uint32_t *height) {
+    uint32_t channels = 0u;
+    bool is_float = false;
+    switch(format) {
+        case IMG_FORMAT_RGBA_8BIT_UNORM:
+        case IMG_FORMAT_RGBA_8BIT_SRGB:
+        case IMG_FORMAT_RGBA_8BIT_UINT:
+        case IMG_FORMAT_RGB_8BIT_UINT:
+        case IMG_FORMAT_R_8BIT_UINT:
+        case IMG_FORMAT_RGBA_32BIT_SFLOAT:
+        case IMG_FORMAT_R_32BIT_SFLOAT:
+            *decoded_format = format;
+            break;
+        case IMG_FORMAT_BRGA_8BIT_UNORM:
+            *decoded_format = IMG_FORMAT_RGBA_8BIT_UNORM;
+            break;
+        case IMG_FORMAT_BRGA_8BIT_SRGB:
+            *decoded_format = IMG_FORMAT_RGBA_8BIT_SRGB;
+            break;
+        case IMG_FORMAT_RGBA_16BIT_SFLOAT:
+            *decoded_format = IMG_FORMAT_RGBA_32BIT_SFLOAT;
+            break;
+        case IMG_FORMAT_R_16BIT_SFLOAT:
+            *decoded_format = IMG_FORMAT_R_32BIT_SFLOAT;
+            break;
+        default:
+            return nullptr;
+    }
+
+    switch(*decoded_format) {
+        case IMG_FORMAT_RGB_8BIT_UINT:
+            channels = 3u;
+            break;
+        case IMG_FORMAT_R_8BIT_UINT:
+            channels = 1u;
+            break;
+        case IMG_FORMAT_RGBA_32BIT_SFLOAT:
+            channels = 4u;
+            is_float = true;
+            break;
+        case IMG_FORMAT_R_32BIT_SFLOAT:
+            channels = 1u;
+            is_float = true;
+            break;
+        default:
+            channels = 4u;
+            break;
+    }
+
+    int32_t img_width = 0, img_height = 0, img_channels = 0;
+    void *pixels = nullptr;
+    if (is_float) {
+        pixels = (encoded_data != nullptr) ? stbi_loadf_from_memory(encoded_data, (int32_t) encoded_size, &img_width, &img_height, &img_channels, channels)
+                                           : stbi_loadf(file_dir, &img_width, &img_height, &img_channels, channels);
+    } else {
+        pixels = (encoded_data != nullptr) ? stbi_load_from_memory(encoded_data, (int32_t) encoded_size, &img_width, &img_height, &img_channels, channels)
+                                           : stbi_load(file_dir, &img_width, &img_height, &img_channels, channels);
+    }
+
+    if (pixels == nullptr) {
+        return nullptr;
+    }
+
+    *width = (uint32_t) img_width;
+    *height = (uint32_t) img_height;
+
+    return (uint8_t*) pixels;
+}
+
+static inline bool has_ktx2_extension(const char* file_dir) {
+    const char *extension = strrchr(file_dir, '.');
+    return extension != nullptr && strcmp(extension, ".ktx2") == 0;
+}
+
+// KTX2 or stb_image, from memory or from the file if there is no encoded data
+static void decode_texture( const uint8_t *encoded_data,
+                            const uint64_t encoded_size,
+                            const char* file_dir,
+                            const Parsers::sTranscodeFormats &transcode_formats,
+                            const bool is_normal_map,
+                            Parsers::sDecodedTexture *decoded) {
+    if (encoded_data == nullptr && has_ktx2_extension(file_dir)) {
+        sMappedFile ktx2_file = {};
+        if (ktx2_file.open(file_dir)) {
+            Parsers::decode_ktx2(ktx2_file.data, ktx2_file.size, transcode_formats, is_normal_map, decoded);
+            ktx2_file.close();
+        }
+        return;
+    }
+
+    if (encoded_data != nullptr && Parsers::is_ktx2(encoded_data, encoded_size)) {
+        Parsers::decode_ktx2(encoded_data, encoded_size, transcode_formats, is_normal_map, decoded);
+        return;
+    }
+
+    decoded->pixels = decode_image(encoded_data, encoded_size, file_dir, decoded->format, &decoded->source_format, &decoded->width, &decoded->height);
+    if (decoded->pixels == nullptr) {
+        const char *failure_reason = stbi_failure_reason();
+        spdlog::error("stb_image: {}", (failure_reason != nullptr) ? failure_reason : "unknown format");
+        return;
+    }
+    // Most GPUs cannot sample nor blit 24 bit formats, expanded on the upload
+    if (decoded->format == IMG_FORMAT_RGB_8BIT_UINT) {
+        decoded->format = IMG_FORMAT_RGBA_8BIT_UINT;
+    }
+    decoded->data_size = get_image_data_size(decoded->format, { decoded->width, decoded->height, 1u });
+}
+
+void Parsers::sTextureLoader::select_transcode_formats(const Render::sBackend &renderer) {
+    const bool has_bc1 = renderer.supports_sampled_format(IMG_FORMAT_BC1_RGBA_UNORM);
+    const bool has_bc3 = renderer.supports_sampled_format(IMG_FORMAT_BC3_RGBA_UNORM);
+    const bool has_bc5 = renderer.supports_sampled_format(IMG_FORMAT_BC5_RG_UNORM);
+    const bool has_bc7 = renderer.supports_sampled_format(IMG_FORMAT_BC7_RGBA_UNORM);
+
+    // Smallest first for the opaque textures (BC1 is 4 bits per texel), quality first with alpha
+    transcode_formats.color = (has_bc1) ? IMG_FORMAT_BC1_RGBA_UNORM : ((has_bc7) ? IMG_FORMAT_BC7_RGBA_UNORM : IMG_FORMAT_RGBA_8BIT_UNORM);
+    transcode_formats.color_alpha = (has_bc7) ? IMG_FORMAT_BC7_RGBA_UNORM : ((has_bc3) ? IMG_FORMAT_BC3_RGBA_UNORM : IMG_FORMAT_RGBA_8BIT_UNORM);
+    transcode_formats.normal = (has_bc5) ? IMG_FORMAT_BC5_RG_UNORM : IMG_FORMAT_RGBA_8BIT_UNORM;
+    transcode_formats.supports_bc = renderer.gpu_instance.supports_bc_compression;
+
+#ifdef TEXTURE_BASISU_TRANSCODING
+    basist::basisu_transcoder_init();
+#endif
+
+    spdlog::info("Texture transcode formats: color {} alpha {} normal {}", 
+                    (uint32_t) transcode_formats.color, 
+                    (uint32_t) transcode_formats.color_alpha, 
+                    (uint32_t) transcode_formats.normal);
+}
+
+void Parsers::sTextureLoader::load_from_file(   const char* file_dir,
+                                                const eImageFormats format,
+                                                const uint32_t texture_idx,
+                                                const bool is_normal_map) {
+    char *file_dir_copy = strdup(file_dir);
+
+    pending_count++;
+    decoding_count++;
+    sJobSystem::get().submit([this, file_dir_copy, format, texture_idx, is_normal_map]() {
+        sDecodedTexture decoded = { .texture_idx = texture_idx, .format = format };
+        decode_texture(nullptr, 0u, file_dir_copy, transcode_formats, is_normal_map, &decoded);
+        if (decoded.pixels == nullptr) {
+            spdlog::error("Could not decode the texture {}", file_dir_copy);
+        }
+        free(file_dir_copy);
+
+        {
+            std::lock_guard<std::mutex> lock(decoded_mutex);
+            decoded_textures.push(decoded);
+        }
+        decoding_count--;
+    });
+}
+
+void Parsers::sTextureLoader::load_from_memory( const uint8_t *data,
+                                                const uint64_t size,
+                                                const eImageFormats format,
+                                                const uint32_t texture_idx,
+                                                const bool is_normal_map) {
+    uint8_t *data_copy = (uint8_t*) malloc(size);
+    memcpy(data_copy, data, size);
+
+    pending_count++;
+    decoding_count++;
+    sJobSystem::get().submit([this, data_copy, size, format, texture_idx, is_normal_map]() {
+        sDecodedTexture decoded = { .texture_idx = texture_idx, .format = format };
+        decode_texture(data_copy, size, nullptr, transcode_formats, is_normal_map, &decoded);
+        if (decoded.pixels == nullptr) {
+            spdlog::error("Could not decode the embedded texture {}", texture_idx);
+        }
+        free(data_copy);
+
+        {
+            std::lock_guard<std::mutex> lock(decoded_mutex);
+            decoded_textures.push(decoded);
+        }
+        decoding_count--;
+    });
+}
+
+uint32_t Parsers::sTextureLoader::poll_uploads(Render::sBackend *renderer, Render::sFrame *frame_to_upload) {
+    uint32_t upload_count = 0u;
+    uint64_t upload_bytes = 0u;
+
+    while(upload_bytes < TEXTURE_UPLOAD_BYTES_PER_FRAME) {
+        sDecodedTexture decoded;
+        {
+            // Never wait for the workers, try again next frame
+            std::unique_lock<std::mutex> lock(decoded_mutex, std::try_to_lock);
+            if (!lock.owns_lock() || decoded_textures.count == 0u) {
+                break;
+            }
+            decoded = decoded_textures[--decoded_textures.count];
+        }
+        pending_count--;
+
+        if (decoded.pixels == nullptr) {
+            continue;
+        }
+
+        if (decoded.generate_mips) {
+            renderer->create_image( &renderer->textures[decoded.texture_idx],
+                                    decoded.pixels,
+                                    decoded.format,
+                                    VK_IMAGE_USAGE_SAMPLED_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                    VkExtent3D{ decoded.width, decoded.height, 1u },
+                                    *frame_to_upload,
+                                    true,
+                                    VK_IMAGE_ASPECT_COLOR_BIT,
+                                    decoded.source_format);
+        } else {
+            renderer->create_image( &renderer->textures[decoded.texture_idx],
+                                    decoded.pixels,
+                                    decoded.level_count,
+                                    decoded.format,
+                                    VK_IMAGE_USAGE_SAMPLED_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                    VkExtent3D{ decoded.width, decoded.height, 1u },
+                                    *frame_to_upload);
+        }
+
+        // Already on the staging ring
+        free(decoded.pixels);
+
+        // The generated mip chains are blitted on the GPU, only their level 0 goes through staging
+        upload_bytes += decoded.data_size;
+        upload_count++;
+    }
+
+    return upload_count;
+}
+
+void Parsers::sTextureLoader::clean() {
+    // Help the workers, the decode jobs reference this loader
+    while(decoding_count.load() > 0u) {
+        if (!sJobSystem::get().try_run_queued_job()) {
+            std::this_thread::yield();
+        }
+    }
+
+    for(uint32_t i = 0u; i < decoded_textures.count; i++) {
+        free(decoded_textures[i].pixels);
+    }
+    decoded_textures.clean();
+    pending_count = 0u;
+}
+
+// The shared parse leaves the external buffers as URIs, the image's range is read from the buffer's file
+static bool load_from_buffer_file(  const Parsers::sGltfFile &file, 
+                                    const fastgltf::sources::URI &buffer_uri, 
+                                    const fastgltf::BufferView &buffer_view, 
+                                    Parsers::sTextureLoader *loader, 
+                                    const eImageFormats format, 
+                                    const uint32_t texture_idx, 
+                                    const bool is_normal_map) {
+    char buffer_file_dir[512u] = {};
+    if (!Parsers::get_gltf_uri_path(file, buffer_uri.uri, buffer_file_dir, sizeof(buffer_file_dir))) {
+        return false;
+    }
+
+    sMappedFile buffer_file = {};
+    if (!buffer_file.open(buffer_file_dir)) {
+        return false;
+    }
+
+    const uint64_t view_offset = (uint64_t) buffer_uri.fileByteOffset + buffer_view.byteOffset;
+    const bool is_in_bounds = view_offset + buffer_view.byteLength <= buffer_file.size;
+    if (is_in_bounds) {
+        loader->load_from_memory(buffer_file.data + view_offset, buffer_view.byteLength, format, texture_idx, is_normal_map);
+    }
+    buffer_file.close();
+
+    return is_in_bounds;
+}
+
+// The KTX2 image of the texture if it has one, the fallback image otherwise
+static inline void mark_texture_images(const fastgltf::Asset &gltf, const size_t texture_idx, bool *image_marks) {
+    const fastgltf::Texture &texture = gltf.textures[texture_idx];
+    if (texture.basisuImageIndex.has_value()) {
+        image_marks[texture.basisuImageIndex.value()] = true;
+    } else if (texture.imageIndex.has_value()) {
+        image_marks[texture.imageIndex.value()] = true;
+    }
+}
+
+uint32_t Parsers::gltf_to_textures( const sGltfFile &file,
+                                    sTextureLoader *loader,
+                                    sDynamicArray<sImage> *textures) {
+    const fastgltf::Asset &gltf = file.asset;
+    const char *gltf_file_dir = file.file_dir;
+
+    // Normal maps are transcoded to two channel formats
+    // The base color & emissive images are sRGB, decoded to sRGB formats so the sampling returns linear values
+    bool *is_normal_map = (bool*) calloc(glm::max<size_t>(gltf.images.size(), 1u), sizeof(bool));
+    bool *is_srgb = (bool*) calloc(glm::max<size_t>(gltf.images.size(), 1u), sizeof(bool));
+    for(const fastgltf::Material &material : gltf.materials) {
+        if (material.normalTexture.has_value()) {
+            mark_texture_images(gltf, material.normalTexture->textureIndex, is_normal_map);
+        }
+        if (material.pbrData.baseColorTexture.has_value()) {
+            mark_texture_images(gltf, material.pbrData.baseColorTexture->textureIndex, is_srgb);
+        }
+        if (material.emissiveTexture.has_value()) {
+            mark_texture_images(gltf, material.emissiveTexture->textureIndex, is_srgb);
+        }
+    }
+
+    uint32_t texture_count = 0u;
+    for(uint32_t image_idx = 0u; image_idx < gltf.images.size(); image_idx++) {
+        const fastgltf::Image &image = gltf.images[image_idx];
+        const bool image_is_normal_map = is_normal_map[image_idx];
+        const eImageFormats image_format = (is_srgb[image_idx]) ? IMG_FORMAT_RGBA_8BIT_SRGB : IMG_FORMAT_RGBA_8BIT_UNORM;
+
+        // Empty slot, filled by poll_uploads
+        const uint32_t texture_idx = textures->count;
+        textures->push({});
+
+        std::visit(fastgltf::visitor {
+            [&](const fastgltf::sources::URI &uri) {
+                char image_file_dir[512u] = {};
+                if (!get_gltf_uri_path(file, uri.uri, image_file_dir, sizeof(image_file_dir))) {
+                    spdlog::warn("Remote image URI on {}", gltf_file_dir);
+                    return;
+                }
+                loader->load_from_file(image_file_dir, image_format, texture_idx, image_is_normal_map);
+                texture_count++;
+            },
+            [&](const fastgltf::sources::BufferView &view) {
+                const fastgltf::BufferView &buffer_view = gltf.bufferViews[view.bufferViewIndex];
+                const fastgltf::sources::URI *buffer_uri = std::get_if<fastgltf::sources::URI>(&gltf.buffers[buffer_view.bufferIndex].data);
+                if (buffer_uri != nullptr) {
+                    if (!load_from_buffer_file(file, *buffer_uri, buffer_view, loader, image_format, texture_idx, image_is_normal_map)) {
+                        spdlog::warn("Could not read the image {} from its buffer on {}", image_idx, gltf_file_dir);
+                        return;
+                    }
+                } else {
+                    const fastgltf::DefaultBufferDataAdapter adapter = {};
+                    const auto view_bytes = adapter(gltf, view.bufferViewIndex);
+                    loader->load_from_memory((const uint8_t*) view_bytes.data(), view_bytes.size(), image_format, texture_idx, image_is_normal_map);
+                }
+                texture_count++;
+            },
+            [&](const fastgltf::sources::Array &array) {
+                loader->load_from_memory((const uint8_t*) array.bytes.data(), array.bytes.size(), image_format, texture_idx, image_is_normal_map);
+                texture_count++;
+            },
+            [&](const auto &) {
+                spdlog::warn("Unsupported image source on {}", gltf_file_dir);
+            }
+        }, image.data);
+    }
+
+    free(is_normal_map);
+    free(is_srgb);
+
+    spdlog::info("Queued {} textures from {}", texture_count, gltf_file_dir);
+
+    return texture_count;
+}
\ No newline at end of file
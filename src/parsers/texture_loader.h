@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+
+#include "../render/resources/image_formats.h"
+#include "../utils/dynamic_array.h"
+#include "ktx2_parser.h"
+
+// Upload budget of the decoded textures, at least one texture is uploaded per frame
+#define TEXTURE_UPLOAD_BYTES_PER_FRAME (16u * 1024u * 1024u)
+
+struct sImage;
+
+namespace Render {
+    struct sBackend;
+    struct sFrame;
+};
+
+namespace Parsers {
+    struct sGltfFile;
+
+    // Pixels already on the target format, waiting for the render thread
+    struct sDecodedTexture {
+        uint32_t        texture_idx;
+        eImageFormats   format;
+        uint32_t        width;
+        uint32_t        height;
+        // The levels are packed from the level 0, nullptr if the decode failed
+        uint8_t         *pixels;
+        // Format of the pixels if it is not the target one, converted while staged
+        eImageFormats   source_format = IMG_FORMAT_UNDEF;
+        uint32_t        level_count = 1u;
+        // Only the level 0 is decoded, the chain is generated on upload
+        bool            generate_mips = true;
+        uint64_t        data_size = 0u;
+    };
+
+    /**
+    * PNG/JPEG decode (stb_image) & KTX2 load/transcode on the job system workers.
+    * The decoded textures are queued, and poll_uploads() creates the images & stages
+    * their pixels from the render thread, a few per frame, so it never waits for a decode.
+    * Textures are slots of the renderer's texture list, empty (no VkImage) until their upload.
+    */
+    struct sTextureLoader {
+        std::mutex                      decoded_mutex;
+        sDynamicArray<sDecodedTexture>  decoded_textures = {};
+
+        // Requested but not uploaded yet, & still on a worker
+        std::atomic<uint32_t>           pending_count = 0u;
+        std::atomic<uint32_t>           decoding_count = 0u;
+
+        // Set before the first load, read from the workers
+        sTranscodeFormats               transcode_formats = {};
+
+        void select_transcode_formats(const Render::sBackend &renderer);
+
+        // The format is for the PNG/JPEG decode, KTX2 textures keep theirs, or are transcoded to the transcode_formats
+        void load_from_file(const char* file_dir, const eImageFormats format, const uint32_t texture_idx, const bool is_normal_map = false);
+        // The encoded bytes are copied, they can be freed after the call
+        void load_from_memory(const uint8_t *data, const uint64_t size, const eImageFormats format, const uint32_t texture_idx, const bool is_normal_map = false);
+
+        // Render thread only. Returns the number of textures uploaded
+        uint32_t poll_uploads(Render::sBackend *renderer, Render::sFrame *frame_to_upload);
+
+        inline bool is_idle() const {
+            return pending_count.load() == 0u;
+        }
+
+        // Waits for the decodes in flight, and drops the ones not uploaded
+        void clean();
+    };
+
+    // Queues the decode of every image of the glTF (KHR_texture_basisu included), appended to the texture list
+    // PNG/JPEG images are decoded to RGBA8. The encoded data is copied, the file can be released after the call
+    uint32_t gltf_to_textures(  const sGltfFile &file,
+                                sTextureLoader *loader,
+                                sDynamicArray<sImage> *textures);
+};
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "vertex_interleave.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "../render/resources/gpu_mesh.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define VERTEX_INTERLEAVE_SSE
+#include <emmintrin.h>
+#endif
+
+// The kernel stores the vertex as 5 float4, with the pads taking the w lanes
+static_assert(sizeof(Render::sVertex) == 80u);
+static_assert(offsetof(Render::sVertex, normal) == 16u);
+static_assert(offsetof(Render::sVertex, uv) == 32u);
+static_assert(offsetof(Render::sVertex, tangent) == 48u);
+static_assert(offsetof(Render::sVertex, color) == 64u);
+
+#ifdef VERTEX_INTERLEAVE_SSE
+
+// 12 byte load that does not read past the element (the last vertex can end the buffer)
+static inline __m128 load_float3(const uint8_t *src) {
+    const __m128 xy = _mm_castpd_ps(_mm_load_sd((const double*) src));
+    const __m128 z = _mm_load_ss((const float*) (src + 8u));
+    return _mm_movelh_ps(xy, z);
+}
+
+static inline __m128 load_float2(const uint8_t *src) {
+    return _mm_castpd_ps(_mm_load_sd((const double*) src));
+}
+
+void Parsers::interleave_vertices(  const sVertexStreams &streams,
+                                    const uint32_t vertex_count,
+                                    Render::sVertex *result) {
+    const __m128 zero = _mm_setzero_ps();
+    // w = 1.0 mask for the colors
+    const __m128 w_one = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    const __m128 xyz_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+
+    const uint8_t *position = streams.position.data;
+    const uint8_t *normal = streams.normal.data;
+    const uint8_t *tangent = streams.tangent.data;
+    const uint8_t *uv = streams.uv.data;
+    const uint8_t *color = streams.color.data;
+
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        float *dst = (float*) &result[i];
+
+        const __m128 vertex_normal = (normal) ? load_float3(normal) : zero;
+
+        __m128 vertex_color = vertex_normal;
+        if (color) {
+            vertex_color = load_float3(color);
+        }
+        vertex_color = _mm_or_ps(_mm_and_ps(vertex_color, xyz_mask), w_one);
+
+        _mm_storeu_ps(dst, load_float3(position));
+        _mm_storeu_ps(dst + 4u, vertex_normal);
+        _mm_storeu_ps(dst + 8u, (uv) ? load_float2(uv) : zero);
+        _mm_storeu_ps(dst + 12u, (tangent) ? load_float3(tangent) : zero);
+        _mm_storeu_ps(dst + 16u, vertex_color);
+
+        position += streams.position.stride;
+        if (normal) normal += streams.normal.stride;
+        if (tangent) tangent += streams.tangent.stride;
+        if (uv) uv += streams.uv.stride;
+        if (color) color += streams.color.stride;
+    }
+}
+
+void Parsers::widen_indices(const uint8_t *src,
+                            const uint32_t index_size,
+                            const uint32_t index_count,
+                            const uint32_t base_vertex,
+                            uint32_t *result) {
+    const __m128i base = _mm_set1_epi32((int32_t) base_vertex);
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t i = 0u;
+    if (index_size == 4u) {
+        for(; i + 4u <= index_count; i += 4u) {
+            const __m128i idx = _mm_loadu_si128((const __m128i*) (src + i * 4u));
+            _mm_storeu_si128((__m128i*) &result[i], _mm_add_epi32(idx, base));
+        }
+    } else if (index_size == 2u) {
+        for(; i + 8u <= index_count; i += 8u) {
+            const __m128i idx = _mm_loadu_si128((const __m128i*) (src + i * 2u));
+            _mm_storeu_si128((__m128i*) &result[i], _mm_add_epi32(_mm_unpacklo_epi16(idx, zero), base));
+            _mm_storeu_si128((__m128i*) &result[i + 4u], _mm_add_epi32(_mm_unpackhi_epi16(idx, zero), base));
+        }
+    }
+
+    // Tail, and the 8 bit indices
+    for(; i < index_count; i++) {
+        uint32_t idx = 0u;
+        memcpy(&idx, src + i * index_size, index_size);
+        result[i] = idx + base_vertex;
+    }
+}
+
+#else
+
+void Parsers::interleave_vertices(  const sVertexStreams &streams,
+                                    const uint32_t vertex_count,
+                                    Render::sVertex *result) {
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        Render::sVertex &vertex = result[i];
+        vertex = {};
+
+        memcpy(&vertex.position, streams.position.data + i * streams.position.stride, sizeof(glm::vec3));
+        if (streams.normal.data) {
+            memcpy(&vertex.normal, streams.normal.data + i * streams.normal.stride, sizeof(glm::vec3));
+        }
+        if (streams.tangent.data) {
+            memcpy(&vertex.tangent, streams.tangent.data + i * streams.tangent.stride, sizeof(glm::vec3));
+        }
+        if (streams.uv.data) {
+            memcpy(&vertex.uv, streams.uv.data + i * streams.uv.stride, sizeof(glm::vec2));
+        }
+
+        glm::vec3 color = vertex.normal;
+        if (streams.color.data) {
+            memcpy(&color, streams.color.data + i * streams.color.stride, sizeof(glm::vec3));
+        }
+        vertex.color = glm::vec4(color, 1.0f);
+    }
+}
+
+void Parsers::widen_indices(const uint8_t *src,
+                            const uint32_t index_size,
+                            const uint32_t index_count,
+                            const uint32_t base_vertex,
+                            uint32_t *result) {
+    for(uint32_t i = 0u; i < index_count; i++) {
+        uint32_t idx = 0u;
+        memcpy(&idx, src + i * index_size, index_size);
+        result[i] = idx + base_vertex;
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Render {
+    struct sVertex;
+};
+
+namespace Parsers {
+
+    // Raw view of a tightly typed float accessor, nullptr data if the primitive does not have it
+    struct sAttributeStream {
+        const uint8_t   *data = nullptr;
+        uint32_t        stride = 0u;
+    };
+
+    struct sVertexStreams {
+        sAttributeStream    position;
+        sAttributeStream    normal;
+        sAttributeStream    tangent;
+        sAttributeStream    uv;
+        sAttributeStream    color;
+    };
+
+    /**
+    * Writes whole sVertex records in a single sweep over the raw accessor data,
+    * instead of a pass per attribute. Without a color stream the normal is used as color,
+    * same as the generic path.
+    */
+    void interleave_vertices(   const sVertexStreams &streams,
+                                const uint32_t vertex_count,
+                                Render::sVertex *result);
+
+    // index_size of 1, 2 or 4 bytes, base_vertex is added to all the indices
+    void widen_indices( const uint8_t *src,
+                        const uint32_t index_size,
+                        const uint32_t index_count,
+                        const uint32_t base_vertex,
+                        uint32_t *result);
+};
\ No newline at end of file
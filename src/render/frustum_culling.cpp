@@ -0,0 +1,290 @@
+#include "frustum_culling.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+#if defined(__AVX2__)
+#define FRUSTUM_CULLING_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define FRUSTUM_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Normal & distance, plus the abs of the normal for the AABB projected radius
+struct sCullingPlane {
+    float   nx, ny, nz, w;
+    float   abs_nx, abs_ny, abs_nz;
+};
+
+static inline uint32_t count_trailing_zeros(const uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (uint32_t) idx;
+#else
+    return (uint32_t) __builtin_ctz(mask);
+#endif
+}
+
+static void prepare_planes(const Render::sFrustumPlanes *views, const uint32_t view_count, sCullingPlane planes[FRUSTUM_CULLING_MAX_VIEWS][6u]) {
+    for(uint32_t view = 0u; view < view_count; view++) {
+        for(uint32_t i = 0u; i < 6u; i++) {
+            const glm::vec4 &plane = views[view].planes[i];
+            planes[view][i] = {
+                .nx = plane.x, .ny = plane.y, .nz = plane.z, .w = plane.w,
+                .abs_nx = glm::abs(plane.x), .abs_ny = glm::abs(plane.y), .abs_nz = glm::abs(plane.z)
+            };
+        }
+    }
+}
+
+// Also the tail of the SIMD kernels
+static void cull_bounds_scalar(     const Render::sCullingBounds &bounds, 
+                                    const uint32_t first, 
+                                    const uint32_t end, 
+                                    const sCullingPlane planes[FRUSTUM_CULLING_MAX_VIEWS][6u], 
+                                    const uint32_t view_count, 
+                                    sDynamicArray<uint32_t> *visible_lists) {
+    for(uint32_t i = first; i < end; i++) {
+        for(uint32_t view = 0u; view < view_count; view++) {
+            bool is_visible = true;
+            for(uint32_t p = 0u; p < 6u && is_visible; p++) {
+                const sCullingPlane &plane = planes[view][p];
+                const float distance = plane.nx * bounds.center_x[i] + plane.ny * bounds.center_y[i] + plane.nz * bounds.center_z[i] + plane.w;
+                const float box_radius = plane.abs_nx * bounds.extent_x[i] + plane.abs_ny * bounds.extent_y[i] + plane.abs_nz * bounds.extent_z[i];
+                const float radius = (box_radius < bounds.radius[i]) ? box_radius : bounds.radius[i];
+                is_visible = distance + radius >= 0.0f;
+            }
+
+            if (is_visible) {
+                sDynamicArray<uint32_t> &visible = visible_lists[view];
+                visible.data[visible.count++] = i;
+            }
+        }
+    }
+}
+
+#if defined(FRUSTUM_CULLING_AVX)
+
+static uint32_t cull_bounds_simd(   const Render::sCullingBounds &bounds, 
+                                    const sCullingPlane planes[FRUSTUM_CULLING_MAX_VIEWS][6u], 
+                                    const uint32_t view_count, 
+                                    sDynamicArray<uint32_t> *visible_lists) {
+    const uint32_t simd_end = bounds.count & ~7u;
+    const __m256 zero = _mm256_setzero_ps();
+
+    for(uint32_t i = 0u; i < simd_end; i += 8u) {
+        const __m256 center_x = _mm256_loadu_ps(bounds.center_x + i);
+        const __m256 center_y = _mm256_loadu_ps(bounds.center_y + i);
+        const __m256 center_z = _mm256_loadu_ps(bounds.center_z + i);
+        const __m256 extent_x = _mm256_loadu_ps(bounds.extent_x + i);
+        const __m256 extent_y = _mm256_loadu_ps(bounds.extent_y + i);
+        const __m256 extent_z = _mm256_loadu_ps(bounds.extent_z + i);
+        const __m256 radius = _mm256_loadu_ps(bounds.radius + i);
+
+        for(uint32_t view = 0u; view < view_count; view++) {
+            __m256 is_visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(uint32_t p = 0u; p < 6u; p++) {
+                const sCullingPlane &plane = planes[view][p];
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_broadcast_ss(&plane.nx), center_x), _mm256_broadcast_ss(&plane.w));
+                distance = _mm256_add_ps(_mm256_mul_ps(_mm256_broadcast_ss(&plane.ny), center_y), distance);
+                distance = _mm256_add_ps(_mm256_mul_ps(_mm256_broadcast_ss(&plane.nz), center_z), distance);
+
+                __m256 box_radius = _mm256_mul_ps(_mm256_broadcast_ss(&plane.abs_nx), extent_x);
+                box_radius = _mm256_add_ps(_mm256_mul_ps(_mm256_broadcast_ss(&plane.abs_ny), extent_y), box_radius);
+                box_radius = _mm256_add_ps(_mm256_mul_ps(_mm256_broadcast_ss(&plane.abs_nz), extent_z), box_radius);
+
+                const __m256 signed_distance = _mm256_add_ps(distance, _mm256_min_ps(box_radius, radius));
+                is_visible = _mm256_and_ps(is_visible, _mm256_cmp_ps(signed_distance, zero, _CMP_GE_OQ));
+            }
+
+            uint32_t visible_mask = (uint32_t) _mm256_movemask_ps(is_visible);
+            sDynamicArray<uint32_t> &visible = visible_lists[view];
+            while(visible_mask != 0u) {
+                visible.data[visible.count++] = i + count_trailing_zeros(visible_mask);
+                visible_mask &= visible_mask - 1u;
+            }
+        }
+    }
+
+    return simd_end;
+}
+
+#elif defined(FRUSTUM_CULLING_SSE)
+
+static uint32_t cull_bounds_simd(   const Render::sCullingBounds &bounds, 
+                                    const sCullingPlane planes[FRUSTUM_CULLING_MAX_VIEWS][6u], 
+                                    const uint32_t view_count, 
+                                    sDynamicArray<uint32_t> *visible_lists) {
+    const uint32_t simd_end = bounds.count & ~3u;
+    const __m128 zero = _mm_setzero_ps();
+
+    for(uint32_t i = 0u; i < simd_end; i += 4u) {
+        const __m128 center_x = _mm_loadu_ps(bounds.center_x + i);
+        const __m128 center_y = _mm_loadu_ps(bounds.center_y + i);
+        const __m128 center_z = _mm_loadu_ps(bounds.center_z + i);
+        const __m128 extent_x = _mm_loadu_ps(bounds.extent_x + i);
+        const __m128 extent_y = _mm_loadu_ps(bounds.extent_y + i);
+        const __m128 extent_z = _mm_loadu_ps(bounds.extent_z + i);
+        const __m128 radius = _mm_loadu_ps(bounds.radius + i);
+
+        for(uint32_t view = 0u; view < view_count; view++) {
+            __m128 is_visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(uint32_t p = 0u; p < 6u; p++) {
+                const sCullingPlane &plane = planes[view][p];
+                __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.nx), center_x), _mm_set1_ps(plane.w));
+                distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.ny), center_y), distance);
+                distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.nz), center_z), distance);
+
+                __m128 box_radius = _mm_mul_ps(_mm_set1_ps(plane.abs_nx), extent_x);
+                box_radius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.abs_ny), extent_y), box_radius);
+                box_radius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.abs_nz), extent_z), box_radius);
+
+                const __m128 signed_distance = _mm_add_ps(distance, _mm_min_ps(box_radius, radius));
+                is_visible = _mm_and_ps(is_visible, _mm_cmpge_ps(signed_distance, zero));
+            }
+
+            uint32_t visible_mask = (uint32_t) _mm_movemask_ps(is_visible);
+            sDynamicArray<uint32_t> &visible = visible_lists[view];
+            while(visible_mask != 0u) {
+                visible.data[visible.count++] = i + count_trailing_zeros(visible_mask);
+                visible_mask &= visible_mask - 1u;
+            }
+        }
+    }
+
+    return simd_end;
+}
+
+#else
+
+static uint32_t cull_bounds_simd(   const Render::sCullingBounds &bounds, 
+                                    const sCullingPlane planes[FRUSTUM_CULLING_MAX_VIEWS][6u], 
+                                    const uint32_t view_count, 
+                                    sDynamicArray<uint32_t> *visible_lists) {
+    return 0u;
+}
+
+#endif
+
+void Render::sCullingBounds::resize(const uint32_t new_count) {
+    if (new_count > capacity) {
+        uint32_t new_capacity = (capacity == 0u) ? 1024u : capacity;
+        while(new_capacity < new_count) {
+            new_capacity *= 2u;
+        }
+
+        center_x = (float*) realloc(center_x, sizeof(float) * new_capacity);
+        center_y = (float*) realloc(center_y, sizeof(float) * new_capacity);
+        center_z = (float*) realloc(center_z, sizeof(float) * new_capacity);
+        extent_x = (float*) realloc(extent_x, sizeof(float) * new_capacity);
+        extent_y = (float*) realloc(extent_y, sizeof(float) * new_capacity);
+        extent_z = (float*) realloc(extent_z, sizeof(float) * new_capacity);
+        radius = (float*) realloc(radius, sizeof(float) * new_capacity);
+        capacity = new_capacity;
+    }
+
+    count = new_count;
+}
+
+void Render::sCullingBounds::clean() {
+    free(center_x);
+    free(center_y);
+    free(center_z);
+    free(extent_x);
+    free(extent_y);
+    free(extent_z);
+    free(radius);
+
+    *this = {};
+}
+
+void Render::cull_bounds(   const sCullingBounds &bounds, 
+                            const sFrustumPlanes *views, 
+                            const uint32_t view_count, 
+                            sDynamicArray<uint32_t> *visible_lists) {
+    assert(view_count <= FRUSTUM_CULLING_MAX_VIEWS && "Too many views for a culling pass");
+
+    sCullingPlane planes[FRUSTUM_CULLING_MAX_VIEWS][6u];
+    prepare_planes(views, view_count, planes);
+
+    // Sized for everything visible, so the kernels write without checks
+    for(uint32_t view = 0u; view < view_count; view++) {
+        visible_lists[view].clear();
+        visible_lists[view].reserve(bounds.count);
+    }
+
+    const uint32_t simd_end = cull_bounds_simd(bounds, planes, view_count, visible_lists);
+    cull_bounds_scalar(bounds, simd_end, bounds.count, planes, view_count, visible_lists);
+}
+
+void Render::benchmark_frustum_culling(const uint32_t object_count) {
+    sCullingBounds bounds = {};
+    bounds.resize(object_count);
+
+    // Objects spread on a 200 units cube around the views
+    srand(1234u);
+    for(uint32_t i = 0u; i < object_count; i++) {
+        const glm::vec3 center = glm::vec3(rand() / (float) RAND_MAX, rand() / (float) RAND_MAX, rand() / (float) RAND_MAX) * 200.0f - 100.0f;
+        const glm::vec3 extent = glm::vec3(rand() / (float) RAND_MAX, rand() / (float) RAND_MAX, rand() / (float) RAND_MAX) * 2.0f + 0.1f;
+        bounds.set(i, center, extent, glm::length(extent));
+    }
+
+    // Perspective frustums along each axis, 90 degrees, from the origin to 60 units
+    const float inv_sqrt2 = 0.70710678f;
+    sFrustumPlanes views[FRUSTUM_CULLING_MAX_VIEWS] = {};
+    for(uint32_t view = 0u; view < FRUSTUM_CULLING_MAX_VIEWS; view++) {
+        const float axis_sign = (view & 1u) ? -1.0f : 1.0f;
+        const uint32_t axis = view / 2u;
+        glm::vec3 forward = glm::vec3(0.0f), side = glm::vec3(0.0f), up = glm::vec3(0.0f);
+        forward[axis] = axis_sign;
+        side[(axis + 1u) % 3u] = 1.0f;
+        up[(axis + 2u) % 3u] = 1.0f;
+
+        views[view].planes[0u] = glm::vec4((forward + side) * inv_sqrt2, 0.0f);
+        views[view].planes[1u] = glm::vec4((forward - side) * inv_sqrt2, 0.0f);
+        views[view].planes[2u] = glm::vec4((forward + up) * inv_sqrt2, 0.0f);
+        views[view].planes[3u] = glm::vec4((forward - up) * inv_sqrt2, 0.0f);
+        views[view].planes[4u] = glm::vec4(forward, -0.1f);
+        views[view].planes[5u] = glm::vec4(-forward, 60.0f);
+    }
+
+    sDynamicArray<uint32_t> visible_lists[FRUSTUM_CULLING_MAX_VIEWS] = {};
+    sCullingPlane planes[FRUSTUM_CULLING_MAX_VIEWS][6u];
+    prepare_planes(views, FRUSTUM_CULLING_MAX_VIEWS, planes);
+
+    for(uint32_t view_count = 1u; view_count <= FRUSTUM_CULLING_MAX_VIEWS; view_count *= 2u) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(uint32_t view = 0u; view < view_count; view++) {
+            visible_lists[view].clear();
+            visible_lists[view].reserve(object_count);
+        }
+        cull_bounds_scalar(bounds, 0u, object_count, planes, view_count, visible_lists);
+        const double scalar_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const uint32_t scalar_visible_count = visible_lists[0u].count;
+
+        start = std::chrono::steady_clock::now();
+        cull_bounds(bounds, views, view_count, visible_lists);
+        const double kernel_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        spdlog::info("Frustum culling, {} objects & {} views: scalar {:.2f} ms, kernel {:.2f} ms ({} visible on the first view, {} on the scalar path)",
+                        object_count,
+                        view_count,
+                        scalar_time * 1e3,
+                        kernel_time * 1e3,
+                        visible_lists[0u].count,
+                        scalar_visible_count);
+    }
+
+    for(uint32_t view = 0u; view < FRUSTUM_CULLING_MAX_VIEWS; view++) {
+        visible_lists[view].clean();
+    }
+    bounds.clean();
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "../utils/dynamic_array.h"
+
+// Views tested on a single pass over the bounds
+#define FRUSTUM_CULLING_MAX_VIEWS 4u
+// Culls random bounds with the kernel & the scalar path on startup and logs the throughput
+#define FRUSTUM_CULLING_BENCHMARK false
+#define FRUSTUM_CULLING_BENCHMARK_COUNT 1000000u
+
+namespace Render {
+    // World space planes, normals pointing inside (sCamera::get_frustum_planes)
+    struct sFrustumPlanes {
+        glm::vec4   planes[6u];
+    };
+
+    /**
+    * World space bounds on structure of arrays, for the culling kernels:
+    * an AABB (center & half extents) and the radius of a sphere on the same center.
+    * An object is culled if either of them is outside of a plane.
+    */
+    struct sCullingBounds {
+        uint32_t    count = 0u;
+        uint32_t    capacity = 0u;
+
+        float       *center_x = nullptr;
+        float       *center_y = nullptr;
+        float       *center_z = nullptr;
+        float       *extent_x = nullptr;
+        float       *extent_y = nullptr;
+        float       *extent_z = nullptr;
+        float       *radius = nullptr;
+
+        // Keeps the content up to the old count
+        void resize(const uint32_t new_count);
+
+        inline void set(const uint32_t idx, const glm::vec3 &center, const glm::vec3 &extent, const float sphere_radius) {
+            center_x[idx] = center.x;
+            center_y[idx] = center.y;
+            center_z[idx] = center.z;
+            extent_x[idx] = extent.x;
+            extent_y[idx] = extent.y;
+            extent_z[idx] = extent.z;
+            radius[idx] = sphere_radius;
+        }
+
+        void clean();
+    };
+
+    /**
+    * Frustum test of all the bounds against up to FRUSTUM_CULLING_MAX_VIEWS views, loading each bound once
+    * (AVX2 8 wide if enabled on the build, SSE2 4 wide, scalar fallback).
+    * visible_lists[view] is overwritten with the compacted indices of the objects visible on that view, in order.
+    */
+    void cull_bounds(   const sCullingBounds &bounds, 
+                        const sFrustumPlanes *views, 
+                        const uint32_t view_count, 
+                        sDynamicArray<uint32_t> *visible_lists);
+
+    void benchmark_frustum_culling(const uint32_t object_count);
+};
\ No newline at end of file
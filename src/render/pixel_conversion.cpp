@@ -0,0 +1,395 @@
+#include "pixel_conversion.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "resources/resources.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PIXEL_CONVERSION_SSE
+#include <emmintrin.h>
+#endif
+
+struct sSRGBTables {
+    float       to_linear[256u];
+    uint8_t     to_linear_8bit[256u];
+    uint8_t     to_srgb_8bit[256u];
+
+    sSRGBTables() {
+        for(uint32_t i = 0u; i < 256u; i++) {
+            const float value = i / 255.0f;
+            to_linear[i] = (value <= 0.04045f) ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+            to_linear_8bit[i] = (uint8_t) (to_linear[i] * 255.0f + 0.5f);
+
+            const float srgb = (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+            to_srgb_8bit[i] = (uint8_t) (srgb * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const sSRGBTables& get_srgb_tables() {
+    static const sSRGBTables tables;
+    return tables;
+}
+
+// The sRGB formats are the same bytes, only the sampling decodes them
+static inline bool is_rgba_8bit(const eImageFormats format) {
+    return  format == IMG_FORMAT_RGBA_8BIT_UNORM || format == IMG_FORMAT_RGBA_8BIT_UINT || format == IMG_FORMAT_BRGA_8BIT_UNORM || 
+            format == IMG_FORMAT_RGBA_8BIT_SRGB || format == IMG_FORMAT_BRGA_8BIT_SRGB;
+}
+
+static inline bool is_bgra_8bit(const eImageFormats format) {
+    return format == IMG_FORMAT_BRGA_8BIT_UNORM || format == IMG_FORMAT_BRGA_8BIT_SRGB;
+}
+
+static inline bool is_rgba_float(const eImageFormats format) {
+    return format == IMG_FORMAT_RGBA_32BIT_SFLOAT || format == IMG_FORMAT_RGBA_16BIT_SFLOAT;
+}
+
+// ===================================
+// KERNELS
+// ===================================
+
+// Only the alpha & the RGB LUTs are scalar, there is no gather on SSE2
+
+static void expand_rgb_to_rgba(const uint8_t *src, uint32_t *dst, const uint64_t count) {
+    uint64_t i = 0u;
+#ifdef PIXEL_CONVERSION_SSE
+    const __m128i alpha = _mm_set1_epi32((int32_t) 0xFF000000u);
+    // 4 byte loads, that read the first byte of the next pixel, so the last one is done apart
+    for(; i + 4u < count; i += 4u) {
+        uint32_t pixels[4u];
+        memcpy(&pixels[0u], src + i * 3u, sizeof(uint32_t));
+        memcpy(&pixels[1u], src + i * 3u + 3u, sizeof(uint32_t));
+        memcpy(&pixels[2u], src + i * 3u + 6u, sizeof(uint32_t));
+        memcpy(&pixels[3u], src + i * 3u + 9u, sizeof(uint32_t));
+
+        const __m128i rgbx = _mm_loadu_si128((const __m128i*) pixels);
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_or_si128(rgbx, alpha));
+    }
+#endif
+    for(; i < count; i++) {
+        const uint8_t *pixel = src + i * 3u;
+        dst[i] = pixel[0u] | (pixel[1u] << 8u) | (pixel[2u] << 16u) | 0xFF000000u;
+    }
+}
+
+static void swap_red_blue(const uint32_t *src, uint32_t *dst, const uint64_t count) {
+    uint64_t i = 0u;
+#ifdef PIXEL_CONVERSION_SSE
+    const __m128i green_alpha_mask = _mm_set1_epi32((int32_t) 0xFF00FF00u);
+    for(; i + 4u <= count; i += 4u) {
+        const __m128i pixels = _mm_loadu_si128((const __m128i*) (src + i));
+        const __m128i green_alpha = _mm_and_si128(pixels, green_alpha_mask);
+        // Red & blue on the low byte of each 16 bit half, swap the halves
+        __m128i red_blue = _mm_andnot_si128(green_alpha_mask, pixels);
+        red_blue = _mm_shufflelo_epi16(red_blue, _MM_SHUFFLE(2, 3, 0, 1));
+        red_blue = _mm_shufflehi_epi16(red_blue, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_or_si128(green_alpha, red_blue));
+    }
+#endif
+    for(; i < count; i++) {
+        const uint32_t pixel = src[i];
+        dst[i] = (pixel & 0xFF00FF00u) | ((pixel & 0xFFu) << 16u) | ((pixel >> 16u) & 0xFFu);
+    }
+}
+
+static void apply_rgb_lut(uint32_t *pixels, const uint64_t count, const uint8_t *lut) {
+    for(uint64_t i = 0u; i < count; i++) {
+        const uint32_t pixel = pixels[i];
+        pixels[i] = lut[pixel & 0xFFu] | (lut[(pixel >> 8u) & 0xFFu] << 8u) | (lut[(pixel >> 16u) & 0xFFu] << 16u) | (pixel & 0xFF000000u);
+    }
+}
+
+static void premultiply_rgba_8bit(uint32_t *pixels, const uint64_t count) {
+    uint64_t i = 0u;
+#ifdef PIXEL_CONVERSION_SSE
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i alpha_mask = _mm_set1_epi32((int32_t) 0xFF000000u);
+    for(; i + 4u <= count; i += 4u) {
+        const __m128i rgba = _mm_loadu_si128((const __m128i*) (pixels + i));
+
+        // x * a / 255, rounded: (t + (t >> 8)) >> 8 with t = x * a + 128
+        __m128i low = _mm_unpacklo_epi8(rgba, zero);
+        __m128i high = _mm_unpackhi_epi8(rgba, zero);
+        const __m128i low_alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(low, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128i high_alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(high, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        low = _mm_add_epi16(_mm_mullo_epi16(low, low_alpha), round);
+        high = _mm_add_epi16(_mm_mullo_epi16(high, high_alpha), round);
+        low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+        high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+        const __m128i premultiplied = _mm_packus_epi16(low, high);
+        _mm_storeu_si128((__m128i*) (pixels + i), _mm_or_si128(_mm_andnot_si128(alpha_mask, premultiplied), _mm_and_si128(rgba, alpha_mask)));
+    }
+#endif
+    for(; i < count; i++) {
+        const uint32_t pixel = pixels[i];
+        const uint32_t alpha = pixel >> 24u;
+        uint32_t result = pixel & 0xFF000000u;
+        for(uint32_t c = 0u; c < 3u; c++) {
+            const uint32_t t = ((pixel >> (c * 8u)) & 0xFFu) * alpha + 128u;
+            result |= ((t + (t >> 8u)) >> 8u) << (c * 8u);
+        }
+        pixels[i] = result;
+    }
+}
+
+static void rgba_8bit_to_float(const uint32_t *src, float *dst, const uint64_t count) {
+    uint64_t i = 0u;
+#ifdef PIXEL_CONVERSION_SSE
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    for(; i + 4u <= count; i += 4u) {
+        const __m128i rgba = _mm_loadu_si128((const __m128i*) (src + i));
+        const __m128i low = _mm_unpacklo_epi8(rgba, zero);
+        const __m128i high = _mm_unpackhi_epi8(rgba, zero);
+
+        float *pixel_dst = dst + i * 4u;
+        _mm_storeu_ps(pixel_dst, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+        _mm_storeu_ps(pixel_dst + 4u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+        _mm_storeu_ps(pixel_dst + 8u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+        _mm_storeu_ps(pixel_dst + 12u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+    }
+#endif
+    for(; i < count; i++) {
+        for(uint32_t c = 0u; c < 4u; c++) {
+            dst[i * 4u + c] = ((src[i] >> (c * 8u)) & 0xFFu) / 255.0f;
+        }
+    }
+}
+
+static void srgb_8bit_to_linear_float(const uint32_t *src, float *dst, const uint64_t count) {
+    const float *to_linear = get_srgb_tables().to_linear;
+    for(uint64_t i = 0u; i < count; i++) {
+        const uint32_t pixel = src[i];
+        dst[i * 4u] = to_linear[pixel & 0xFFu];
+        dst[i * 4u + 1u] = to_linear[(pixel >> 8u) & 0xFFu];
+        dst[i * 4u + 2u] = to_linear[(pixel >> 16u) & 0xFFu];
+        dst[i * 4u + 3u] = (pixel >> 24u) / 255.0f;
+    }
+}
+
+static void premultiply_rgba_float(float *pixels, const uint64_t count) {
+    uint64_t i = 0u;
+#ifdef PIXEL_CONVERSION_SSE
+    const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    for(; i < count; i++) {
+        const __m128 rgba = _mm_loadu_ps(pixels + i * 4u);
+        const __m128 premultiplied = _mm_mul_ps(rgba, _mm_shuffle_ps(rgba, rgba, _MM_SHUFFLE(3, 3, 3, 3)));
+        _mm_storeu_ps(pixels + i * 4u, _mm_or_ps(_mm_and_ps(rgb_mask, premultiplied), _mm_andnot_ps(rgb_mask, rgba)));
+    }
+#endif
+    for(; i < count; i++) {
+        const float alpha = pixels[i * 4u + 3u];
+        pixels[i * 4u] *= alpha;
+        pixels[i * 4u + 1u] *= alpha;
+        pixels[i * 4u + 2u] *= alpha;
+    }
+}
+
+#ifdef PIXEL_CONVERSION_SSE
+// Rounds half up, denormals included (magic number scaling)
+static inline __m128i float_to_half_sse(const __m128 value) {
+    const __m128i f32_infinity = _mm_set1_epi32(255 << 23);
+    const __m128 round_mask = _mm_castsi128_ps(_mm_set1_epi32(~0xFFF));
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(15 << 23));
+    const __m128 clamp = _mm_castsi128_ps(_mm_set1_epi32((31 << 23) - 0x1000));
+
+    const __m128 sign = _mm_and_ps(_mm_castsi128_ps(_mm_set1_epi32((int32_t) 0x80000000u)), value);
+    const __m128 abs_value = _mm_xor_ps(value, sign);
+    const __m128i abs_bits = _mm_castps_si128(abs_value);
+
+    const __m128i is_nan = _mm_cmpgt_epi32(abs_bits, f32_infinity);
+    const __m128i is_normal = _mm_cmpgt_epi32(f32_infinity, abs_bits);
+    const __m128i inf_or_nan = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+    const __m128 scaled = _mm_min_ps(_mm_mul_ps(_mm_and_ps(abs_value, round_mask), magic), clamp);
+    const __m128i biased = _mm_sub_epi32(_mm_castps_si128(scaled), _mm_castps_si128(round_mask));
+    const __m128i normal = _mm_and_si128(_mm_srli_epi32(biased, 13), is_normal);
+
+    const __m128i joined = _mm_or_si128(normal, _mm_andnot_si128(is_normal, inf_or_nan));
+    return _mm_or_si128(joined, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+#endif
+
+static void float_to_half(const float *src, uint16_t *dst, const uint64_t value_count) {
+    uint64_t i = 0u;
+#ifdef PIXEL_CONVERSION_SSE
+    for(; i + 8u <= value_count; i += 8u) {
+        // Sign extend the 16 bits, so the saturated pack keeps them
+        const __m128i low = _mm_srai_epi32(_mm_slli_epi32(float_to_half_sse(_mm_loadu_ps(src + i)), 16), 16);
+        const __m128i high = _mm_srai_epi32(_mm_slli_epi32(float_to_half_sse(_mm_loadu_ps(src + i + 4u)), 16), 16);
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for(; i < value_count; i++) {
+        dst[i] = glm::packHalf1x16(src[i]);
+    }
+}
+
+// ===================================
+// CONVERSIONS
+// ===================================
+
+static void convert_float_pixels(   const float *src,
+                                    const eImageFormats src_format,
+                                    uint8_t *dst,
+                                    const eImageFormats dst_format,
+                                    const uint64_t pixel_count,
+                                    const uint32_t flags) {
+    const uint32_t channel_count = (src_format == IMG_FORMAT_RGBA_32BIT_SFLOAT) ? 4u : 1u;
+    const bool premultiply = channel_count == 4u && (flags & PIXEL_CONVERSION_PREMULTIPLY_ALPHA);
+    const bool to_half = dst_format == IMG_FORMAT_RGBA_16BIT_SFLOAT || dst_format == IMG_FORMAT_R_16BIT_SFLOAT;
+
+    if (!premultiply) {
+        float_to_half(src, (uint16_t*) dst, pixel_count * channel_count);
+        return;
+    }
+
+    float chunk[PIXEL_CONVERSION_CHUNK * 4u];
+    for(uint64_t first = 0u; first < pixel_count; first += PIXEL_CONVERSION_CHUNK) {
+        const uint64_t count = glm::min<uint64_t>(PIXEL_CONVERSION_CHUNK, pixel_count - first);
+
+        memcpy(chunk, src + first * 4u, sizeof(float) * 4u * count);
+        premultiply_rgba_float(chunk, count);
+
+        if (to_half) {
+            float_to_half(chunk, ((uint16_t*) dst) + first * 4u, count * 4u);
+        } else {
+            memcpy(((float*) dst) + first * 4u, chunk, sizeof(float) * 4u * count);
+        }
+    }
+}
+
+static void convert_8bit_pixels(const uint8_t *src,
+                                const eImageFormats src_format,
+                                uint8_t *dst,
+                                const eImageFormats dst_format,
+                                const uint64_t pixel_count,
+                                const uint32_t flags) {
+    const bool src_is_bgra = is_bgra_8bit(src_format);
+    const bool dst_is_bgra = is_bgra_8bit(dst_format);
+    const bool src_is_rgb = src_format == IMG_FORMAT_RGB_8BIT_UINT;
+
+    // Straight to the destination, without the intermediate chunk
+    if (flags == PIXEL_CONVERSION_NONE && is_rgba_8bit(dst_format)) {
+        if (src_is_rgb) {
+            expand_rgb_to_rgba(src, (uint32_t*) dst, pixel_count);
+        } else if (src_is_bgra != dst_is_bgra) {
+            swap_red_blue((const uint32_t*) src, (uint32_t*) dst, pixel_count);
+        } else {
+            memcpy(dst, src, sizeof(uint32_t) * pixel_count);
+        }
+        return;
+    }
+
+    const sSRGBTables &srgb_tables = get_srgb_tables();
+    const bool dst_is_float = is_rgba_float(dst_format);
+
+    uint32_t chunk[PIXEL_CONVERSION_CHUNK];
+    float float_chunk[PIXEL_CONVERSION_CHUNK * 4u];
+    for(uint64_t first = 0u; first < pixel_count; first += PIXEL_CONVERSION_CHUNK) {
+        const uint64_t count = glm::min<uint64_t>(PIXEL_CONVERSION_CHUNK, pixel_count - first);
+
+        // To RGBA
+        if (src_is_rgb) {
+            expand_rgb_to_rgba(src + first * 3u, chunk, count);
+        } else if (src_is_bgra) {
+            swap_red_blue(((const uint32_t*) src) + first, chunk, count);
+        } else {
+            memcpy(chunk, ((const uint32_t*) src) + first, sizeof(uint32_t) * count);
+        }
+
+        if (dst_is_float) {
+            if (flags & PIXEL_CONVERSION_SRGB_TO_LINEAR) {
+                srgb_8bit_to_linear_float(chunk, float_chunk, count);
+            } else {
+                rgba_8bit_to_float(chunk, float_chunk, count);
+            }
+
+            if (flags & PIXEL_CONVERSION_PREMULTIPLY_ALPHA) {
+                premultiply_rgba_float(float_chunk, count);
+            }
+
+            if (dst_format == IMG_FORMAT_RGBA_16BIT_SFLOAT) {
+                float_to_half(float_chunk, ((uint16_t*) dst) + first * 4u, count * 4u);
+            } else {
+                memcpy(((float*) dst) + first * 4u, float_chunk, sizeof(float) * 4u * count);
+            }
+            continue;
+        }
+
+        if (flags & PIXEL_CONVERSION_SRGB_TO_LINEAR) {
+            apply_rgb_lut(chunk, count, srgb_tables.to_linear_8bit);
+        }
+        if (flags & PIXEL_CONVERSION_PREMULTIPLY_ALPHA) {
+            premultiply_rgba_8bit(chunk, count);
+        }
+        if (flags & PIXEL_CONVERSION_LINEAR_TO_SRGB) {
+            apply_rgb_lut(chunk, count, srgb_tables.to_srgb_8bit);
+        }
+
+        if (dst_is_bgra) {
+            swap_red_blue(chunk, ((uint32_t*) dst) + first, count);
+        } else {
+            memcpy(((uint32_t*) dst) + first, chunk, sizeof(uint32_t) * count);
+        }
+    }
+}
+
+bool Render::can_convert_pixels(const eImageFormats src_format, const eImageFormats dst_format, const uint32_t flags) {
+    if (src_format == dst_format && flags == PIXEL_CONVERSION_NONE) {
+        return true;
+    }
+
+    if (is_rgba_8bit(src_format) || src_format == IMG_FORMAT_RGB_8BIT_UINT) {
+        // The sRGB encode is only for 8 bit destinations
+        return is_rgba_8bit(dst_format) || (is_rgba_float(dst_format) && !(flags & PIXEL_CONVERSION_LINEAR_TO_SRGB));
+    }
+
+    // Float sources: to half, and premultiplied
+    const uint32_t float_flags = flags & ~PIXEL_CONVERSION_PREMULTIPLY_ALPHA;
+    if (src_format == IMG_FORMAT_RGBA_32BIT_SFLOAT) {
+        return float_flags == PIXEL_CONVERSION_NONE && is_rgba_float(dst_format);
+    }
+    if (src_format == IMG_FORMAT_R_32BIT_SFLOAT) {
+        return float_flags == PIXEL_CONVERSION_NONE && dst_format == IMG_FORMAT_R_16BIT_SFLOAT;
+    }
+
+    return false;
+}
+
+void Render::convert_pixels(const void *src,
+                            const eImageFormats src_format,
+                            void *dst,
+                            const eImageFormats dst_format,
+                            const uint64_t pixel_count,
+                            const uint32_t flags) {
+    assert(can_convert_pixels(src_format, dst_format, flags) && "Pixel conversion not supported");
+
+    if (src_format == dst_format && flags == PIXEL_CONVERSION_NONE) {
+        memcpy(dst, src, get_pixel_size(src_format) * pixel_count);
+        return;
+    }
+
+    if (src_format == IMG_FORMAT_RGBA_32BIT_SFLOAT || src_format == IMG_FORMAT_R_32BIT_SFLOAT) {
+        convert_float_pixels((const float*) src, src_format, (uint8_t*) dst, dst_format, pixel_count, flags);
+    } else {
+        convert_8bit_pixels((const uint8_t*) src, src_format, (uint8_t*) dst, dst_format, pixel_count, flags);
+    }
+}
+
+float Render::srgb_to_linear(const uint8_t value) {
+    return get_srgb_tables().to_linear[value];
+}
+
+uint8_t Render::linear_to_srgb(const float value) {
+    const float linear = glm::clamp(value, 0.0f, 1.0f);
+    const float srgb = (linear <= 0.0031308f) ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+    return (uint8_t) (srgb * 255.0f + 0.5f);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "resources/image_formats.h"
+
+// Pixels per step, the intermediate RGBA is kept on the stack (L1) between the kernels
+#define PIXEL_CONVERSION_CHUNK 256u
+
+enum ePixelConversionFlags : uint32_t {
+    PIXEL_CONVERSION_NONE = 0u,
+    // 8 bit sources, decoded before the rest of the steps
+    PIXEL_CONVERSION_SRGB_TO_LINEAR = 1u << 0u,
+    PIXEL_CONVERSION_PREMULTIPLY_ALPHA = 1u << 1u,
+    // 8 bit destinations, encoded after the rest of the steps
+    PIXEL_CONVERSION_LINEAR_TO_SRGB = 1u << 2u
+};
+
+namespace Render {
+    /**
+    * Pixel format conversion for the texture ingest (SSE2 kernels, scalar fallback):
+    * RGB8 -> RGBA8 expansion, RGBA <-> BGRA swizzles, 8 bit -> float/half, float -> half,
+    * sRGB <-> linear & alpha premultiplication.
+    * The destination is written sequentially and never read, so it can be the mapped staging memory.
+    */
+    bool can_convert_pixels(const eImageFormats src_format, const eImageFormats dst_format, const uint32_t flags = PIXEL_CONVERSION_NONE);
+
+    void convert_pixels(const void *src,
+                        const eImageFormats src_format,
+                        void *dst,
+                        const eImageFormats dst_format,
+                        const uint64_t pixel_count,
+                        const uint32_t flags = PIXEL_CONVERSION_NONE);
+
+    // Single channel sRGB transfer, for the filters that average on linear space
+    float srgb_to_linear(const uint8_t value);
+    uint8_t linear_to_srgb(const float value);
+};
\ No newline at end of file
@@ -0,0 +1,365 @@
+#include "render_graph.h"
+
+#include <cassert>
+
+struct sGraphUsageInfo {
+    VkImageLayout           layout;
+    VkPipelineStageFlags2   stages;
+    VkAccessFlags2          access;
+    bool                    is_write;
+};
+
+// Indexed by eGraphImageUsage
+static const sGraphUsageInfo GRAPH_USAGE_INFOS[GRAPH_IMAGE_USAGE_COUNT] = {
+    { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, false },
+    { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, true },
+    { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, false },
+    { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, true },
+    { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, false },
+    { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, true },
+    { VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true },
+    // The present engine waits on the render semaphore, the transition only has to be done by the end of the frame
+    { VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, false }
+};
+
+uint32_t Render::sRenderGraph::add_persistent_image(const VkImage image, const VkImageAspectFlags aspect) {
+    assert(images.count == persistent_image_count);
+
+    images.push({ .image = image, .aspect = aspect });
+    return persistent_image_count++;
+}
+
+uint32_t Render::sRenderGraph::add_transient_image(const VkImageCreateInfo &create_info, const VkImageAspectFlags aspect) {
+    assert(memory_blocks.count == 0u);
+
+    const uint32_t image_idx = add_persistent_image(VK_NULL_HANDLE, aspect);
+    transient_images.push({
+        .image_idx = image_idx,
+        .create_info = create_info,
+        .requirements = {},
+        .first_pass = UINT32_MAX,
+        .last_pass = 0u,
+        .memory_block_idx = 0u,
+        .alias_prev_idx = UINT32_MAX
+    });
+    return image_idx;
+}
+
+uint32_t Render::sRenderGraph::import_image(const VkImage image, const VkImageAspectFlags aspect, const VkPipelineStageFlags2 prev_stages) {
+    images.push({ .image = image, .aspect = aspect, .write_stages = prev_stages });
+    return images.count - 1u;
+}
+
+void Render::sRenderGraph::begin_frame() {
+    images.count = persistent_image_count;
+    passes.clear();
+    accesses.clear();
+    stats = {};
+}
+
+void Render::sRenderGraph::add_pass(const char *name, const GraphPassFunction execute) {
+    passes.push({
+        .name = name,
+        .execute = execute,
+        .first_access = accesses.count,
+        .access_count = 0u,
+        .is_culled = false
+    });
+}
+
+void Render::sRenderGraph::use_image(const uint32_t image_idx, const eGraphImageUsage usage, const uint32_t flags) {
+    assert(passes.count > 0u && image_idx < images.count);
+
+    accesses.push({ .image_idx = image_idx, .usage = usage, .flags = flags });
+    passes[passes.count - 1u].access_count++;
+}
+
+// Adds the barrier the access needs to the batch (if any), and moves the image to its new state
+static void add_access_barrier( Render::sGraphImage &image, 
+                                const Render::sGraphImageAccess &access, 
+                                sDynamicArray<VkImageMemoryBarrier2> &barriers) {
+    const sGraphUsageInfo &usage = GRAPH_USAGE_INFOS[access.usage];
+    const bool needs_transition = usage.layout != image.layout;
+    const bool is_overwrite = (access.flags & GRAPH_ACCESS_OVERWRITE) != 0u;
+
+    VkImageMemoryBarrier2 barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .dstStageMask = usage.stages,
+        .dstAccessMask = usage.access,
+        // Overwritten content is discarded instead of transitioned
+        .oldLayout = (needs_transition && is_overwrite) ? VK_IMAGE_LAYOUT_UNDEFINED : image.layout,
+        .newLayout = usage.layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image.image,
+        .subresourceRange = {
+            .aspectMask = image.aspect,
+            .baseMipLevel = 0u,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .baseArrayLayer = 0u,
+            .layerCount = VK_REMAINING_ARRAY_LAYERS
+        }
+    };
+
+    if (needs_transition || usage.is_write) {
+        // Waits for the last write & every read since it. Nothing to wait for on the first use without a transition
+        const VkPipelineStageFlags2 prev_stages = image.write_stages | image.read_stages;
+        if (needs_transition || prev_stages != VK_PIPELINE_STAGE_2_NONE) {
+            barrier.srcStageMask = prev_stages;
+            barrier.srcAccessMask = image.write_access;
+            barriers.push(barrier);
+        }
+
+        // The transition is a write for the accesses after it
+        image.layout = usage.layout;
+        image.write_stages = usage.stages;
+        image.write_access = (usage.is_write) ? usage.access : VK_ACCESS_2_NONE;
+        image.read_stages = (usage.is_write) ? VK_PIPELINE_STAGE_2_NONE : usage.stages;
+        image.visible_stages = (usage.is_write) ? VK_PIPELINE_STAGE_2_NONE : usage.stages;
+        return;
+    }
+
+    // Read on the same layout: only the stages that did not wait for the last write yet
+    if (image.write_stages != VK_PIPELINE_STAGE_2_NONE && (usage.stages & ~image.visible_stages) != 0u) {
+        barrier.srcStageMask = image.write_stages;
+        barrier.srcAccessMask = image.write_access;
+        barriers.push(barrier);
+        image.visible_stages |= usage.stages;
+    }
+    image.read_stages |= usage.stages;
+}
+
+// Backwards, tracking if the current content of each image is read later
+// After the frame everything but the transient images is kept: presented, or read by the next frame
+static void cull_passes(Render::sRenderGraph &graph) {
+    graph.is_content_needed.clear();
+    bool *is_needed = graph.is_content_needed.push_n(graph.images.count);
+    for(uint32_t i = 0u; i < graph.images.count; i++) {
+        is_needed[i] = true;
+    }
+    for(uint32_t i = 0u; i < graph.transient_images.count; i++) {
+        is_needed[graph.transient_images[i].image_idx] = false;
+    }
+
+    const Render::sGraphImageAccess *accesses = graph.accesses.data;
+    for(uint32_t p = graph.passes.count; p > 0u; p--) {
+        Render::sGraphPass &pass = graph.passes[p - 1u];
+        pass.is_culled = false;
+
+        bool has_writes = false, has_needed_writes = false;
+        for(uint32_t i = pass.first_access; i < pass.first_access + pass.access_count; i++) {
+            if (GRAPH_USAGE_INFOS[accesses[i].usage].is_write) {
+                has_writes = true;
+                has_needed_writes |= is_needed[accesses[i].image_idx];
+            }
+        }
+
+        // Without image writes the pass has other outputs (buffers), it always runs
+        if (has_writes && !has_needed_writes) {
+            pass.is_culled = true;
+            graph.stats.culled_passes++;
+            continue;
+        }
+
+        // The content before an overwrite is not needed, anything else reads it
+        for(uint32_t i = pass.first_access; i < pass.first_access + pass.access_count; i++) {
+            if (accesses[i].flags & GRAPH_ACCESS_OVERWRITE) {
+                is_needed[accesses[i].image_idx] = false;
+            }
+        }
+        for(uint32_t i = pass.first_access; i < pass.first_access + pass.access_count; i++) {
+            if (!(accesses[i].flags & GRAPH_ACCESS_OVERWRITE)) {
+                is_needed[accesses[i].image_idx] = true;
+            }
+        }
+    }
+}
+
+void Render::sRenderGraph::execute(sBackend &renderer, const VkCommandBuffer cmd) {
+    stats.passes = passes.count;
+
+    cull_passes(*this);
+
+    for(uint32_t p = 0u; p < passes.count; p++) {
+        const sGraphPass &pass = passes[p];
+        if (pass.is_culled) {
+            continue;
+        }
+
+        // Aliasing: the previous image on the memory has to be done before the first use discards the content
+        for(uint32_t i = 0u; i < transient_images.count; i++) {
+            const sGraphTransientImage &transient = transient_images[i];
+            if (transient.first_pass != p || transient.alias_prev_idx == UINT32_MAX) {
+                continue;
+            }
+
+            const sGraphImage &prev = images[transient_images[transient.alias_prev_idx].image_idx];
+            sGraphImage &image = images[transient.image_idx];
+            image.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            image.write_stages = prev.write_stages | prev.read_stages;
+            image.write_access = prev.write_access;
+            image.read_stages = VK_PIPELINE_STAGE_2_NONE;
+            image.visible_stages = VK_PIPELINE_STAGE_2_NONE;
+        }
+
+        barriers.clear();
+        for(uint32_t i = pass.first_access; i < pass.first_access + pass.access_count; i++) {
+            add_access_barrier(images[accesses[i].image_idx], accesses[i], barriers);
+        }
+
+        if (barriers.count > 0u) {
+            VkDependencyInfo dep_info = {
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = nullptr,
+                .imageMemoryBarrierCount = barriers.count,
+                .pImageMemoryBarriers = barriers.data
+            };
+            vkCmdPipelineBarrier2(cmd, &dep_info);
+
+            stats.barrier_batches++;
+            stats.image_barriers += barriers.count;
+        }
+
+        if (pass.execute != nullptr) {
+            pass.execute(renderer);
+        }
+    }
+}
+
+bool Render::sRenderGraph::allocate_transient_images(const VkDevice device, const VmaAllocator allocator) {
+    assert(memory_blocks.count == 0u);
+
+    cull_passes(*this);
+
+    transient_requested_size = 0u;
+    for(uint32_t i = 0u; i < transient_images.count; i++) {
+        sGraphTransientImage &transient = transient_images[i];
+        if (vkCreateImage(device, &transient.create_info, nullptr, &images[transient.image_idx].image) != VK_SUCCESS) {
+            return false;
+        }
+        vkGetImageMemoryRequirements(device, images[transient.image_idx].image, &transient.requirements);
+        transient_requested_size += transient.requirements.size;
+
+        transient.first_pass = UINT32_MAX;
+        transient.last_pass = 0u;
+        for(uint32_t p = 0u; p < passes.count; p++) {
+            if (passes[p].is_culled) {
+                continue;
+            }
+            for(uint32_t j = passes[p].first_access; j < passes[p].first_access + passes[p].access_count; j++) {
+                if (accesses[j].image_idx != transient.image_idx) {
+                    continue;
+                }
+                // The content is garbage on the first use, it can only be overwritten
+                assert(transient.first_pass != UINT32_MAX || (accesses[j].flags & GRAPH_ACCESS_OVERWRITE));
+                transient.first_pass = (transient.first_pass == UINT32_MAX) ? p : transient.first_pass;
+                transient.last_pass = p;
+            }
+        }
+    }
+
+    // Biggest first, so the smaller ones fill the blocks of the bigger ones
+    sDynamicArray<uint32_t> order = {};
+    uint32_t *sorted = order.push_n(transient_images.count);
+    for(uint32_t i = 0u; i < transient_images.count; i++) {
+        uint32_t j = i;
+        for(; j > 0u && transient_images[sorted[j - 1u]].requirements.size < transient_images[i].requirements.size; j--) {
+            sorted[j] = sorted[j - 1u];
+        }
+        sorted[j] = i;
+    }
+
+    for(uint32_t i = 0u; i < transient_images.count; i++) {
+        sGraphTransientImage &transient = transient_images[sorted[i]];
+        const VkMemoryRequirements &requirements = transient.requirements;
+
+        uint32_t block_idx = 0u;
+        for(; block_idx < memory_blocks.count; block_idx++) {
+            if ((memory_blocks[block_idx].requirements.memoryTypeBits & requirements.memoryTypeBits) == 0u) {
+                continue;
+            }
+
+            // Unused images (no passes) overlap nothing
+            bool overlaps = false;
+            for(uint32_t j = 0u; j < i && !overlaps; j++) {
+                const sGraphTransientImage &placed = transient_images[sorted[j]];
+                overlaps = placed.memory_block_idx == block_idx && 
+                            transient.first_pass <= placed.last_pass && 
+                            placed.first_pass <= transient.last_pass;
+            }
+            if (!overlaps) {
+                break;
+            }
+        }
+
+        if (block_idx == memory_blocks.count) {
+            memory_blocks.push({ .allocation = VK_NULL_HANDLE, .requirements = requirements });
+        }
+
+        VkMemoryRequirements &block_requirements = memory_blocks[block_idx].requirements;
+        block_requirements.size = (block_requirements.size > requirements.size) ? block_requirements.size : requirements.size;
+        block_requirements.alignment = (block_requirements.alignment > requirements.alignment) ? block_requirements.alignment : requirements.alignment;
+        block_requirements.memoryTypeBits &= requirements.memoryTypeBits;
+        transient.memory_block_idx = block_idx;
+    }
+    order.clean();
+
+    const VmaAllocationCreateInfo alloc_info = {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+        .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    };
+
+    transient_allocated_size = 0u;
+    for(uint32_t i = 0u; i < memory_blocks.count; i++) {
+        if (vmaAllocateMemory(allocator, &memory_blocks[i].requirements, &alloc_info, &memory_blocks[i].allocation, nullptr) != VK_SUCCESS) {
+            return false;
+        }
+        transient_allocated_size += memory_blocks[i].requirements.size;
+    }
+
+    // Each image waits for the one before it on its block, by first pass. With a single image it keeps its own state
+    for(uint32_t i = 0u; i < transient_images.count; i++) {
+        sGraphTransientImage &transient = transient_images[i];
+        if (vmaBindImageMemory(allocator, memory_blocks[transient.memory_block_idx].allocation, images[transient.image_idx].image) != VK_SUCCESS) {
+            return false;
+        }
+
+        uint32_t prev_idx = UINT32_MAX, last_idx = UINT32_MAX;
+        for(uint32_t j = 0u; j < transient_images.count; j++) {
+            const sGraphTransientImage &other = transient_images[j];
+            if (j == i || other.memory_block_idx != transient.memory_block_idx || other.first_pass == UINT32_MAX) {
+                continue;
+            }
+            if (other.first_pass < transient.first_pass && (prev_idx == UINT32_MAX || other.first_pass > transient_images[prev_idx].first_pass)) {
+                prev_idx = j;
+            }
+            if (last_idx == UINT32_MAX || other.first_pass > transient_images[last_idx].first_pass) {
+                last_idx = j;
+            }
+        }
+        transient.alias_prev_idx = (prev_idx != UINT32_MAX) ? prev_idx : last_idx;
+    }
+
+    return true;
+}
+
+void Render::sRenderGraph::destroy_transient_images(const VkDevice device, const VmaAllocator allocator) {
+    for(uint32_t i = 0u; i < transient_images.count; i++) {
+        vkDestroyImage(device, images[transient_images[i].image_idx].image, nullptr);
+    }
+    for(uint32_t i = 0u; i < memory_blocks.count; i++) {
+        vmaFreeMemory(allocator, memory_blocks[i].allocation);
+    }
+    memory_blocks.clear();
+}
+
+void Render::sRenderGraph::clean() {
+    transient_images.clean();
+    memory_blocks.clean();
+    images.clean();
+    passes.clean();
+    accesses.clean();
+    barriers.clean();
+    is_content_needed.clean();
+}
\ No newline at end of file
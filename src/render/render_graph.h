@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include "../utils/dynamic_array.h"
+
+// How a pass uses an image: the layout, stages & access come from it
+enum eGraphImageUsage : uint32_t {
+    GRAPH_IMAGE_TRANSFER_SRC = 0u,
+    GRAPH_IMAGE_TRANSFER_DST,
+    GRAPH_IMAGE_STORAGE_READ,
+    GRAPH_IMAGE_STORAGE_WRITE,
+    GRAPH_IMAGE_SAMPLED,
+    GRAPH_IMAGE_COLOR_ATTACHMENT,
+    GRAPH_IMAGE_DEPTH_ATTACHMENT,
+    GRAPH_IMAGE_PRESENT,
+    GRAPH_IMAGE_USAGE_COUNT
+};
+
+enum eGraphAccessFlags : uint32_t {
+    GRAPH_ACCESS_NONE = 0u,
+    // Every texel is written without reading the previous content (clears, full screen writes, attachments
+    // with a clear load op). The previous content is discarded, and the pass that wrote it can be culled
+    GRAPH_ACCESS_OVERWRITE = 1u << 0u
+};
+
+namespace Render {
+    struct sBackend;
+
+    typedef void (*GraphPassFunction)(sBackend &renderer);
+
+    // Synchronization state of an image, kept between frames for the persistent ones
+    struct sGraphImage {
+        VkImage                 image = VK_NULL_HANDLE;
+        VkImageAspectFlags      aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        VkImageLayout           layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // Last write (or layout transition), and the reads & stages that already waited for it
+        VkPipelineStageFlags2   write_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2          write_access = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2   read_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkPipelineStageFlags2   visible_stages = VK_PIPELINE_STAGE_2_NONE;
+    };
+
+    struct sGraphImageAccess {
+        uint32_t            image_idx;
+        eGraphImageUsage    usage;
+        uint32_t            flags;
+    };
+
+    struct sGraphPass {
+        const char          *name;
+        // Can be null, for passes that are only transitions (e.g. to present)
+        GraphPassFunction   execute;
+        uint32_t            first_access;
+        uint32_t            access_count;
+        bool                is_culled;
+    };
+
+    // Render target that only lives inside the frame, its memory is shared with the targets used on other passes
+    struct sGraphTransientImage {
+        uint32_t                image_idx;
+        VkImageCreateInfo       create_info;
+        VkMemoryRequirements    requirements;
+        // First & last pass using it, on the frame declared for the allocation
+        uint32_t                first_pass;
+        uint32_t                last_pass;
+        uint32_t                memory_block_idx;
+        // Image on the same memory right before it (the last one of the previous frame for the first), waited on its first use
+        uint32_t                alias_prev_idx;
+    };
+
+    struct sGraphMemoryBlock {
+        VmaAllocation           allocation;
+        VkMemoryRequirements    requirements;
+    };
+
+    struct sRenderGraphStats {
+        uint32_t    passes = 0u;
+        uint32_t    culled_passes = 0u;
+        uint32_t    barrier_batches = 0u;
+        uint32_t    image_barriers = 0u;
+    };
+
+    /**
+    * Frame graph: the passes are added in order each frame, declaring how they use the images.
+    * On execute, passes whose image writes are all overwritten before anyone reads them are culled
+    * (passes without image writes, like the culling dispatches, always run), and before each pass
+    * the barriers it needs are recorded on a single vkCmdPipelineBarrier2, from the tracked state of the images.
+    * Buffers are still synchronized by the passes themselves.
+    * Transient images alias their memory: their first use on the frame discards the content, after the aliased image's last use.
+    */
+    struct sRenderGraph {
+        sDynamicArray<sGraphImage>              images = {};
+        // The images added after this one are only for the current frame (e.g. the swapchain image)
+        uint32_t                                persistent_image_count = 0u;
+
+        sDynamicArray<sGraphPass>               passes = {};
+        sDynamicArray<sGraphImageAccess>        accesses = {};
+        sDynamicArray<VkImageMemoryBarrier2>    barriers = {};
+        sDynamicArray<bool>                     is_content_needed = {};
+
+        sDynamicArray<sGraphTransientImage>     transient_images = {};
+        sDynamicArray<sGraphMemoryBlock>        memory_blocks = {};
+        // Sum of the transient images' sizes, and the memory actually allocated for them
+        uint64_t                                transient_requested_size = 0u;
+        uint64_t                                transient_allocated_size = 0u;
+
+        sRenderGraphStats                       stats = {};
+
+        // Images that live across frames, their state is kept. Only between frames
+        uint32_t add_persistent_image(const VkImage image, const VkImageAspectFlags aspect);
+        // The VkImage is created on allocate_transient_images. Only before it, with the persistent ones
+        uint32_t add_transient_image(const VkImageCreateInfo &create_info, const VkImageAspectFlags aspect);
+        // Image for this frame only, its previous accesses were synchronized up to prev_stages (e.g. the acquire wait)
+        uint32_t import_image(const VkImage image, const VkImageAspectFlags aspect, const VkPipelineStageFlags2 prev_stages);
+
+        void begin_frame();
+
+        void add_pass(const char *name, const GraphPassFunction execute);
+        // Of the last added pass
+        void use_image(const uint32_t image_idx, const eGraphImageUsage usage, const uint32_t flags = GRAPH_ACCESS_NONE);
+
+        void execute(sBackend &renderer, const VkCommandBuffer cmd);
+
+        // From the passes of the current frame (not executed), that every frame has to follow: the transient images
+        // used on disjoint pass ranges get the same memory. Images are sorted by size and placed on the first block without overlaps
+        bool allocate_transient_images(const VkDevice device, const VmaAllocator allocator);
+        void destroy_transient_images(const VkDevice device, const VmaAllocator allocator);
+
+        void clean();
+    };
+};
\ No newline at end of file
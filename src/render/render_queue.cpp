@@ -0,0 +1,113 @@
+#include "render_queue.h"
+
+#include <cassert>
+#include <cstring>
+
+#define RADIX_DIGIT_BITS 8u
+#define RADIX_DIGIT_COUNT (64u / RADIX_DIGIT_BITS)
+#define RADIX_BUCKET_COUNT (1u << RADIX_DIGIT_BITS)
+
+static inline uint32_t quantize_depth(const float view_depth) {
+    if (!(view_depth > 0.0f)) {
+        return 0u;
+    }
+
+    // Positive floats keep their order as integers, the top bits under the sign are a log scale of the depth
+    uint32_t depth_bits;
+    memcpy(&depth_bits, &view_depth, sizeof(uint32_t));
+    return depth_bits >> (31u - RENDER_QUEUE_DEPTH_BITS);
+}
+
+void Render::sRenderQueue::clear() {
+    keys.clear();
+    stats = {};
+}
+
+void Render::sRenderQueue::add( const uint32_t pass, 
+                                const uint32_t pipeline, 
+                                const uint32_t material, 
+                                const float view_depth, 
+                                const uint32_t draw_idx) {
+    assert(pass < (1u << RENDER_QUEUE_PASS_BITS));
+    assert(pipeline < (1u << RENDER_QUEUE_PIPELINE_BITS));
+    assert(material < (1u << RENDER_QUEUE_MATERIAL_BITS));
+    assert(draw_idx < (1u << RENDER_QUEUE_DRAW_BITS));
+
+    uint64_t key = pass;
+    key = (key << RENDER_QUEUE_PIPELINE_BITS) | pipeline;
+    key = (key << RENDER_QUEUE_MATERIAL_BITS) | material;
+    key = (key << RENDER_QUEUE_DEPTH_BITS) | quantize_depth(view_depth);
+    key = (key << RENDER_QUEUE_DRAW_BITS) | draw_idx;
+
+    if (keys.count == 0u || get_state(keys.count - 1u) != (uint32_t) (key >> (RENDER_QUEUE_DEPTH_BITS + RENDER_QUEUE_DRAW_BITS))) {
+        stats.unsorted_state_changes++;
+    }
+
+    keys.push(key);
+}
+
+void Render::sRenderQueue::sort() {
+    const uint32_t count = keys.count;
+    stats.draws = count;
+    if (count <= 1u) {
+        stats.sorted_state_changes = count;
+        return;
+    }
+
+    // The histograms of all the digits on a single read of the keys
+    uint32_t histograms[RADIX_DIGIT_COUNT][RADIX_BUCKET_COUNT];
+    memset(histograms, 0, sizeof(histograms));
+    for(uint32_t i = 0u; i < count; i++) {
+        const uint64_t key = keys.data[i];
+        for(uint32_t digit = 0u; digit < RADIX_DIGIT_COUNT; digit++) {
+            histograms[digit][(key >> (digit * RADIX_DIGIT_BITS)) & (RADIX_BUCKET_COUNT - 1u)]++;
+        }
+    }
+
+    scratch.reserve(count);
+    uint64_t *src = keys.data;
+    uint64_t *dst = scratch.data;
+
+    for(uint32_t digit = 0u; digit < RADIX_DIGIT_COUNT; digit++) {
+        const uint32_t shift = digit * RADIX_DIGIT_BITS;
+        uint32_t *histogram = histograms[digit];
+
+        // Same digit on all the keys (e.g. the unused pipeline & material bits), the order does not change
+        if (histogram[(src[0u] >> shift) & (RADIX_BUCKET_COUNT - 1u)] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0u;
+        for(uint32_t bucket = 0u; bucket < RADIX_BUCKET_COUNT; bucket++) {
+            const uint32_t bucket_count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_count;
+        }
+
+        // Stable scatter, keeps the order of the previous digits
+        for(uint32_t i = 0u; i < count; i++) {
+            const uint64_t key = src[i];
+            dst[histogram[(key >> shift) & (RADIX_BUCKET_COUNT - 1u)]++] = key;
+        }
+
+        uint64_t *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != keys.data) {
+        memcpy(keys.data, src, sizeof(uint64_t) * count);
+    }
+
+    stats.sorted_state_changes = 1u;
+    for(uint32_t i = 1u; i < count; i++) {
+        if (get_state(i) != get_state(i - 1u)) {
+            stats.sorted_state_changes++;
+        }
+    }
+}
+
+void Render::sRenderQueue::clean() {
+    keys.clean();
+    scratch.clean();
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../utils/dynamic_array.h"
+
+// Sort key, from the most significant bits: pass | pipeline | material | view depth | draw index
+#define RENDER_QUEUE_PASS_BITS 2u
+#define RENDER_QUEUE_PIPELINE_BITS 6u
+#define RENDER_QUEUE_MATERIAL_BITS 10u
+#define RENDER_QUEUE_DEPTH_BITS 22u
+#define RENDER_QUEUE_DRAW_BITS 24u
+
+enum eRenderQueuePass : uint32_t {
+    RENDER_PASS_OPAQUE = 0u
+};
+
+enum eRenderQueuePipeline : uint32_t {
+    RENDER_PIPELINE_MESH = 0u
+};
+
+namespace Render {
+    // State changes of the draws on the order they were added & on the sorted order
+    struct sRenderQueueStats {
+        uint32_t    draws = 0u;
+        uint32_t    unsorted_state_changes = 0u;
+        uint32_t    sorted_state_changes = 0u;
+    };
+
+    // Sums of the frames since the last report
+    struct sRenderQueueTotals {
+        uint64_t    frames = 0u;
+        uint64_t    draws = 0u;
+        uint64_t    unsorted_state_changes = 0u;
+        uint64_t    sorted_state_changes = 0u;
+    };
+
+    /**
+    * Draws of a frame as packed 64 bit keys, sorted with an LSD radix sort (8 bits per pass, the passes
+    * where all the keys share the digit are skipped). The draws of a pass are grouped by pipeline & material,
+    * so the binds only change between groups, and each group is ordered front to back for the early-Z.
+    * The draw index is on the low bits, the recording reads it back from the sorted keys.
+    */
+    struct sRenderQueue {
+        sDynamicArray<uint64_t>     keys = {};
+        sDynamicArray<uint64_t>     scratch = {};
+        sRenderQueueStats           stats = {};
+
+        void clear();
+
+        // The view depth is quantized from its float bits (more precision near the camera), behind the camera is 0
+        void add(   const uint32_t pass, 
+                    const uint32_t pipeline, 
+                    const uint32_t material, 
+                    const float view_depth, 
+                    const uint32_t draw_idx);
+
+        void sort();
+
+        inline uint32_t get_draw(const uint32_t idx) const {
+            return (uint32_t) (keys[idx] & ((1ull << RENDER_QUEUE_DRAW_BITS) - 1ull));
+        }
+
+        // Pass, pipeline & material of the draw, a change needs new binds
+        inline uint32_t get_state(const uint32_t idx) const {
+            return (uint32_t) (keys[idx] >> (RENDER_QUEUE_DEPTH_BITS + RENDER_QUEUE_DRAW_BITS));
+        }
+
+        void clean();
+    };
+};
\ No newline at end of file
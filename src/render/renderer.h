@@ -9,15 +9,51 @@
 #include "resources/gpu_mesh.h"
 #include "resources/resources.h"
 #include "resources/pipeline.h"
+#include "resources/staging_ring.h"
+#include "resources/geometry_pool.h"
+#include "resources/transform_hierarchy.h"
+#include "pixel_conversion.h"
+#include "frustum_culling.h"
+#include "render_queue.h"
+#include "render_graph.h"
+#include "../parsers/texture_loader.h"
+#include "../parsers/mesh_streamer.h"
+#include "../utils/dynamic_array.h"
 
 #define FRAME_BUFFER_COUNT 3u
-#define MAX_STAGING_BUFFER_COUNT 30u
-#define MAX_STAGING_BUFFER_RESOLVE_COUNT (MAX_STAGING_BUFFER_COUNT * 4u)
 
-#define MAX_MESH_COUNT 30u
+// Secondary command buffers of the draws, one per recording thread (the job system workers & the main thread)
+#define RENDER_MAX_RECORDING_THREADS 32u
+// With fewer draws per thread than this, the draws are recorded inline on the frame's command buffer
+#define RENDER_MIN_DRAWS_PER_THREAD 128u
+// Records synthetic draws on the secondary command buffers on startup, single threaded & on the workers, and logs the timings
+#define DRAW_RECORDING_BENCHMARK false
+#define DRAW_RECORDING_BENCHMARK_COUNT 100000u
+#define DRAW_RECORDING_BENCHMARK_RUNS 5u
+
+#define MESHLET_CULL_GROUP_SIZE 64u
+#define OBJECT_CULL_GROUP_SIZE 64u
+
+// Objects culled on a compute pass & drawn with an indirect count draw per index type, the recording does not
+// depend on the object count. Without it the instances are culled on the CPU, drawn per mesh with meshlet culling
+#define GPU_DRIVEN_RENDERING true
+// Draw counts of the 16 & 32 bit index lists, before the commands on the indirect draw buffer
+#define INDIRECT_DRAW_COUNTS_SIZE 16u
+
+// Max screen space error of a LOD, in pixels
+#define LOD_ERROR_THRESHOLD_PIXELS 1.0f
+// A coarser LOD needs an error under this fraction of the threshold, so the levels do not flicker on the limit
+#define LOD_HYSTERESIS 0.75f
+
+// Frames between the reports of the binds saved by the render queue sort, on the CPU path
+#define RENDER_QUEUE_STATS_REPORT_FRAMES 600u
 
 struct GLFWwindow;
 
+namespace Geometry {
+    struct sMeshlet;
+};
+
 namespace Render {
 
     struct sComputePushConstants {
@@ -35,6 +71,36 @@ namespace Render {
         sImage *dst_image = nullptr;
         VkExtent3D dst_copy_pos = {};
         VkExtent3D img_size = {};
+        uint32_t dst_mip_level = 0u;
+    };
+
+    // Counters of the copies recorded on a frame
+    struct sUploadStats {
+        uint32_t    uploads = 0u;
+        uint32_t    copy_commands = 0u;
+        uint32_t    copy_regions = 0u;
+        // Uploads that were contiguous with the previous one, on both src & dst
+        uint32_t    merged_regions = 0u;
+    };
+
+    // Scratch memory for the regions & barriers of the staging copies, kept between frames
+    struct sStagingCopyScratch {
+        sDynamicArray<VkBufferCopy>             buffer_regions = {};
+        sDynamicArray<VkBufferImageCopy>        image_regions = {};
+        sDynamicArray<VkBufferMemoryBarrier2>   buffer_barriers = {};
+        sDynamicArray<VkImageMemoryBarrier2>    image_barriers = {};
+        // Images written on a resolve, & if their mip chain is blitted from the level 0
+        sDynamicArray<sImage*>                  dst_images = {};
+        sDynamicArray<bool>                     dst_images_need_blit = {};
+
+        inline void clean() {
+            buffer_regions.clean();
+            image_regions.clean();
+            buffer_barriers.clean();
+            image_barriers.clean();
+            dst_images.clean();
+            dst_images_need_blit.clean();
+        }
     };
 
     struct sGPUSceneGlobalData {
@@ -45,11 +111,27 @@ namespace Render {
         glm::vec3   sunlight_dir = {};
         float       sun_power = 0.0f;
         glm::vec4   sunlight_color = {0.0f, 0.0f, 0.0f, 0.0f};
+        // World space, pointing inside: left, right, bottom, top, near, far
+        glm::vec4   frustum_planes[6u] = {};
+        glm::vec4   camera_position = {};
     };
 
     struct sFrame {
         VkCommandPool       cmd_pool;
         VkCommandBuffer     cmd_buffer;
+
+        // A pool per recording thread, so the draws are recorded without locks. Reset before each recording
+        VkCommandPool       draw_cmd_pools[RENDER_MAX_RECORDING_THREADS];
+        VkCommandBuffer     draw_cmd_buffers[RENDER_MAX_RECORDING_THREADS];
+
+        // Async uploads, recorded for the transfer queue (if the device has one)
+        VkCommandPool       transfer_cmd_pool;
+        VkCommandBuffer     transfer_cmd_buffer;
+        // Upload timeline value submitted by the time of the last capture of this frame
+        // Waited before reusing its transfer cmd buffer and its staging ring
+        uint64_t            transfer_submitted_value = 0u;
+        // Upload timeline value the render submit needs to wait for
+        uint64_t            upload_wait_value = 0u;
         // For signaling that the swapchain is being used
         VkSemaphore         swapchain_semaphore;
         // For signaling that the render has finished
@@ -58,16 +140,12 @@ namespace Render {
         // For waiting until the prev frame is finished
         VkFence             render_fence;
         uint32_t            current_swapchain_index = 0u;
+        // Of the swapchain image on the render graph, for this frame
+        uint32_t            swapchain_graph_idx = 0u;
 
-        // Staging buffers for a frame
-        uint32_t            staging_to_resolve_count = 0u;
-        sStagingToResolve   staging_to_resolve[MAX_STAGING_BUFFER_RESOLVE_COUNT] = {};
-
-        uint32_t            staging_buffer_count = 0u;
-        sGPUBuffer          staging_buffers[MAX_STAGING_BUFFER_COUNT] = {};
-
-        uint32_t            staging_to_clean_count = 0u;
-        sGPUBuffer          staging_to_clean[MAX_STAGING_BUFFER_COUNT] = {};
+        // Staging memory for a frame, and the copies to record on the next capture
+        sStagingRing                        staging_ring = {};
+        sDynamicArray<sStagingToResolve>    staging_to_resolve = {};
 
         // In-frame descriptor sets
         sDSetPoolAllocator  descriptor_allocator = {};
@@ -76,6 +154,26 @@ namespace Render {
 
         sGPUBuffer              gpu_comon_scene_data_buffer;
         VkDescriptorSet         gpu_comon_scene_descriptor_set;
+
+        // Mapped, rewritten each frame (sGPUInstance), grows with the instance count
+        sGPUBuffer              instance_buffer = {};
+        VkDeviceAddress         instance_buffer_address = 0u;
+
+        // GPU driven path: draw counts & the 16 bit and 32 bit index command lists, written by the object culling
+        sGPUBuffer              indirect_draw_buffer = {};
+        VkDeviceAddress         indirect_draw_buffer_address = 0u;
+        uint32_t                indirect_draw_capacity = 0u;
+
+        // Mark a resource as read on this frame, so the submit waits for its async upload
+        inline void use_resource(const uint64_t resource_upload_value) {
+            if (resource_upload_value > upload_wait_value) {
+                upload_wait_value = resource_upload_value;
+            }
+        }
+
+        inline void use_resource(const sGPUBuffer &buffer) {
+            use_resource(buffer.upload_timeline_value);
+        }
     };
 
     
@@ -100,13 +198,30 @@ namespace Render {
             struct sQueueData {
                 VkQueue                 queue;
                 uint32_t                family;
-            } graphic_queue;
+            } graphic_queue, transfer_queue;
+
+            // Only when there is a transfer-only queue family
+            bool                        has_transfer_queue = false;
+            // textureCompressionBC, enabled if present
+            bool                        supports_bc_compression = false;
         } gpu_instance = {};
 
         VmaAllocator            vk_allocator;
 
+        // Signaled by the transfer queue submits, one increment per submit
+        // Async uploads are submitted on the next start_frame_capture, whatever the frame they were staged on,
+        // so the value they will be ready at is known when they are staged (upload_timeline_value + 1)
+        VkSemaphore             upload_timeline_semaphore;
+        uint64_t                upload_timeline_value = 0u;
+        sDynamicArray<sStagingToResolve>    async_staging_to_resolve = {};
+
+        // Stats of the last frame's upload resolves
+        sUploadStats            upload_stats = {};
+        sStagingCopyScratch     staging_copy_scratch = {};
+
         uint64_t                frame_number = 0u;
         sFrame                  in_flight_frames[FRAME_BUFFER_COUNT];
+        uint32_t                recording_thread_count = 1u;
 
         sDSetPoolAllocator      global_descriptor_allocator = {};
 
@@ -116,6 +231,12 @@ namespace Render {
         VkPipeline              gradient_draw_compute_pipeline;
         VkPipelineLayout        gradient_draw_compute_pipeline_layout;
 
+        VkPipeline              meshlet_cull_compute_pipeline;
+        VkPipelineLayout        meshlet_cull_compute_pipeline_layout;
+
+        VkPipeline              object_cull_compute_pipeline;
+        VkPipelineLayout        object_cull_compute_pipeline_layout;
+
         VkPipeline              render_mesh_pipeline;
         VkPipelineLayout        render_mesh_pipeline_layout;
 
@@ -127,16 +248,43 @@ namespace Render {
             VkImageView     image_views[FRAME_BUFFER_COUNT];
         } swapchain_data;
 
+        // Per frame render targets: transient images of the render graph, that owns their memory
         sImage                  draw_image;
         sImage                  depth_image;
 
+        // Barriers & layouts of the frame's images, from the passes' declared uses
+        sRenderGraph            render_graph = {};
+        uint32_t                draw_image_graph_idx = 0u;
+        uint32_t                depth_image_graph_idx = 0u;
+
         // Scene data
         sGPUSceneGlobalData     scene_global_data;
         VkDescriptorSetLayout   gpu_comon_scene_data_descriptor_set_layout;
 
         // Renderables
-        uint32_t            mesh_count = 0u;
-        sGPUMesh            meshes[MAX_MESH_COUNT] = {};
+        sGeometryPool           geometry_pool = {};
+        sDynamicArray<sGPUMesh> meshes = {};
+        // Prefix of the meshes with their upload finished, the only ones drawn
+        uint32_t                resident_mesh_count = 0u;
+        sTransformHierarchy     scene_transforms = {};
+        sDynamicArray<sMeshInstance>    mesh_instances = {};
+        // World bounds of the resident instances (bounds_instances has their instance), & the ones inside the view
+        sCullingBounds                  instance_bounds = {};
+        sDynamicArray<uint32_t>         bounds_instances = {};
+        sDynamicArray<uint32_t>         visible_bounds = {};
+        // Instances of each resident mesh on this frame, grouped on sorted_instances (& the instance buffer) for an instanced draw per mesh
+        sDynamicArray<uint32_t>         mesh_first_instance = {};
+        sDynamicArray<uint32_t>         mesh_instance_count = {};
+        sDynamicArray<uint32_t>         sorted_instances = {};
+        // Draws of this frame: the meshes, or the objects on the GPU driven path
+        sRenderQueue                    render_queue = {};
+        sRenderQueueTotals              render_queue_totals = {};
+        // Resident instances on this frame's instance buffer, on the GPU driven path
+        uint32_t                        scene_object_count = 0u;
+        // GPU driven path: level of each mesh instance on the last culling (uint32), shared by the frames
+        sGPUBuffer                      object_lod_buffer = {};
+        VkDeviceAddress                 object_lod_buffer_address = 0u;
+        Parsers::sMeshStreamer  mesh_streamer;
 
         // Scene textures
         VkSampler           nearest_sampler;
@@ -144,19 +292,39 @@ namespace Render {
 
         sImage              checkerboard_texture = { };
 
+        // Empty (no VkImage) until the loader uploads them
+        sDynamicArray<sImage>       textures = {};
+        Parsers::sTextureLoader     texture_loader;
+
         bool create_swapchain(const uint32_t width, const uint32_t height, const eImageFormats format, sSwapchainData &swapchain_data);
         void destroy_swapchain(sBackend::sSwapchainData &swapchain_data);
 
-        sImage create_image(const eImageFormats img_format, const VkImageUsageFlags usage, const VkMemoryPropertyFlags mem_flags, const VkExtent3D& img_dims, const VkImageAspectFlagBits view_flags = VK_IMAGE_ASPECT_COLOR_BIT, const bool mipmapped = true);
-        void create_image(sImage *new_img, void *raw_img_data, const eImageFormats img_format, const VkImageUsageFlags usage, const VkMemoryPropertyFlags mem_flags, const VkExtent3D& img_dims, sFrame &frame_to_upload, const bool mipmapped = true, const VkImageAspectFlagBits view_flags = VK_IMAGE_ASPECT_COLOR_BIT);
+        // mip_levels caps the chain of a mipmapped image, 0 for the full chain
+        sImage create_image(const eImageFormats img_format, const VkImageUsageFlags usage, const VkMemoryPropertyFlags mem_flags, const VkExtent3D& img_dims, const VkImageAspectFlagBits view_flags = VK_IMAGE_ASPECT_COLOR_BIT, const bool mipmapped = true, const uint32_t mip_levels = 0u);
+        // The data is on src_format (the image format if undefined), converted to the image format on the upload
+        void create_image(sImage *new_img, void *raw_img_data, const eImageFormats img_format, const VkImageUsageFlags usage, const VkMemoryPropertyFlags mem_flags, const VkExtent3D& img_dims, sFrame &frame_to_upload, const bool mipmapped = true, const VkImageAspectFlagBits view_flags = VK_IMAGE_ASPECT_COLOR_BIT, const eImageFormats src_format = IMG_FORMAT_UNDEF, const uint32_t conversion_flags = PIXEL_CONVERSION_NONE);
+        // Prebuilt mip chain (e.g. block compressed textures), the levels tightly packed one after the other from the level 0
+        void create_image(sImage *new_img, const void *level_data, const uint32_t level_count, const eImageFormats img_format, const VkImageUsageFlags usage, const VkMemoryPropertyFlags mem_flags, const VkExtent3D& img_dims, sFrame &frame_to_upload);
         void clean_image(const sImage &image);
+        // Optimal tiling supports blit src, dst & linear filtering, for the mip chain generation
+        bool supports_linear_blit(const eImageFormats format) const;
+        // Can be uploaded & sampled, block compressed formats need the BC feature
+        bool supports_sampled_format(const eImageFormats format) const;
 
         sGPUBuffer create_buffer(const size_t buffer_size, const VkBufferUsageFlags usage, const VmaMemoryUsage mem_usage, const bool mapped_on_startup = false);
         void clean_buffer(const sGPUBuffer &buffer);
-        void upload_to_gpu(const void* data, const size_t upload_size, sGPUBuffer *dst_buffer, const size_t dst_offset, sFrame *frame_to_upload);
-        void upload_to_gpu(const void* data, const eImageFormats tex_format, const VkExtent3D src_img_size, sImage *dst_buffer, const VkExtent3D dst_pos, sFrame *frame_to_upload);
-
-        bool create_gpu_mesh(Render::sGPUMesh *new_mesh, const uint32_t *indices, const uint32_t index_count, const sVertex *vertices, const uint32_t vertex_count, sFrame *frame_to_arrive);
+        void upload_to_gpu(const void* data, const size_t upload_size, sGPUBuffer *dst_buffer, const size_t dst_offset, sFrame *frame_to_upload, const bool async_upload = false);
+        // Same as upload_to_gpu, but returns the mapped staging memory to write the data in place
+        void* stage_buffer_upload(const size_t upload_size, sGPUBuffer *dst_buffer, const size_t dst_offset, sFrame *frame_to_upload, const bool async_upload = false);
+        // Images with mips but only the level 0 uploaded get the rest of the chain blitted on the resolve
+        void upload_to_gpu(const void* data, const eImageFormats tex_format, const VkExtent3D src_img_size, sImage *dst_buffer, const VkExtent3D dst_pos, sFrame *frame_to_upload, const uint32_t mip_level = 0u);
+        // Converts the pixels to the image format, writing straight to the staging memory
+        void upload_converted_to_gpu(const void* pixels, const eImageFormats src_format, const uint32_t conversion_flags, const VkExtent3D src_img_size, sImage *dst_image, const VkExtent3D dst_pos, sFrame *frame_to_upload, const uint32_t mip_level = 0u);
+        void* stage_image_upload(const eImageFormats tex_format, const VkExtent3D src_img_size, sImage *dst_image, const VkExtent3D dst_pos, sFrame *frame_to_upload, const uint32_t mip_level = 0u);
+
+        // Counts in elements (the indices as 32 bit ones), only the buffers that are too small are replaced. Waits for the GPU
+        void grow_geometry_pool(const uint64_t vertex_count, const uint64_t index_count, const uint64_t meshlet_count, const uint64_t culled_index_count);
+        bool create_gpu_mesh(Render::sGPUMesh *new_mesh, const uint32_t *indices, const uint32_t index_count, const sVertex *vertices, const uint32_t vertex_count, const Geometry::sMeshlet *meshlets, const uint32_t meshlet_count, const sMeshLOD *lods, const uint32_t lod_count, sFrame *frame_to_arrive);
 
         inline sFrame& get_current_frame() { 
             return in_flight_frames[frame_number % FRAME_BUFFER_COUNT]; 
@@ -165,8 +333,11 @@ namespace Render {
         void start_frame_capture();
         void end_frame_capture();
         void clean_prev_staging_buffers(  Render::sFrame &current_frame  );
+        void submit_async_uploads(  Render::sFrame &current_frame  );
 
         void render();
+        // Passes of the frame on the render graph, also declared on init for the transient image lifetimes
+        void add_frame_passes();
 
         bool init();
         void clean();
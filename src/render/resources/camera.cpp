@@ -43,4 +43,21 @@ void sCamera::config_oblique_projection(    const glm::vec4 clipping_plane,
     proj_mat[3][2] = c.w - proj_mat[3][3];
 
     view_proj_mat = proj_mat * view_mat;
+}
+
+// Gribb & Hartmann, from the rows of the view projection matrix
+void sCamera::get_frustum_planes(glm::vec4 planes[6u]) const {
+    const glm::mat4 m = glm::transpose(view_proj_mat);
+
+    planes[0u] = m[3] + m[0];
+    planes[1u] = m[3] - m[0];
+    planes[2u] = m[3] + m[1];
+    planes[3u] = m[3] - m[1];
+    // Valid for both depth ranges, for [0, 1] it ends up a bit behind the near plane
+    planes[4u] = m[3] + m[2];
+    planes[5u] = m[3] - m[2];
+
+    for(uint32_t i = 0u; i < 6u; i++) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
 }
\ No newline at end of file
@@ -16,4 +16,7 @@ struct sCamera {
     void config_view(const glm::vec3 position, const glm::vec3 look_at, const glm::vec3 up = {0.0f, 0.0f, 1.0f});
     void config_projection(const float rad_fov, const float aspect_ratio, const float near = 0.01f, const float far = 10.0f);
     void config_oblique_projection(const glm::vec4 clipping_plane, const float rad_fov, const float aspect_ratio, const float near = 0.01f, const float far = 10.0f);
+
+    // World space planes of the view_proj, normals pointing inside: left, right, bottom, top, near, far
+    void get_frustum_planes(glm::vec4 planes[6u]) const;
 };
\ No newline at end of file
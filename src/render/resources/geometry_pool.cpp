@@ -0,0 +1,152 @@
+#include "geometry_pool.h"
+
+#include <spdlog/spdlog.h>
+
+#include "../render_utils.h"
+#include "gpu_mesh.h"
+#include "../../geometry/meshlet_builder.h"
+
+using namespace Render;
+
+void sGeometryPool::init(   const uint32_t vertex_count,
+                            const uint32_t index_count,
+                            const uint32_t meshlet_count,
+                            const bool compact_vertices ) {
+    vertex_capacity = vertex_count;
+    index_capacity = index_count;
+    meshlet_capacity = meshlet_count;
+    culled_index_capacity = index_count;
+
+    use_compact_vertices = compact_vertices;
+    vertex_size = (compact_vertices) ? sizeof(sCompactVertex) : sizeof(sVertex);
+
+    VmaVirtualBlockCreateInfo vertex_block_info = {
+        .size = GEOMETRY_POOL_MAX_VERTEX_COUNT
+    };
+    vk_assert_msg(  vmaCreateVirtualBlock(&vertex_block_info, &vertex_block),
+                    "Error creating the vertex virtual block");
+
+    VmaVirtualBlockCreateInfo index_block_info = {
+        .size = (VkDeviceSize) GEOMETRY_POOL_MAX_INDEX_COUNT * sizeof(uint32_t)
+    };
+    vk_assert_msg(  vmaCreateVirtualBlock(&index_block_info, &index_block),
+                    "Error creating the index virtual block");
+    vk_assert_msg(  vmaCreateVirtualBlock(&index_block_info, &culled_index_block),
+                    "Error creating the culled index virtual block");
+
+    VmaVirtualBlockCreateInfo meshlet_block_info = {
+        .size = GEOMETRY_POOL_MAX_MESHLET_COUNT
+    };
+    vk_assert_msg(  vmaCreateVirtualBlock(&meshlet_block_info, &meshlet_block),
+                    "Error creating the meshlet virtual block");
+}
+
+void sGeometryPool::clean() {
+    // Meshes still alive at shutdown are released in bulk
+    vmaClearVirtualBlock(vertex_block);
+    vmaClearVirtualBlock(index_block);
+    vmaClearVirtualBlock(meshlet_block);
+    vmaClearVirtualBlock(culled_index_block);
+
+    vmaDestroyVirtualBlock(vertex_block);
+    vmaDestroyVirtualBlock(index_block);
+    vmaDestroyVirtualBlock(meshlet_block);
+    vmaDestroyVirtualBlock(culled_index_block);
+}
+
+bool sGeometryPool::alloc_vertices( const uint32_t vertex_count,
+                                    VmaVirtualAllocation *allocation,
+                                    uint32_t *first_vertex ) {
+    VmaVirtualAllocationCreateInfo alloc_info = {
+        .size = vertex_count
+    };
+
+    VkDeviceSize offset = 0u;
+    if (vmaVirtualAllocate(vertex_block, &alloc_info, allocation, &offset) != VK_SUCCESS) {
+        spdlog::error("Geometry pool out of vertex space ({} vertices requested), raise GEOMETRY_POOL_MAX_VERTEX_COUNT", vertex_count);
+        return false;
+    }
+
+    *first_vertex = (uint32_t) offset;
+    return true;
+}
+
+static bool alloc_index_range( VmaVirtualBlock block,
+                                const uint32_t index_count,
+                                const uint32_t index_size,
+                                VmaVirtualAllocation *allocation,
+                                uint32_t *first_index ) {
+    // 4 byte aligned, the culling reads & writes the 16 bit ranges next to 32 bit ones
+    VmaVirtualAllocationCreateInfo alloc_info = {
+        .size = (VkDeviceSize) index_count * index_size,
+        .alignment = sizeof(uint32_t)
+    };
+
+    VkDeviceSize offset = 0u;
+    if (vmaVirtualAllocate(block, &alloc_info, allocation, &offset) != VK_SUCCESS) {
+        return false;
+    }
+
+    *first_index = (uint32_t) (offset / index_size);
+    return true;
+}
+
+bool sGeometryPool::alloc_indices(  const uint32_t index_count,
+                                    const uint32_t index_size,
+                                    VmaVirtualAllocation *allocation,
+                                    uint32_t *first_index ) {
+    if (!alloc_index_range(index_block, index_count, index_size, allocation, first_index)) {
+        spdlog::error("Geometry pool out of index space ({} indices requested), raise GEOMETRY_POOL_MAX_INDEX_COUNT", index_count);
+        return false;
+    }
+    return true;
+}
+
+bool sGeometryPool::alloc_culled_indices(   const uint32_t index_count,
+                                            const uint32_t index_size,
+                                            VmaVirtualAllocation *allocation,
+                                            uint32_t *first_index ) {
+    if (!alloc_index_range(culled_index_block, index_count, index_size, allocation, first_index)) {
+        spdlog::error("Geometry pool out of culled index space ({} indices requested), raise GEOMETRY_POOL_MAX_INDEX_COUNT", index_count);
+        return false;
+    }
+    return true;
+}
+
+bool sGeometryPool::alloc_meshlets( const uint32_t meshlet_count,
+                                    VmaVirtualAllocation *allocation,
+                                    uint32_t *first_meshlet ) {
+    VmaVirtualAllocationCreateInfo alloc_info = {
+        .size = meshlet_count
+    };
+
+    VkDeviceSize offset = 0u;
+    if (vmaVirtualAllocate(meshlet_block, &alloc_info, allocation, &offset) != VK_SUCCESS) {
+        spdlog::error("Geometry pool out of meshlet space ({} meshlets requested), raise GEOMETRY_POOL_MAX_MESHLET_COUNT", meshlet_count);
+        return false;
+    }
+
+    *first_meshlet = (uint32_t) offset;
+    return true;
+}
+
+void sGeometryPool::free_vertices(const VmaVirtualAllocation allocation) {
+    vmaVirtualFree(vertex_block, allocation);
+}
+
+void sGeometryPool::free_indices(const VmaVirtualAllocation allocation) {
+    vmaVirtualFree(index_block, allocation);
+}
+
+void sGeometryPool::free_meshlets(const VmaVirtualAllocation allocation) {
+    vmaVirtualFree(meshlet_block, allocation);
+}
+
+void sGeometryPool::free_culled_indices(const VmaVirtualAllocation allocation) {
+    vmaVirtualFree(culled_index_block, allocation);
+}
+
+uint64_t sGeometryPool::get_mesh_size(const sGPUMesh &mesh) const {
+    const uint64_t index_size = (mesh.index_type == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+    return (uint64_t) mesh.vertex_count * vertex_size + mesh.index_count * index_size + mesh.meshlet_count * sizeof(Geometry::sMeshlet);
+}
\ No newline at end of file
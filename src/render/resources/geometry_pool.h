@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include "gpu_buffers.h"
+
+// Capacities in elements, not bytes (the index capacity is counted as 32 bit indices)
+// The buffers start at these, and double when a mesh's range ends past them, up to the max counts
+#define GEOMETRY_POOL_VERTEX_CAPACITY (1u << 20u)
+#define GEOMETRY_POOL_INDEX_CAPACITY (1u << 23u)
+#define GEOMETRY_POOL_MESHLET_CAPACITY (1u << 17u)
+#define GEOMETRY_POOL_MAX_VERTEX_COUNT (1u << 26u)
+#define GEOMETRY_POOL_MAX_INDEX_COUNT (1u << 28u)
+#define GEOMETRY_POOL_MAX_MESHLET_COUNT (1u << 23u)
+// Store the vertices as sCompactVertex instead of sVertex
+#define GEOMETRY_POOL_COMPACT_VERTICES true
+// The transfer source is for the copy to the bigger buffer when they grow
+#define GEOMETRY_POOL_VERTEX_USAGE (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+#define GEOMETRY_POOL_INDEX_USAGE (VK_BUFFER_USAGE_INDEX_BUFFER_BIT | GEOMETRY_POOL_VERTEX_USAGE)
+#define GEOMETRY_POOL_MESHLET_USAGE GEOMETRY_POOL_VERTEX_USAGE
+// Rewritten each frame, nothing to copy
+#define GEOMETRY_POOL_CULLED_INDEX_USAGE (VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+// Starting capacity of the per mesh buffers (indirect draw commands of the meshlet culling & sGPUMeshDraw),
+// doubled when more meshes are resident
+#define GEOMETRY_POOL_INITIAL_DRAW_CAPACITY 4096u
+
+namespace Render {
+    struct sGPUMesh;
+
+    /**
+    * Scene wide vertex & index buffers, the meshes are ranges inside of them
+    * The ranges are handed out by VMA virtual blocks (measured in vertices & meshlets,
+    * and in bytes for the indices, since meshes can have 16 or 32 bit indices). The blocks span the
+    * max counts, the buffers behind them grow when a range ends past their capacity.
+    * The meshes live until shutdown (the instances & the resident prefix index them), so their ranges
+    * are only given back when a mesh creation fails half way.
+    * The draw loop only needs to bind the index buffer once, and the vertex
+    * pulling uses the same buffer address for all the meshes.
+    * The meshlet culling writes the surviving triangles of each mesh on its own range of
+    * culled_index_buffer (from culled_index_block), and its draw on draw_commands_buffer.
+    */
+    struct sGeometryPool {
+        sGPUBuffer          vertex_buffer;
+        sGPUBuffer          index_buffer;
+        sGPUBuffer          meshlet_buffer;
+        VkDeviceAddress     vertex_buffer_address;
+        VkDeviceAddress     index_buffer_address;
+        VkDeviceAddress     meshlet_buffer_address;
+
+        // sGPUMeshDraw of each resident mesh, mapped, written once when its upload finishes (GPU driven path)
+        sGPUBuffer          mesh_draw_buffer;
+        VkDeviceAddress     mesh_draw_buffer_address;
+
+        sGPUBuffer          culled_index_buffer;
+        sGPUBuffer          draw_commands_buffer;
+        VkDeviceAddress     culled_index_buffer_address;
+        VkDeviceAddress     draw_commands_buffer_address;
+
+        VmaVirtualBlock     vertex_block;
+        VmaVirtualBlock     index_block;
+        VmaVirtualBlock     meshlet_block;
+        VmaVirtualBlock     culled_index_block;
+
+        // Elements that fit on the buffers, the index ones counted as 32 bit indices
+        uint32_t            vertex_capacity = 0u;
+        uint32_t            index_capacity = 0u;
+        uint32_t            meshlet_capacity = 0u;
+        uint32_t            culled_index_capacity = 0u;
+        // Meshes that fit on mesh_draw_buffer & draw_commands_buffer
+        uint32_t            draw_capacity = 0u;
+
+        bool                use_compact_vertices = false;
+        uint32_t            vertex_size = 0u;
+
+        // The capacities are the ones of the buffers created on init, the blocks take the max counts
+        void init(const uint32_t vertex_count, const uint32_t index_count, const uint32_t meshlet_count, const bool compact_vertices);
+        void clean();
+
+        bool alloc_vertices(const uint32_t vertex_count, VmaVirtualAllocation *allocation, uint32_t *first_vertex);
+        // first_index is counted on index_size elements
+        bool alloc_indices(const uint32_t index_count, const uint32_t index_size, VmaVirtualAllocation *allocation, uint32_t *first_index);
+        bool alloc_meshlets(const uint32_t meshlet_count, VmaVirtualAllocation *allocation, uint32_t *first_meshlet);
+        bool alloc_culled_indices(const uint32_t index_count, const uint32_t index_size, VmaVirtualAllocation *allocation, uint32_t *first_index);
+
+        void free_vertices(const VmaVirtualAllocation allocation);
+        void free_indices(const VmaVirtualAllocation allocation);
+        void free_meshlets(const VmaVirtualAllocation allocation);
+        void free_culled_indices(const VmaVirtualAllocation allocation);
+
+        // Bytes of the mesh's vertex, index & meshlet ranges
+        uint64_t get_mesh_size(const sGPUMesh &mesh) const;
+    };
+};
\ No newline at end of file
@@ -11,6 +11,10 @@ namespace Render {
         VmaAllocationInfo alloc_info;
 
         size_t size = 0u;
+
+        // Value of the upload timeline semaphore after which the content is on the GPU
+        // 0 when it was uploaded (or will be) on the graphics queue
+        uint64_t upload_timeline_value = 0u;
     };
 
     struct sGPUBufferView {
@@ -6,6 +6,8 @@
 #include "mesh.h"
 #include "gpu_buffers.h"
 
+#define MESH_MAX_LODS 5u
+
 namespace Render {
     struct sVertex {
         glm::vec3   position = {0.0f, 0.0f, 0.0f};
@@ -19,6 +21,19 @@ namespace Render {
         glm::vec4   color = {0.0f, 0.0f, 0.0f, 1.0f};
     };
 
+    // 24 bytes version of sVertex, decoded on mesh_compact.vert
+    struct sCompactVertex {
+        // Unorm16 inside of the mesh's bounds, w unused
+        uint16_t    position[4u];
+        // Octahedral encoding, snorm16
+        int16_t     normal[2u];
+        int16_t     tangent[2u];
+        // Half floats
+        uint16_t    uv[2u];
+        // RGBA unorm8, alpha 0 when the color is the normal fallback (decoded from the normal, with its negative side)
+        uint32_t    color;
+    };
+
     struct sVertexSimple {
         glm::vec3   position;
         float       uv_x;
@@ -27,17 +42,134 @@ namespace Render {
         glm::vec4   color;
     };
     
+    // A level of detail, as ranges relative to the mesh's first index & first meshlet
+    struct sMeshLOD {
+        uint32_t    first_index;
+        uint32_t    index_count;
+        uint32_t    first_meshlet;
+        uint32_t    meshlet_count;
+        // Max distance to the full detail surface, on mesh units
+        float       error;
+    };
+
+    // Ranges of the scene's geometry pool
     struct sGPUMesh {
-        sGPUBuffer      index_buffer;
-        sGPUBuffer      vertex_buffer;
+        uint32_t                first_index = 0u;
+        uint32_t                index_count = 0u;
+
+        uint32_t                first_vertex = 0u;
+        uint32_t                vertex_count = 0u;
+
+        uint32_t                first_meshlet = 0u;
+        uint32_t                meshlet_count = 0u;
+
+        // Output range of the meshlet culling, own of each mesh even if the others ranges are shared
+        uint32_t                first_culled_index = 0u;
+
+        // first_index & first_culled_index are counted on elements of this type
+        VkIndexType             index_type = VK_INDEX_TYPE_UINT32;
+
+        // Bounds of the quantized positions (0 & 1 if they are not quantized)
+        glm::vec3               position_min = {0.0f, 0.0f, 0.0f};
+        glm::vec3               position_extent = {1.0f, 1.0f, 1.0f};
+
+        // AABB (center & half extents) and bounding sphere on the same center, on mesh space
+        glm::vec3               bounds_center = {0.0f, 0.0f, 0.0f};
+        float                   bounds_radius = 0.0f;
+        glm::vec3               bounds_extent = {0.0f, 0.0f, 0.0f};
+
+        // Levels stored one after the other on the mesh's index & meshlet ranges, 0 is the full detail
+        sMeshLOD                lods[MESH_MAX_LODS] = {};
+        uint32_t                lod_count = 0u;
+        // Level picked on the last frame, for the hysteresis
+        uint32_t                current_lod = 0u;
 
-        uint32_t        index_count;
+        VmaVirtualAllocation    index_alloc;
+        VmaVirtualAllocation    vertex_alloc;
+        VmaVirtualAllocation    meshlet_alloc;
+        VmaVirtualAllocation    culled_index_alloc;
 
-        VkDeviceAddress vertex_buffer_address;
+        // Upload timeline value after which the mesh data is on the GPU (0 if uploaded on the graphics queue)
+        uint64_t                upload_timeline_value = 0u;
+    };
+
+    // A draw of a mesh, placed by a node of the scene's transform hierarchy
+    struct sMeshInstance {
+        uint32_t    mesh_idx;
+        uint32_t    transform_idx;
+    };
+
+    // Per frame instance data, read on the vertex shaders with gl_InstanceIndex
+    // On the GPU driven path it is also the scene's object list, read by the object culling
+    struct sGPUInstance {
+        glm::mat4   model_matrix;
+        // Dequantization of the mesh's positions
+        // w has the bits of the mesh index on the GPU driven path, unused otherwise
+        glm::vec4   position_min;
+        // w has the bits of the mesh instance index on the GPU driven path, unused otherwise
+        glm::vec4   position_extent;
+    };
+
+    // Index range of a level, relative to the mesh's first index
+    struct sGPUMeshDrawLOD {
+        uint32_t    first_index;
+        uint32_t    index_count;
+        float       error;
+        uint32_t    pad;
+    };
+
+    // What the object culling needs from a mesh, on the geometry pool's mesh draw buffer (indexed as the meshes)
+    struct sGPUMeshDraw {
+        glm::vec3           bounds_center;
+        float               bounds_radius;
+        glm::vec3           bounds_extent;
+        uint32_t            lod_count;
+        uint32_t            first_index;
+        int32_t             vertex_offset;
+        // 2 or 4, picks the command list of the mesh's draws
+        uint32_t            index_size;
+        uint32_t            pad;
+        sGPUMeshDrawLOD     lods[MESH_MAX_LODS];
     };
 
     struct sMeshPushConstant {
-        glm::mat4           mvp_matrix;
         VkDeviceAddress     vertex_buffer;
+        VkDeviceAddress     instance_buffer;
+    };
+
+    // One dispatch per mesh, a thread per meshlet
+    // A mesh with a single instance culls with its model matrix, the instanced ones share all the meshlets of the level
+    struct sMeshletCullPushConstant {
+        VkDeviceAddress     instance_buffer;
+        VkDeviceAddress     meshlet_buffer;
+        VkDeviceAddress     index_buffer;
+        VkDeviceAddress     culled_index_buffer;
+        VkDeviceAddress     draw_commands_buffer;
+        uint32_t            first_meshlet;
+        uint32_t            meshlet_count;
+        uint32_t            first_index;
+        uint32_t            first_culled_index;
+        uint32_t            first_vertex;
+        uint32_t            draw_idx;
+        uint32_t            index_size;
+        uint32_t            first_instance;
+        uint32_t            instance_count;
+    };
+
+    // One thread per object, the visible ones are compacted on the frame's indirect draw buffer
+    struct sObjectCullPushConstant {
+        VkDeviceAddress     instance_buffer;
+        VkDeviceAddress     mesh_draw_buffer;
+        VkDeviceAddress     indirect_draw_buffer;
+        // Level of each mesh instance on the last culling, for the hysteresis
+        VkDeviceAddress     object_lod_buffer;
+        uint32_t            object_count;
+        // Commands per list, the 32 bit index list starts after the 16 bit one
+        uint32_t            command_capacity;
+        // Error on mesh units at distance 1, to pixels
+        float               projection_scale;
+        float               lod_error_threshold;
+        float               lod_hysteresis;
+        uint32_t            pad;
     };
 };
\ No newline at end of file
@@ -6,6 +6,8 @@
 enum eImageFormats : uint32_t {
     IMG_FORMAT_RGBA_8BIT_UNORM = VK_FORMAT_R8G8B8A8_UNORM,
     IMG_FORMAT_BRGA_8BIT_UNORM = VK_FORMAT_B8G8R8A8_UNORM,
+    IMG_FORMAT_RGBA_8BIT_SRGB = VK_FORMAT_R8G8B8A8_SRGB,
+    IMG_FORMAT_BRGA_8BIT_SRGB = VK_FORMAT_B8G8R8A8_SRGB,
     IMG_FORMAT_RGBA_8BIT_UINT = VK_FORMAT_R8G8B8A8_UINT,
     IMG_FORMAT_RGB_8BIT_UINT = VK_FORMAT_R8G8B8_UINT,
     IMG_FORMAT_R_8BIT_UINT = VK_FORMAT_R8_UINT,
@@ -14,5 +16,13 @@ enum eImageFormats : uint32_t {
     IMG_FORMAT_D_32BIT_SFLOAT = VK_FORMAT_D32_SFLOAT,
     IMG_FORMAT_RGBA_32BIT_SFLOAT = VK_FORMAT_R32G32B32A32_SFLOAT,
     IMG_FORMAT_RGBA_16BIT_SFLOAT = VK_FORMAT_R16G16B16A16_SFLOAT,
+    // Block compressed, 4x4 texel blocks
+    IMG_FORMAT_BC1_RGBA_UNORM = VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+    IMG_FORMAT_BC3_RGBA_UNORM = VK_FORMAT_BC3_UNORM_BLOCK,
+    IMG_FORMAT_BC5_RG_UNORM = VK_FORMAT_BC5_UNORM_BLOCK,
+    IMG_FORMAT_BC7_RGBA_UNORM = VK_FORMAT_BC7_UNORM_BLOCK,
+    IMG_FORMAT_BC1_RGBA_SRGB = VK_FORMAT_BC1_RGBA_SRGB_BLOCK,
+    IMG_FORMAT_BC3_RGBA_SRGB = VK_FORMAT_BC3_SRGB_BLOCK,
+    IMG_FORMAT_BC7_RGBA_SRGB = VK_FORMAT_BC7_SRGB_BLOCK,
     IMG_FORMAT_UNDEF = VK_FORMAT_UNDEFINED
 };
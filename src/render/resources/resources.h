@@ -6,11 +6,29 @@
 
 #include "image_formats.h"
 
+inline bool is_block_compressed(const eImageFormats format) {
+    switch (format) {
+        case IMG_FORMAT_BC1_RGBA_UNORM:
+        case IMG_FORMAT_BC3_RGBA_UNORM:
+        case IMG_FORMAT_BC5_RG_UNORM:
+        case IMG_FORMAT_BC7_RGBA_UNORM:
+        case IMG_FORMAT_BC1_RGBA_SRGB:
+        case IMG_FORMAT_BC3_RGBA_SRGB:
+        case IMG_FORMAT_BC7_RGBA_SRGB:
+            return true;
+        default:
+            return false;
+    }
+};
+
+// For block compressed formats, the size of a 4x4 block
 inline size_t get_pixel_size(const eImageFormats format) {
     switch (format) {
         case IMG_FORMAT_BRGA_8BIT_UNORM:
         case IMG_FORMAT_RGBA_8BIT_UINT:
         case IMG_FORMAT_RGBA_8BIT_UNORM:
+        case IMG_FORMAT_BRGA_8BIT_SRGB:
+        case IMG_FORMAT_RGBA_8BIT_SRGB:
             return sizeof(uint8_t) * 4u;
             break;
         case IMG_FORMAT_RGB_8BIT_UINT:
@@ -32,12 +50,32 @@ inline size_t get_pixel_size(const eImageFormats format) {
         case IMG_FORMAT_RGBA_32BIT_SFLOAT:
             return sizeof(uint32_t) * 4u;
             break;
+        case IMG_FORMAT_BC1_RGBA_UNORM:
+        case IMG_FORMAT_BC1_RGBA_SRGB:
+            return sizeof(uint64_t);
+            break;
+        case IMG_FORMAT_BC3_RGBA_UNORM:
+        case IMG_FORMAT_BC5_RG_UNORM:
+        case IMG_FORMAT_BC7_RGBA_UNORM:
+        case IMG_FORMAT_BC3_RGBA_SRGB:
+        case IMG_FORMAT_BC7_RGBA_SRGB:
+            return sizeof(uint64_t) * 2u;
+            break;
         default:
             assert(false && "Pixel format undeclared");
             return 0u;
     }
 };
 
+// Tightly packed size of an image (or a mip level), block aware
+inline size_t get_image_data_size(const eImageFormats format, const VkExtent3D &dims) {
+    if (is_block_compressed(format)) {
+        return get_pixel_size(format) * ((dims.width + 3u) / 4u) * ((dims.height + 3u) / 4u) * dims.depth;
+    }
+
+    return get_pixel_size(format) * dims.width * dims.height * dims.depth;
+};
+
 struct sImage {
     VkImage         image;
     VkImageView     image_view;
@@ -0,0 +1,178 @@
+#include "staging_ring.h"
+
+#include <cstdlib>
+#include <spdlog/spdlog.h>
+
+#include "../render_utils.h"
+
+using namespace Render;
+
+inline VkDeviceSize align_up(const VkDeviceSize value, const VkDeviceSize alignment) {
+    // Not only powers of two: image uploads align to the texel size (3 bytes for RGB8)
+    return ((value + alignment - 1u) / alignment) * alignment;
+}
+
+void sStagingRing::init(    const VmaAllocator vma_allocator,
+                            const uint32_t graphics_family,
+                            const uint32_t transfer_family,
+                            const VkDeviceSize initial_size ) {
+    allocator = vma_allocator;
+
+    queue_family_count = 0u;
+    if (transfer_family != UINT32_MAX && transfer_family != graphics_family) {
+        queue_families[0u] = graphics_family;
+        queue_families[1u] = transfer_family;
+        queue_family_count = 2u;
+    }
+
+    buffer = create_ring_buffer(initial_size);
+
+    head = 0u;
+    tail = 0u;
+    submitted_head = 0u;
+    is_empty = true;
+    has_pending_uploads = false;
+}
+
+void sStagingRing::clean() {
+    for(uint32_t i = 0u; i < pending_retired_buffers.count; i++) {
+        vmaDestroyBuffer(allocator, pending_retired_buffers[i]->buffer, pending_retired_buffers[i]->alloc);
+        free(pending_retired_buffers[i]);
+    }
+    for(uint32_t i = 0u; i < in_flight_retired_buffers.count; i++) {
+        vmaDestroyBuffer(allocator, in_flight_retired_buffers[i]->buffer, in_flight_retired_buffers[i]->alloc);
+        free(in_flight_retired_buffers[i]);
+    }
+    pending_retired_buffers.clean();
+    in_flight_retired_buffers.clean();
+
+    vmaDestroyBuffer(allocator, buffer->buffer, buffer->alloc);
+    free(buffer);
+    buffer = nullptr;
+}
+
+sGPUBuffer* sStagingRing::create_ring_buffer(const VkDeviceSize size) const {
+    sGPUBuffer *new_buffer = (sGPUBuffer*) malloc(sizeof(sGPUBuffer));
+
+    VkBufferCreateInfo buff_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = nullptr,
+        .size = size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+    };
+
+    // Read by the copies of both queues, without ownership transfers
+    if (queue_family_count > 0u) {
+        buff_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buff_create_info.queueFamilyIndexCount = queue_family_count;
+        buff_create_info.pQueueFamilyIndices = queue_families;
+    }
+
+    // CPU_ONLY is host coherent, so no need to flush after the memcpys
+    VmaAllocationCreateInfo vma_alloc_info = {
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+    };
+
+    new_buffer->size = size;
+
+    vk_assert_msg(  vmaCreateBuffer(allocator,
+                                    &buff_create_info,
+                                    &vma_alloc_info,
+                                    &new_buffer->buffer,
+                                    &new_buffer->alloc,
+                                    &new_buffer->alloc_info),
+                    "Error allocating staging ring buffer");
+
+    return new_buffer;
+}
+
+void sStagingRing::grow(const VkDeviceSize min_size) {
+    const VkDeviceSize doubled_size = buffer->size * 2u;
+    const VkDeviceSize new_size = (doubled_size > buffer->size + min_size) ? doubled_size : buffer->size + min_size;
+
+    spdlog::info("Growing staging ring from {} to {} bytes", buffer->size, new_size);
+
+    // The old buffer can still have ranges in flight, or waiting to be recorded
+    pending_retired_buffers.push(buffer);
+
+    buffer = create_ring_buffer(new_size);
+
+    head = 0u;
+    tail = 0u;
+    submitted_head = 0u;
+    is_empty = true;
+}
+
+sGPUBufferView sStagingRing::alloc( const VkDeviceSize size,
+                                    const VkDeviceSize alignment ) {
+    if (is_empty) {
+        head = 0u;
+        tail = 0u;
+        submitted_head = 0u;
+    }
+
+    const VkDeviceSize aligned_head = align_up(head, alignment);
+    VkDeviceSize start = 0u;
+    bool fits = false;
+
+    if (is_empty || head > tail) {
+        // Used region is [tail, head), try after it, or wrap to the start of the ring
+        if (aligned_head + size <= buffer->size) {
+            start = aligned_head;
+            fits = true;
+        } else if (size <= tail) {
+            start = 0u;
+            fits = true;
+        }
+    } else {
+        // Wrapped (or full): the free region is [head, tail)
+        if (aligned_head + size <= tail) {
+            start = aligned_head;
+            fits = true;
+        }
+    }
+
+    if (!fits) {
+        grow(size + alignment);
+        start = 0u;
+    }
+
+    head = start + size;
+    is_empty = false;
+    has_pending_uploads = true;
+
+    return {
+        .raw_buffer = buffer,
+        .offset = start,
+        .size = size
+    };
+}
+
+void sStagingRing::mark_submitted() {
+    submitted_head = head;
+    has_pending_uploads = false;
+
+    for(uint32_t i = 0u; i < pending_retired_buffers.count; i++) {
+        in_flight_retired_buffers.push(pending_retired_buffers[i]);
+    }
+    pending_retired_buffers.clear();
+}
+
+void sStagingRing::recycle() {
+    for(uint32_t i = 0u; i < in_flight_retired_buffers.count; i++) {
+        vmaDestroyBuffer(allocator, in_flight_retired_buffers[i]->buffer, in_flight_retired_buffers[i]->alloc);
+        free(in_flight_retired_buffers[i]);
+    }
+    in_flight_retired_buffers.clear();
+
+    // Everything up to the last submission is free now
+    tail = submitted_head;
+
+    if (!has_pending_uploads) {
+        is_empty = true;
+        head = 0u;
+        tail = 0u;
+        submitted_head = 0u;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include "gpu_buffers.h"
+#include "../../utils/dynamic_array.h"
+
+#define STAGING_RING_INITIAL_SIZE (8u * 1024u * 1024u)
+#define STAGING_RING_DEFAULT_ALIGNMENT 16u
+
+namespace Render {
+
+    /**
+    * Persistently mapped staging memory, one ring per in-flight frame
+    * Uploads get aligned sub-ranges from the head of the ring. The ranges that were
+    * recorded on a submission are given back (the tail moves) once the fence of that
+    * submission has signaled.
+    * When an upload does not fit, the ring moves to a bigger buffer, and the old one is
+    * retired until the GPU has consumed it. So it only grows when a frame needs it.
+    * With a dedicated transfer queue, the ring is read by both the graphics queue (sync copies) and
+    * the transfer queue (async copies) on the same frame, so its buffers are shared by both families.
+    */
+    struct sStagingRing {
+        VmaAllocator            allocator;
+        uint32_t                queue_families[2u] = {};
+        uint32_t                queue_family_count = 0u;
+
+        // Heap allocated, so the sGPUBufferViews to be resolved stay valid after a grow
+        sGPUBuffer              *buffer = nullptr;
+
+        VkDeviceSize            head = 0u;
+        VkDeviceSize            tail = 0u;
+        VkDeviceSize            submitted_head = 0u;
+        bool                    is_empty = true;
+        bool                    has_pending_uploads = false;
+
+        // Buffers replaced by a grow: pending still have copies to record,
+        // in flight are waiting for the fence of the submission that used them
+        sDynamicArray<sGPUBuffer*>  pending_retired_buffers = {};
+        sDynamicArray<sGPUBuffer*>  in_flight_retired_buffers = {};
+
+        // Without a transfer family (UINT32_MAX) the buffers are exclusive to the graphics queue
+        void init(  const VmaAllocator vma_allocator, 
+                    const uint32_t graphics_family, 
+                    const uint32_t transfer_family = UINT32_MAX, 
+                    const VkDeviceSize initial_size = STAGING_RING_INITIAL_SIZE);
+        void clean();
+
+        sGPUBufferView alloc(const VkDeviceSize size, const VkDeviceSize alignment = STAGING_RING_DEFAULT_ALIGNMENT);
+
+        // Call when the copies of all the pending ranges have been recorded & are about to be submitted
+        void mark_submitted();
+        // Call after the fence of the last submission has signaled
+        void recycle();
+
+        inline uint8_t* get_mapped(const sGPUBufferView &view) const {
+            return ((uint8_t*) view.raw_buffer->alloc_info.pMappedData) + view.offset;
+        }
+
+        inline VkDeviceSize get_capacity() const {
+            return buffer->size;
+        }
+
+        sGPUBuffer* create_ring_buffer(const VkDeviceSize size) const;
+        void grow(const VkDeviceSize min_size);
+    };
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "transform_hierarchy.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "../../utils/job_system.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define TRANSFORM_HIERARCHY_SSE
+#include <emmintrin.h>
+#endif
+
+// Column major TRS matrix
+static inline void compose_local_matrix(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale, float *result) {
+    const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+    const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+    const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+    result[0u] = (1.0f - 2.0f * (yy + zz)) * scale.x;
+    result[1u] = 2.0f * (xy + wz) * scale.x;
+    result[2u] = 2.0f * (xz - wy) * scale.x;
+    result[3u] = 0.0f;
+
+    result[4u] = 2.0f * (xy - wz) * scale.y;
+    result[5u] = (1.0f - 2.0f * (xx + zz)) * scale.y;
+    result[6u] = 2.0f * (yz + wx) * scale.y;
+    result[7u] = 0.0f;
+
+    result[8u] = 2.0f * (xz + wy) * scale.z;
+    result[9u] = 2.0f * (yz - wx) * scale.z;
+    result[10u] = (1.0f - 2.0f * (xx + yy)) * scale.z;
+    result[11u] = 0.0f;
+
+    result[12u] = position.x;
+    result[13u] = position.y;
+    result[14u] = position.z;
+    result[15u] = 1.0f;
+}
+
+// result = parent * local, all column major
+static inline void multiply_matrices(const float *parent, const float *local, float *result) {
+#ifdef TRANSFORM_HIERARCHY_SSE
+    const __m128 parent_col0 = _mm_loadu_ps(parent);
+    const __m128 parent_col1 = _mm_loadu_ps(parent + 4u);
+    const __m128 parent_col2 = _mm_loadu_ps(parent + 8u);
+    const __m128 parent_col3 = _mm_loadu_ps(parent + 12u);
+
+    for(uint32_t col = 0u; col < 4u; col++) {
+        const float *local_col = local + col * 4u;
+        __m128 result_col = _mm_mul_ps(parent_col0, _mm_set1_ps(local_col[0u]));
+        result_col = _mm_add_ps(result_col, _mm_mul_ps(parent_col1, _mm_set1_ps(local_col[1u])));
+        result_col = _mm_add_ps(result_col, _mm_mul_ps(parent_col2, _mm_set1_ps(local_col[2u])));
+        result_col = _mm_add_ps(result_col, _mm_mul_ps(parent_col3, _mm_set1_ps(local_col[3u])));
+        _mm_storeu_ps(result + col * 4u, result_col);
+    }
+#else
+    for(uint32_t col = 0u; col < 4u; col++) {
+        for(uint32_t row = 0u; row < 4u; row++) {
+            result[col * 4u + row] =    parent[row] * local[col * 4u] + 
+                                        parent[4u + row] * local[col * 4u + 1u] + 
+                                        parent[8u + row] * local[col * 4u + 2u] + 
+                                        parent[12u + row] * local[col * 4u + 3u];
+        }
+    }
+#endif
+}
+
+// The parents are on previous levels, already updated, so the nodes of the range are independent
+static void update_node_range(Render::sTransformHierarchy &hierarchy, const uint32_t first_node, const uint32_t end_node) {
+    float local[16u];
+    for(uint32_t i = first_node; i < end_node; i++) {
+        const uint32_t parent = hierarchy.parents[i];
+        const bool is_root = parent == TRANSFORM_ROOT;
+        if (!hierarchy.is_dirty[i] && (is_root || !hierarchy.is_dirty[parent])) {
+            continue;
+        }
+        // Marked for the children on the next levels
+        hierarchy.is_dirty[i] = 1u;
+
+        float *world = &hierarchy.world_matrices[i][0u][0u];
+        if (is_root) {
+            compose_local_matrix(hierarchy.local_positions[i], hierarchy.local_rotations[i], hierarchy.local_scales[i], world);
+        } else {
+            compose_local_matrix(hierarchy.local_positions[i], hierarchy.local_rotations[i], hierarchy.local_scales[i], local);
+            multiply_matrices(&hierarchy.world_matrices[parent][0u][0u], local, world);
+        }
+    }
+}
+
+static uint32_t get_node_level(const Render::sTransformHierarchy &hierarchy, const uint32_t node) {
+    // Last level that starts on or before the node
+    uint32_t low = 0u, high = hierarchy.level_starts.count;
+    while(high - low > 1u) {
+        const uint32_t middle = (low + high) / 2u;
+        if (hierarchy.level_starts[middle] <= node) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+uint32_t Render::sTransformHierarchy::add_nodes(const uint32_t count, 
+                                                const uint32_t *node_parents, 
+                                                const glm::vec3 *positions, 
+                                                const glm::quat *rotations, 
+                                                const glm::vec3 *scales) {
+    const uint32_t first_node = node_count;
+    if (count == 0u) {
+        return first_node;
+    }
+
+    if (node_count + count > capacity) {
+        uint32_t new_capacity = (capacity == 0u) ? 64u : capacity;
+        while(new_capacity < node_count + count) {
+            new_capacity *= 2u;
+        }
+
+        parents = (uint32_t*) realloc(parents, sizeof(uint32_t) * new_capacity);
+        local_positions = (glm::vec3*) realloc(local_positions, sizeof(glm::vec3) * new_capacity);
+        local_rotations = (glm::quat*) realloc(local_rotations, sizeof(glm::quat) * new_capacity);
+        local_scales = (glm::vec3*) realloc(local_scales, sizeof(glm::vec3) * new_capacity);
+        world_matrices = (glm::mat4*) realloc(world_matrices, sizeof(glm::mat4) * new_capacity);
+        is_dirty = (uint8_t*) realloc(is_dirty, sizeof(uint8_t) * new_capacity);
+        capacity = new_capacity;
+    }
+
+    memcpy(&local_positions[first_node], positions, sizeof(glm::vec3) * count);
+    memcpy(&local_rotations[first_node], rotations, sizeof(glm::quat) * count);
+    memcpy(&local_scales[first_node], scales, sizeof(glm::vec3) * count);
+    memset(&is_dirty[first_node], 1, sizeof(uint8_t) * count);
+
+    // A new level starts every time the depth changes, the parents of a level are always on the previous ones
+    uint32_t *depths = (uint32_t*) malloc(sizeof(uint32_t) * count);
+    for(uint32_t i = 0u; i < count; i++) {
+        const uint32_t parent = node_parents[i];
+        parents[first_node + i] = (parent == TRANSFORM_ROOT) ? TRANSFORM_ROOT : first_node + parent;
+        depths[i] = (parent == TRANSFORM_ROOT) ? 0u : depths[parent] + 1u;
+
+        if (i == 0u || depths[i] != depths[i - 1u]) {
+            level_starts.push(first_node + i);
+        }
+    }
+    free(depths);
+
+    // If it was clean, first_dirty_level already is the first new level
+    node_count += count;
+
+    return first_node;
+}
+
+void Render::sTransformHierarchy::set_local_transform(  const uint32_t node, 
+                                                        const glm::vec3 &position, 
+                                                        const glm::quat &rotation, 
+                                                        const glm::vec3 &scale) {
+    local_positions[node] = position;
+    local_rotations[node] = rotation;
+    local_scales[node] = scale;
+    is_dirty[node] = 1u;
+
+    const uint32_t level = get_node_level(*this, node);
+    if (level < first_dirty_level) {
+        first_dirty_level = level;
+    }
+}
+
+void Render::sTransformHierarchy::update_world_matrices() {
+    if (first_dirty_level >= level_starts.count) {
+        return;
+    }
+
+    for(uint32_t level = first_dirty_level; level < level_starts.count; level++) {
+        const uint32_t level_start = level_starts[level];
+        const uint32_t level_end = (level + 1u < level_starts.count) ? level_starts[level + 1u] : node_count;
+        const uint32_t batch_count = (level_end - level_start + TRANSFORM_UPDATE_BATCH - 1u) / TRANSFORM_UPDATE_BATCH;
+
+        if (batch_count <= 1u) {
+            update_node_range(*this, level_start, level_end);
+            continue;
+        }
+
+        sJobSystem::get().parallel_for(batch_count, 1u, [this, level_start, level_end](uint32_t batch) {
+            const uint32_t batch_start = level_start + batch * TRANSFORM_UPDATE_BATCH;
+            const uint32_t batch_end = (batch_start + TRANSFORM_UPDATE_BATCH < level_end) ? batch_start + TRANSFORM_UPDATE_BATCH : level_end;
+            update_node_range(*this, batch_start, batch_end);
+        });
+    }
+
+    const uint32_t first_dirty_node = level_starts[first_dirty_level];
+    memset(&is_dirty[first_dirty_node], 0, sizeof(uint8_t) * (node_count - first_dirty_node));
+    first_dirty_level = level_starts.count;
+}
+
+void Render::sTransformHierarchy::clean() {
+    free(parents);
+    free(local_positions);
+    free(local_rotations);
+    free(local_scales);
+    free(world_matrices);
+    free(is_dirty);
+    level_starts.clean();
+
+    *this = {};
+}
\ No newline at end of file
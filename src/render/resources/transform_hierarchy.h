@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../../utils/dynamic_array.h"
+
+#define TRANSFORM_ROOT UINT32_MAX
+// Nodes per job of the world matrix update, smaller levels are updated on the calling thread
+#define TRANSFORM_UPDATE_BATCH 1024u
+
+namespace Render {
+    /**
+    * Scene graph flattened on structure of arrays, depth sorted: the parent of a node is always before it,
+    * and the nodes are grouped on levels (contiguous ranges) whose parents are all on the previous ones.
+    * The world matrices are updated level by level, each level split on the job system,
+    * only for the dirty subtrees. Nodes are only appended, so their indices are stable.
+    */
+    struct sTransformHierarchy {
+        uint32_t    node_count = 0u;
+        uint32_t    capacity = 0u;
+
+        uint32_t    *parents = nullptr;
+        glm::vec3   *local_positions = nullptr;
+        glm::quat   *local_rotations = nullptr;
+        glm::vec3   *local_scales = nullptr;
+        glm::mat4   *world_matrices = nullptr;
+        // Set on the local changes, propagated to the children & cleared by the update
+        uint8_t     *is_dirty = nullptr;
+
+        // First node of each level
+        sDynamicArray<uint32_t> level_starts = {};
+        // Lowest level with a dirty node, level_starts.count if there is none
+        uint32_t    first_dirty_level = 0u;
+
+        // The parents are relative to the added nodes (TRANSFORM_ROOT for the roots), and before their children
+        // Returns the index of the first added node
+        uint32_t add_nodes( const uint32_t count, 
+                            const uint32_t *node_parents, 
+                            const glm::vec3 *positions, 
+                            const glm::quat *rotations, 
+                            const glm::vec3 *scales);
+
+        void set_local_transform(const uint32_t node, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale);
+
+        void update_world_matrices();
+
+        void clean();
+    };
+};
\ No newline at end of file
@@ -1,26 +1,374 @@
 #include "../renderer.h"
 
+#include <cfloat>
+#include <cstring>
+#include <chrono>
 #include <glm/glm.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/transform.hpp>
+#include <spdlog/spdlog.h>
 
 #include "../vk_helpers.h"
+#include "../render_utils.h"
 #include "../resources/gpu_mesh.h"
+#include "../../utils/job_system.h"
 
+void update_resident_meshes(Render::sBackend &renderer);
+void cull_mesh_instances(Render::sBackend &renderer);
+void build_mesh_instances(Render::sBackend &renderer);
+void build_scene_objects(Render::sBackend &renderer);
 void clear_screen(Render::sBackend &renderer);
 void render_background(Render::sBackend &renderer);
+void select_mesh_lods(Render::sBackend &renderer);
+void build_render_queue(Render::sBackend &renderer);
+void cull_meshlets(Render::sBackend &renderer);
 void render_geometry(Render::sBackend &renderer);
+void cull_objects(Render::sBackend &renderer);
+void render_geometry_indirect(Render::sBackend &renderer);
+void copy_to_swapchain(Render::sBackend &renderer);
+
+// CPU path only: its draws are recorded on the render queue order, the binds the sort saves are averaged over the report frames
+// The GPU driven path only sorts its objects, whatever their order it binds an index buffer per index type
+static void report_render_queue_stats(Render::sBackend &renderer) {
+    const Render::sRenderQueueStats &stats = renderer.render_queue.stats;
+    Render::sRenderQueueTotals &totals = renderer.render_queue_totals;
+
+    totals.frames++;
+    totals.draws += stats.draws;
+    totals.unsorted_state_changes += stats.unsorted_state_changes;
+    totals.sorted_state_changes += stats.sorted_state_changes;
+
+    if (totals.frames < RENDER_QUEUE_STATS_REPORT_FRAMES) {
+        return;
+    }
+
+    spdlog::info(   "Render queue: {} draws, {} binds, {} saved by the sort (per frame, over {} frames)", 
+                    totals.draws / totals.frames, 
+                    totals.sorted_state_changes / totals.frames, 
+                    (totals.unsorted_state_changes - totals.sorted_state_changes) / totals.frames, 
+                    totals.frames);
+    totals = {};
+}
 
 void Render::sBackend::render() {
     start_frame_capture();
-    
-    clear_screen(*this);
-    render_background(*this);
-    render_geometry(*this);
+    update_resident_meshes(*this);
+    scene_transforms.update_world_matrices();
+    if (GPU_DRIVEN_RENDERING) {
+        build_scene_objects(*this);
+    } else {
+        cull_mesh_instances(*this);
+        build_mesh_instances(*this);
+        select_mesh_lods(*this);
+        build_render_queue(*this);
+        report_render_queue_stats(*this);
+    }
+
+    add_frame_passes();
+    render_graph.execute(*this, get_current_frame().cmd_buffer);
 
     end_frame_capture();
 }
 
+// The passes only record their commands, the graph adds the image barriers between them
+// Every frame has the same passes, the transient images are aliased from their lifetimes on them
+void Render::sBackend::add_frame_passes() {
+    sFrame &current_frame = get_current_frame();
+
+    render_graph.add_pass("clear_screen", clear_screen);
+    render_graph.use_image(draw_image_graph_idx, GRAPH_IMAGE_TRANSFER_DST, GRAPH_ACCESS_OVERWRITE);
+
+    render_graph.add_pass("background", render_background);
+    render_graph.use_image(draw_image_graph_idx, GRAPH_IMAGE_STORAGE_WRITE, GRAPH_ACCESS_OVERWRITE);
+
+    // Synchronize their buffers themselves
+    render_graph.add_pass("cull", (GPU_DRIVEN_RENDERING) ? cull_objects : cull_meshlets);
+
+    // The color is loaded over the background, the depth cleared
+    render_graph.add_pass("geometry", (GPU_DRIVEN_RENDERING) ? render_geometry_indirect : render_geometry);
+    render_graph.use_image(draw_image_graph_idx, GRAPH_IMAGE_COLOR_ATTACHMENT);
+    render_graph.use_image(depth_image_graph_idx, GRAPH_IMAGE_DEPTH_ATTACHMENT, GRAPH_ACCESS_OVERWRITE);
+
+    render_graph.add_pass("copy_to_swapchain", copy_to_swapchain);
+    render_graph.use_image(draw_image_graph_idx, GRAPH_IMAGE_TRANSFER_SRC);
+    render_graph.use_image(current_frame.swapchain_graph_idx, GRAPH_IMAGE_TRANSFER_DST, GRAPH_ACCESS_OVERWRITE);
+
+    render_graph.add_pass("present", nullptr);
+    render_graph.use_image(current_frame.swapchain_graph_idx, GRAPH_IMAGE_PRESENT);
+}
+
+// Replaces a per frame buffer that is too small, the frame's previous use of it is done
+static void reserve_frame_buffer(   Render::sBackend &renderer, 
+                                    Render::sGPUBuffer *buffer, 
+                                    VkDeviceAddress *buffer_address, 
+                                    const size_t required_size, 
+                                    const size_t min_size, 
+                                    const VkBufferUsageFlags usage, 
+                                    const VmaMemoryUsage mem_usage) {
+    if (buffer->size >= required_size) {
+        return;
+    }
+
+    size_t new_size = (buffer->size > 0u) ? buffer->size : min_size;
+    while(new_size < required_size) {
+        new_size *= 2u;
+    }
+
+    if (buffer->size > 0u) {
+        renderer.clean_buffer(*buffer);
+    }
+
+    *buffer = renderer.create_buffer(   new_size, 
+                                        usage | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, 
+                                        mem_usage, 
+                                        mem_usage == VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+    VkBufferDeviceAddressInfo device_adress_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .pNext = nullptr,
+        .buffer = buffer->buffer
+    };
+    *buffer_address = vkGetBufferDeviceAddress(renderer.gpu_instance.device, &device_adress_info);
+}
+
+static void write_mesh_draw(const Render::sGPUMesh &mesh, Render::sGPUMeshDraw *mesh_draw) {
+    mesh_draw->bounds_center = mesh.bounds_center;
+    mesh_draw->bounds_radius = mesh.bounds_radius;
+    mesh_draw->bounds_extent = mesh.bounds_extent;
+    mesh_draw->first_index = mesh.first_index;
+    mesh_draw->vertex_offset = (int32_t) mesh.first_vertex;
+    mesh_draw->index_size = (mesh.index_type == VK_INDEX_TYPE_UINT16) ? 2u : 4u;
+
+    // Meshes without levels are drawn whole
+    mesh_draw->lod_count = (mesh.lod_count > 0u) ? mesh.lod_count : 1u;
+    mesh_draw->lods[0u] = { 0u, mesh.index_count, 0.0f, 0u };
+    for(uint32_t i = 0u; i < mesh.lod_count; i++) {
+        mesh_draw->lods[i] = { mesh.lods[i].first_index, mesh.lods[i].index_count, mesh.lods[i].error, 0u };
+    }
+}
+
+// The per mesh buffers of the pool are shared by the frames in flight, they are replaced once the GPU is idle
+// Rare (the capacity doubles), so the stall is preferred over keeping the old buffers alive for their frames
+static void grow_draw_buffers(Render::sBackend &renderer, const uint32_t required_draw_count) {
+    Render::sGeometryPool &pool = renderer.geometry_pool;
+
+    uint32_t new_capacity = pool.draw_capacity;
+    while(new_capacity < required_draw_count) {
+        new_capacity *= 2u;
+    }
+    spdlog::info("Growing the mesh draw buffers from {} to {} meshes", pool.draw_capacity, new_capacity);
+
+    vkDeviceWaitIdle(renderer.gpu_instance.device);
+
+    reserve_frame_buffer(   renderer, 
+                            &pool.mesh_draw_buffer, 
+                            &pool.mesh_draw_buffer_address, 
+                            new_capacity * sizeof(Render::sGPUMeshDraw), 
+                            new_capacity * sizeof(Render::sGPUMeshDraw), 
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+    reserve_frame_buffer(   renderer, 
+                            &pool.draw_commands_buffer, 
+                            &pool.draw_commands_buffer_address, 
+                            new_capacity * sizeof(VkDrawIndexedIndirectCommand), 
+                            new_capacity * sizeof(VkDrawIndexedIndirectCommand), 
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+                            VMA_MEMORY_USAGE_GPU_ONLY);
+    pool.draw_capacity = new_capacity;
+
+    // The draw commands are rewritten each frame, only the mesh entries have to be restored
+    Render::sGPUMeshDraw *mesh_draws = (Render::sGPUMeshDraw*) pool.mesh_draw_buffer.alloc_info.pMappedData;
+    for(uint32_t i = 0u; i < renderer.resident_mesh_count; i++) {
+        write_mesh_draw(renderer.meshes[i], &mesh_draws[i]);
+    }
+}
+
+// The meshes are appended as they are staged, so their upload values only grow along the list:
+// the ones already on the GPU are a prefix of it. The rest are drawn once their transfer is finished
+void update_resident_meshes(Render::sBackend &renderer) {
+    uint64_t completed_value = 0u;
+    vkGetSemaphoreCounterValue(renderer.gpu_instance.device, renderer.upload_timeline_semaphore, &completed_value);
+
+    uint32_t resident_count = renderer.resident_mesh_count;
+    while(resident_count < renderer.meshes.count && renderer.meshes[resident_count].upload_timeline_value <= completed_value) {
+        resident_count++;
+    }
+
+    Render::sGeometryPool &pool = renderer.geometry_pool;
+    if (resident_count > pool.draw_capacity) {
+        grow_draw_buffers(renderer, resident_count);
+    }
+
+    // The frames in flight only read the entries of the meshes that were resident for them
+    Render::sGPUMeshDraw *mesh_draws = (Render::sGPUMeshDraw*) pool.mesh_draw_buffer.alloc_info.pMappedData;
+    for(uint32_t i = renderer.resident_mesh_count; i < resident_count; i++) {
+        write_mesh_draw(renderer.meshes[i], &mesh_draws[i]);
+    }
+    renderer.resident_mesh_count = resident_count;
+}
+
+// World space bounds of the resident instances, tested against the camera frustum
+void cull_mesh_instances(Render::sBackend &renderer) {
+    const uint32_t draw_count = renderer.resident_mesh_count;
+
+    renderer.instance_bounds.resize(renderer.mesh_instances.count);
+    renderer.bounds_instances.clear();
+    renderer.bounds_instances.reserve(renderer.mesh_instances.count);
+
+    uint32_t bounds_count = 0u;
+    for(uint32_t i = 0u; i < renderer.mesh_instances.count; i++) {
+        const Render::sMeshInstance &instance = renderer.mesh_instances[i];
+        if (instance.mesh_idx >= draw_count) {
+            continue;
+        }
+
+        const Render::sGPUMesh &mesh = renderer.meshes[instance.mesh_idx];
+        const glm::mat4 &model = renderer.scene_transforms.world_matrices[instance.transform_idx];
+
+        // AABB of the transformed AABB: the extents projected on the abs of the rotation & scale
+        const glm::mat3 abs_model = glm::mat3(glm::abs(glm::vec3(model[0u])), glm::abs(glm::vec3(model[1u])), glm::abs(glm::vec3(model[2u])));
+        const float model_scale = glm::max(glm::length(glm::vec3(model[0u])), glm::max(glm::length(glm::vec3(model[1u])), glm::length(glm::vec3(model[2u]))));
+
+        renderer.instance_bounds.set(   bounds_count, 
+                                        glm::vec3(model * glm::vec4(mesh.bounds_center, 1.0f)), 
+                                        abs_model * mesh.bounds_extent, 
+                                        mesh.bounds_radius * model_scale);
+        renderer.bounds_instances.data[bounds_count++] = i;
+    }
+    renderer.instance_bounds.count = bounds_count;
+    renderer.bounds_instances.count = bounds_count;
+
+    Render::sFrustumPlanes camera_view = {};
+    memcpy(camera_view.planes, renderer.scene_global_data.frustum_planes, sizeof(camera_view.planes));
+    Render::cull_bounds(renderer.instance_bounds, &camera_view, 1u, &renderer.visible_bounds);
+}
+
+// Counting sort of the visible instances by mesh, so each mesh is an instanced draw over a contiguous range
+// The instance data is written straight to the frame's mapped buffer, on draw order
+void build_mesh_instances(Render::sBackend &renderer) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+    const uint32_t draw_count = renderer.resident_mesh_count;
+
+    renderer.mesh_first_instance.clear();
+    renderer.mesh_instance_count.clear();
+    uint32_t *first_instance = renderer.mesh_first_instance.push_n(draw_count);
+    uint32_t *instance_count = renderer.mesh_instance_count.push_n(draw_count);
+    memset(instance_count, 0, sizeof(uint32_t) * draw_count);
+
+    // Only resident instances have bounds
+    const uint32_t total_instance_count = renderer.visible_bounds.count;
+    for(uint32_t i = 0u; i < total_instance_count; i++) {
+        const uint32_t instance_idx = renderer.bounds_instances[renderer.visible_bounds[i]];
+        instance_count[renderer.mesh_instances[instance_idx].mesh_idx]++;
+    }
+
+    uint32_t instance_offset = 0u;
+    for(uint32_t i = 0u; i < draw_count; i++) {
+        first_instance[i] = instance_offset;
+        instance_offset += instance_count[i];
+        instance_count[i] = 0u;
+    }
+
+    renderer.sorted_instances.clear();
+    uint32_t *sorted_instances = renderer.sorted_instances.push_n(total_instance_count);
+    for(uint32_t i = 0u; i < total_instance_count; i++) {
+        const uint32_t instance_idx = renderer.bounds_instances[renderer.visible_bounds[i]];
+        const uint32_t mesh_idx = renderer.mesh_instances[instance_idx].mesh_idx;
+        sorted_instances[first_instance[mesh_idx] + instance_count[mesh_idx]++] = instance_idx;
+    }
+
+    if (total_instance_count == 0u) {
+        return;
+    }
+
+    reserve_frame_buffer(   renderer, 
+                            &current_frame.instance_buffer, 
+                            &current_frame.instance_buffer_address, 
+                            sizeof(Render::sGPUInstance) * total_instance_count, 
+                            sizeof(Render::sGPUInstance) * 1024u, 
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+    // Write combined memory: sequential writes only
+    Render::sGPUInstance *gpu_instances = (Render::sGPUInstance*) current_frame.instance_buffer.alloc_info.pMappedData;
+    for(uint32_t i = 0u; i < total_instance_count; i++) {
+        const Render::sMeshInstance &instance = renderer.mesh_instances[sorted_instances[i]];
+        const Render::sGPUMesh &mesh = renderer.meshes[instance.mesh_idx];
+
+        gpu_instances[i] = {
+            .model_matrix = renderer.scene_transforms.world_matrices[instance.transform_idx],
+            .position_min = glm::vec4(mesh.position_min, 0.0f),
+            .position_extent = glm::vec4(mesh.position_extent, 0.0f)
+        };
+    }
+}
+
+// Index type of the mesh, the only bind that changes between the mesh draws
+static inline uint32_t get_draw_material(const Render::sGPUMesh &mesh) {
+    return (mesh.index_type == VK_INDEX_TYPE_UINT16) ? 0u : 1u;
+}
+
+// GPU driven path: all the resident instances go to the frame's instance buffer, unculled
+// Each one is an object of the object culling, that reads its mesh from position_min.w
+// They are written on the render queue order: the culling appends the draws in about the order of its threads,
+// so the draws of each index type list end up roughly front to back
+void build_scene_objects(Render::sBackend &renderer) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+    const uint32_t draw_count = renderer.resident_mesh_count;
+    const glm::mat4 &view = renderer.scene_global_data.view;
+
+    renderer.scene_object_count = 0u;
+    renderer.render_queue.clear();
+    if (renderer.mesh_instances.count == 0u) {
+        return;
+    }
+
+    for(uint32_t i = 0u; i < renderer.mesh_instances.count; i++) {
+        const Render::sMeshInstance &instance = renderer.mesh_instances[i];
+        if (instance.mesh_idx >= draw_count) {
+            continue;
+        }
+
+        const Render::sGPUMesh &mesh = renderer.meshes[instance.mesh_idx];
+        const glm::mat4 &model = renderer.scene_transforms.world_matrices[instance.transform_idx];
+        const float view_depth = -(view * (model * glm::vec4(mesh.bounds_center, 1.0f))).z;
+        renderer.render_queue.add(RENDER_PASS_OPAQUE, RENDER_PIPELINE_MESH, get_draw_material(mesh), view_depth, i);
+    }
+    renderer.render_queue.sort();
+
+    reserve_frame_buffer(   renderer, 
+                            &current_frame.instance_buffer, 
+                            &current_frame.instance_buffer_address, 
+                            sizeof(Render::sGPUInstance) * renderer.mesh_instances.count, 
+                            sizeof(Render::sGPUInstance) * 1024u, 
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+    // Write combined memory: sequential writes only
+    Render::sGPUInstance *gpu_instances = (Render::sGPUInstance*) current_frame.instance_buffer.alloc_info.pMappedData;
+    const uint32_t object_count = renderer.render_queue.keys.count;
+    for(uint32_t i = 0u; i < object_count; i++) {
+        const Render::sMeshInstance &instance = renderer.mesh_instances[renderer.render_queue.get_draw(i)];
+        const Render::sGPUMesh &mesh = renderer.meshes[instance.mesh_idx];
+
+        gpu_instances[i] = {
+            .model_matrix = renderer.scene_transforms.world_matrices[instance.transform_idx],
+            .position_min = glm::vec4(mesh.position_min, glm::uintBitsToFloat(instance.mesh_idx)),
+            .position_extent = glm::vec4(mesh.position_extent, glm::uintBitsToFloat(renderer.render_queue.get_draw(i)))
+        };
+    }
+    renderer.scene_object_count = object_count;
+
+    // Each list can hold all the objects
+    const uint32_t command_capacity = (object_count > 1024u) ? object_count : 1024u;
+    reserve_frame_buffer(   renderer, 
+                            &current_frame.indirect_draw_buffer, 
+                            &current_frame.indirect_draw_buffer_address, 
+                            INDIRECT_DRAW_COUNTS_SIZE + 2u * sizeof(VkDrawIndexedIndirectCommand) * object_count, 
+                            INDIRECT_DRAW_COUNTS_SIZE + 2u * sizeof(VkDrawIndexedIndirectCommand) * command_capacity, 
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+                            VMA_MEMORY_USAGE_GPU_ONLY);
+    current_frame.indirect_draw_capacity = (uint32_t) ((current_frame.indirect_draw_buffer.size - INDIRECT_DRAW_COUNTS_SIZE) / (2u * sizeof(VkDrawIndexedIndirectCommand)));
+}
+
 void clear_screen(Render::sBackend &renderer) {
     VkClearColorValue clear_color = {{ 0.0f, 0.0f, std::abs(std::sin(renderer.frame_number / 60.f)), 1.0f  }};
 
@@ -28,7 +376,7 @@ void clear_screen(Render::sBackend &renderer) {
 
     vkCmdClearColorImage(   renderer.get_current_frame().cmd_buffer, 
                             renderer.draw_image.image, 
-                            VK_IMAGE_LAYOUT_GENERAL, 
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
                             &clear_color, 
                             1u,
                             &clear_range);
@@ -69,14 +417,201 @@ void render_background(Render::sBackend &renderer) {
                     1u );
 }
 
-void render_geometry(Render::sBackend &renderer) {
+// The draws come from the culling, so the level is picked before it, from the projected error of each LOD
+// All the instances of a mesh share its culled indices, so they share the level of the closest one
+void select_mesh_lods(Render::sBackend &renderer) {
+    const Render::sGPUSceneGlobalData &scene_data = renderer.scene_global_data;
+    const glm::vec3 camera_position = glm::vec3(scene_data.camera_position);
+    // Error on mesh units at distance 1, to pixels (abs, the Y flip of the projection)
+    const float projection_scale = std::abs(scene_data.proj[1][1]) * renderer.swapchain_data.extent.height * 0.5f;
+
+    const uint32_t draw_count = renderer.resident_mesh_count;
+    for(uint32_t i = 0u; i < draw_count; i++) {
+        Render::sGPUMesh &curr_mesh = renderer.meshes[i];
+        if (curr_mesh.lod_count <= 1u) {
+            curr_mesh.current_lod = 0u;
+            continue;
+        }
+
+        float error_to_pixels = 0.0f;
+        const uint32_t first_instance = renderer.mesh_first_instance[i];
+        for(uint32_t j = 0u; j < renderer.mesh_instance_count[i]; j++) {
+            const Render::sMeshInstance &instance = renderer.mesh_instances[renderer.sorted_instances[first_instance + j]];
+            const glm::mat4 &model = renderer.scene_transforms.world_matrices[instance.transform_idx];
+            const float model_scale = glm::max(glm::length(glm::vec3(model[0u])), glm::max(glm::length(glm::vec3(model[1u])), glm::length(glm::vec3(model[2u]))));
+            const glm::vec3 world_center = glm::vec3(model * glm::vec4(curr_mesh.bounds_center, 1.0f));
+
+            // Closest point of the bounds, inside of them everything is full detail
+            const float distance = glm::length(world_center - camera_position) - curr_mesh.bounds_radius * model_scale;
+            const float instance_error_to_pixels = (distance > 1e-4f) ? model_scale * projection_scale / distance : FLT_MAX;
+            error_to_pixels = glm::max(error_to_pixels, instance_error_to_pixels);
+        }
+
+        uint32_t lod = (curr_mesh.current_lod < curr_mesh.lod_count) ? curr_mesh.current_lod : curr_mesh.lod_count - 1u;
+        while(lod > 0u && curr_mesh.lods[lod].error * error_to_pixels > LOD_ERROR_THRESHOLD_PIXELS) {
+            lod--;
+        }
+        while(lod + 1u < curr_mesh.lod_count && curr_mesh.lods[lod + 1u].error * error_to_pixels < LOD_ERROR_THRESHOLD_PIXELS * LOD_HYSTERESIS) {
+            lod++;
+        }
+        curr_mesh.current_lod = lod;
+    }
+}
+
+// A draw per mesh with visible instances, grouped by their binds & front to back from the closest instance
+void build_render_queue(Render::sBackend &renderer) {
+    const glm::mat4 &view = renderer.scene_global_data.view;
+    const uint32_t draw_count = renderer.resident_mesh_count;
+
+    renderer.render_queue.clear();
+    for(uint32_t i = 0u; i < draw_count; i++) {
+        if (renderer.mesh_instance_count[i] == 0u) {
+            continue;
+        }
+
+        const Render::sGPUMesh &curr_mesh = renderer.meshes[i];
+        float view_depth = FLT_MAX;
+        const uint32_t first_instance = renderer.mesh_first_instance[i];
+        for(uint32_t j = 0u; j < renderer.mesh_instance_count[i]; j++) {
+            const Render::sMeshInstance &instance = renderer.mesh_instances[renderer.sorted_instances[first_instance + j]];
+            const glm::mat4 &model = renderer.scene_transforms.world_matrices[instance.transform_idx];
+            view_depth = glm::min(view_depth, -(view * (model * glm::vec4(curr_mesh.bounds_center, 1.0f))).z);
+        }
+
+        renderer.render_queue.add(RENDER_PASS_OPAQUE, RENDER_PIPELINE_MESH, get_draw_material(curr_mesh), view_depth, i);
+    }
+    renderer.render_queue.sort();
+}
+
+void cull_meshlets(Render::sBackend &renderer) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+    const Render::sGeometryPool &pool = renderer.geometry_pool;
+    const uint32_t draw_count = renderer.resident_mesh_count;
+
+    if (draw_count == 0u) {
+        return;
+    }
+
+    // The previous frame's draws still read the culled indices & the commands
+    {
+        VkMemoryBarrier2 draw_to_clear = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+            .srcAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        };
+        VkDependencyInfo dep_info = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .memoryBarrierCount = 1u,
+            .pMemoryBarriers = &draw_to_clear
+        };
+        vkCmdPipelineBarrier2(current_frame.cmd_buffer, &dep_info);
+    }
+
+    vkCmdFillBuffer(current_frame.cmd_buffer, 
+                    pool.draw_commands_buffer.buffer, 
+                    0u, 
+                    draw_count * sizeof(VkDrawIndexedIndirectCommand), 
+                    0u);
+
+    {
+        VkMemoryBarrier2 clear_to_cull = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        };
+        VkDependencyInfo dep_info = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .memoryBarrierCount = 1u,
+            .pMemoryBarriers = &clear_to_cull
+        };
+        vkCmdPipelineBarrier2(current_frame.cmd_buffer, &dep_info);
+    }
+
+    vkCmdBindPipeline(  current_frame.cmd_buffer, 
+                        VK_PIPELINE_BIND_POINT_COMPUTE,
+                        renderer.meshlet_cull_compute_pipeline);
+
+    vkCmdBindDescriptorSets(current_frame.cmd_buffer, 
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            renderer.meshlet_cull_compute_pipeline_layout,
+                            0u,
+                            1u,
+                            &current_frame.gpu_comon_scene_descriptor_set,
+                            0u,
+                            nullptr);
+
+    for(uint32_t i = 0u; i < draw_count; i++) {
+        if (renderer.mesh_instance_count[i] == 0u) {
+            continue;
+        }
+
+        const Render::sGPUMesh &curr_mesh = renderer.meshes[i];
+        const Render::sMeshLOD &lod = curr_mesh.lods[curr_mesh.current_lod];
+
+        current_frame.use_resource(curr_mesh.upload_timeline_value);
+
+        // The culled indices of any level fit on the mesh's culled range, it is sized for all of them
+        Render::sMeshletCullPushConstant push_constants = {
+            .instance_buffer = current_frame.instance_buffer_address,
+            .meshlet_buffer = pool.meshlet_buffer_address,
+            .index_buffer = pool.index_buffer_address,
+            .culled_index_buffer = pool.culled_index_buffer_address,
+            .draw_commands_buffer = pool.draw_commands_buffer_address,
+            .first_meshlet = curr_mesh.first_meshlet + lod.first_meshlet,
+            .meshlet_count = lod.meshlet_count,
+            .first_index = curr_mesh.first_index,
+            .first_culled_index = curr_mesh.first_culled_index,
+            .first_vertex = curr_mesh.first_vertex,
+            .draw_idx = i,
+            .index_size = (curr_mesh.index_type == VK_INDEX_TYPE_UINT16) ? 2u : 4u,
+            .first_instance = renderer.mesh_first_instance[i],
+            .instance_count = renderer.mesh_instance_count[i]
+        };
+
+        vkCmdPushConstants( current_frame.cmd_buffer, 
+                            renderer.meshlet_cull_compute_pipeline_layout, 
+                            VK_SHADER_STAGE_COMPUTE_BIT, 
+                            0u, 
+                            sizeof(Render::sMeshletCullPushConstant), 
+                            &push_constants);
+
+        vkCmdDispatch(  current_frame.cmd_buffer, 
+                        (lod.meshlet_count + MESHLET_CULL_GROUP_SIZE - 1u) / MESHLET_CULL_GROUP_SIZE, 
+                        1u, 
+                        1u );
+    }
+
+    {
+        VkMemoryBarrier2 cull_to_draw = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+            .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT
+        };
+        VkDependencyInfo dep_info = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .memoryBarrierCount = 1u,
+            .pMemoryBarriers = &cull_to_draw
+        };
+        vkCmdPipelineBarrier2(current_frame.cmd_buffer, &dep_info);
+    }
+}
+
+// Rendering to the draw image, with the draws inline or from secondary command buffers
+static void begin_geometry_rendering(Render::sBackend &renderer, const VkRenderingFlags flags) {
     Render::sFrame &current_frame = renderer.get_current_frame();
 
-    VK_Helpers::transition_image_layout(current_frame.cmd_buffer,
-                                        renderer.draw_image.image, 
-                                        VK_IMAGE_LAYOUT_GENERAL, 
-                                        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    
     VkRenderingAttachmentInfo color_attachment_info = VK_Helpers::attachment_info(  renderer.draw_image.image_view, 
                                                                                     nullptr, 
                                                                                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
@@ -87,10 +622,16 @@ void render_geometry(Render::sBackend &renderer) {
     VkRenderingInfo render_info = VK_Helpers::create_render_info(   renderer.swapchain_data.extent, 
                                                                     &color_attachment_info, 
                                                                     &depth_attachment_info  );
+    render_info.flags = flags;
 
     vkCmdBeginRendering(current_frame.cmd_buffer, &render_info);
+}
+
+// Mesh pipeline, dynamic state & scene data, the secondary command buffers do not inherit them
+static void bind_geometry_state(Render::sBackend &renderer, VkCommandBuffer cmd) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
 
-    vkCmdBindPipeline(current_frame.cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.render_mesh_pipeline);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.render_mesh_pipeline);
 
     // Set viewport
     {
@@ -102,7 +643,7 @@ void render_geometry(Render::sBackend &renderer) {
             .maxDepth = 1.0f
         };
 
-        vkCmdSetViewport(current_frame.cmd_buffer, 0u, 1u, &viewport);
+        vkCmdSetViewport(cmd, 0u, 1u, &viewport);
     }
 
     // Set render scissor
@@ -115,10 +656,10 @@ void render_geometry(Render::sBackend &renderer) {
             }
         };
 
-        vkCmdSetScissor(current_frame.cmd_buffer, 0u, 1u, &scissor);
+        vkCmdSetScissor(cmd, 0u, 1u, &scissor);
     }
 
-    vkCmdBindDescriptorSets(current_frame.cmd_buffer, 
+    vkCmdBindDescriptorSets(cmd, 
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
                             renderer.render_mesh_pipeline_layout,
                             0u,
@@ -126,19 +667,321 @@ void render_geometry(Render::sBackend &renderer) {
                             &current_frame.gpu_comon_scene_descriptor_set,
                             0u,
                             nullptr);
-    
-    for(uint32_t i = 0u; i < renderer.mesh_count; i++) {
+
+    // Per instance data from gl_InstanceIndex, the draws only set their first instance
+    const Render::sMeshPushConstant push_constants = {
+        .vertex_buffer = renderer.geometry_pool.vertex_buffer_address,
+        .instance_buffer = current_frame.instance_buffer_address
+    };
+    vkCmdPushConstants(cmd, renderer.render_mesh_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0u, sizeof(Render::sMeshPushConstant), &push_constants);
+}
+
+// Draws [first_draw, end_draw) of the render queue
+// Only reads the renderer, so the ranges can be recorded from several threads (the meshlet culling marked the meshes as used)
+static void record_mesh_draws(const Render::sBackend &renderer, VkCommandBuffer cmd, const uint32_t first_draw, const uint32_t end_draw) {
+    // All the meshes live on the scene's geometry pool, only the triangles of the visible meshlets are drawn
+    // The culled buffer keeps the index type of each mesh, only rebind it when it changes
+    // The render queue groups the draws by it, so it changes at most once per group
+    VkIndexType bound_index_type = VK_INDEX_TYPE_MAX_ENUM;
+
+    const Render::sRenderQueue &queue = renderer.render_queue;
+    for(uint32_t draw = first_draw; draw < end_draw; draw++) {
+        const uint32_t i = queue.get_draw(draw);
         const Render::sGPUMesh &curr_mesh = renderer.meshes[i];
 
-        Render::sMeshPushConstant push_constants = {
-            .mvp_matrix = glm::translate(glm::vec3{ -2.0f + (2.0f * i), 0.0f, 0.0f }),
-            .vertex_buffer = curr_mesh.vertex_buffer_address
+        if (curr_mesh.index_type != bound_index_type) {
+            vkCmdBindIndexBuffer(cmd, renderer.geometry_pool.culled_index_buffer.buffer, 0u, curr_mesh.index_type);
+            bound_index_type = curr_mesh.index_type;
+        }
+
+        // The cull wrote the instance range of the mesh on its command
+        // gl_VertexIndex includes the vertex offset, so the vertex pulling indexes the pool directly
+        vkCmdDrawIndexedIndirect(   cmd, 
+                                    renderer.geometry_pool.draw_commands_buffer.buffer, 
+                                    i * sizeof(VkDrawIndexedIndirectCommand), 
+                                    1u, 
+                                    sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+// Each recording thread has its own pool on the frame, the frame's fence was waited so it can be reset
+static VkCommandBuffer begin_secondary_draws(Render::sBackend &renderer, const uint32_t thread_idx) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+    VkCommandBuffer cmd = current_frame.draw_cmd_buffers[thread_idx];
+
+    vk_assert_msg(  vkResetCommandPool(renderer.gpu_instance.device, current_frame.draw_cmd_pools[thread_idx], 0u), 
+                    "Error resetting a draw command pool");
+
+    const VkFormat color_format = (VkFormat) renderer.draw_image.format;
+    VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .pNext = nullptr,
+        .colorAttachmentCount = 1u,
+        .pColorAttachmentFormats = &color_format,
+        .depthAttachmentFormat = (VkFormat) renderer.depth_image.format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+    };
+    VkCommandBufferInheritanceInfo inheritance_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = &inheritance_rendering_info
+    };
+
+    VkCommandBufferBeginInfo cmd_begin = VK_Helpers::create_cmd_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+    cmd_begin.pInheritanceInfo = &inheritance_info;
+
+    vk_assert_msg(  vkBeginCommandBuffer(cmd, &cmd_begin), 
+                    "Error beginning a draw command buffer");
+
+    bind_geometry_state(renderer, cmd);
+
+    return cmd;
+}
+
+static void record_secondary_mesh_draws(Render::sBackend &renderer, const uint32_t thread_idx, const uint32_t first_draw, const uint32_t end_draw) {
+    VkCommandBuffer cmd = begin_secondary_draws(renderer, thread_idx);
+    record_mesh_draws(renderer, cmd, first_draw, end_draw);
+
+    vk_assert_msg(  vkEndCommandBuffer(cmd), 
+                    "Error ending a draw command buffer");
+}
+
+// The draw list is split on even ranges, recorded on secondary command buffers by the job system
+// and executed on the queue order. Small lists are recorded inline
+// Only this CPU path records a draw per mesh: the GPU driven path records two indirect count draws whatever
+// the object count, so it has nothing to split. DRAW_RECORDING_BENCHMARK measures the scaling with synthetic draws
+void render_geometry(Render::sBackend &renderer) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+    const Render::sRenderQueue &queue = renderer.render_queue;
+    const uint32_t draw_count = queue.keys.count;
+
+    const uint32_t max_thread_count = draw_count / RENDER_MIN_DRAWS_PER_THREAD;
+    const uint32_t thread_count = (max_thread_count < renderer.recording_thread_count) ? max_thread_count : renderer.recording_thread_count;
+
+    if (thread_count <= 1u) {
+        begin_geometry_rendering(renderer, 0u);
+        bind_geometry_state(renderer, current_frame.cmd_buffer);
+        record_mesh_draws(renderer, current_frame.cmd_buffer, 0u, draw_count);
+    } else {
+        begin_geometry_rendering(renderer, VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+
+        sJobSystem::get().parallel_for(thread_count, 1u, [&renderer, draw_count, thread_count](const uint32_t thread_idx) {
+            record_secondary_mesh_draws(renderer, 
+                                        thread_idx, 
+                                        (uint32_t) (((uint64_t) draw_count * thread_idx) / thread_count), 
+                                        (uint32_t) (((uint64_t) draw_count * (thread_idx + 1u)) / thread_count));
+        });
+
+        vkCmdExecuteCommands(current_frame.cmd_buffer, thread_count, current_frame.draw_cmd_buffers);
+    }
+
+    vkCmdEndRendering(current_frame.cmd_buffer);
+}
+
+// Same commands as the mesh draws, on the pool's draw commands instead of the render queue's meshes
+static void record_synthetic_draws(const Render::sBackend &renderer, VkCommandBuffer cmd, const uint32_t first_draw, const uint32_t end_draw) {
+    const Render::sGeometryPool &pool = renderer.geometry_pool;
+
+    vkCmdBindIndexBuffer(cmd, pool.culled_index_buffer.buffer, 0u, VK_INDEX_TYPE_UINT32);
+    for(uint32_t draw = first_draw; draw < end_draw; draw++) {
+        vkCmdDrawIndexedIndirect(   cmd, 
+                                    pool.draw_commands_buffer.buffer, 
+                                    (draw % pool.draw_capacity) * sizeof(VkDrawIndexedIndirectCommand), 
+                                    1u, 
+                                    sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+// The command buffers are never submitted, only the recording is timed
+static double time_draw_recording(Render::sBackend &renderer, const uint32_t draw_count, const uint32_t thread_count) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    sJobSystem::get().parallel_for(thread_count, 1u, [&renderer, draw_count, thread_count](const uint32_t thread_idx) {
+        VkCommandBuffer cmd = begin_secondary_draws(renderer, thread_idx);
+        record_synthetic_draws( renderer, 
+                                cmd, 
+                                (uint32_t) (((uint64_t) draw_count * thread_idx) / thread_count), 
+                                (uint32_t) (((uint64_t) draw_count * (thread_idx + 1u)) / thread_count));
+
+        vk_assert_msg(  vkEndCommandBuffer(cmd), 
+                        "Error ending a draw command buffer");
+    });
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Before the first frame, on the current frame's secondary command buffers
+// The scene import shares the workers on startup, so each thread count keeps its best run
+void benchmark_draw_recording(Render::sBackend &renderer, const uint32_t draw_count) {
+    double single_thread_time = 0.0;
+    for(uint32_t thread_count = 1u; thread_count <= renderer.recording_thread_count; thread_count *= 2u) {
+        double best_time = DBL_MAX;
+        for(uint32_t run = 0u; run < DRAW_RECORDING_BENCHMARK_RUNS; run++) {
+            best_time = glm::min(best_time, time_draw_recording(renderer, draw_count, thread_count));
+        }
+
+        if (thread_count == 1u) {
+            single_thread_time = best_time;
+        }
+
+        spdlog::info(   "Draw recording, {} draws on {} threads: {:.2f} ms ({:.2f}x the single thread)", 
+                        draw_count, 
+                        thread_count, 
+                        best_time * 1e3, 
+                        single_thread_time / best_time);
+    }
+}
+
+// GPU driven path: frustum test & LOD selection of every object on a thread, the visible ones appended to the
+// draw list of their index type. The recording is the same whatever the object count
+void cull_objects(Render::sBackend &renderer) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+    const uint32_t draw_count = renderer.resident_mesh_count;
+
+    if (renderer.scene_object_count == 0u) {
+        return;
+    }
+
+    // The uploads finish in order, the last resident mesh covers the rest
+    current_frame.use_resource(renderer.meshes[draw_count - 1u].upload_timeline_value);
+
+    // The levels are indexed by mesh instance and kept between frames, so the other frames in flight use the buffer
+    const size_t object_lod_size = sizeof(uint32_t) * renderer.mesh_instances.count;
+    if (renderer.object_lod_buffer.size < object_lod_size) {
+        if (renderer.object_lod_buffer.size > 0u) {
+            vkDeviceWaitIdle(renderer.gpu_instance.device);
+        }
+        reserve_frame_buffer(   renderer, 
+                                &renderer.object_lod_buffer, 
+                                &renderer.object_lod_buffer_address, 
+                                object_lod_size, 
+                                sizeof(uint32_t) * 1024u, 
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+                                VMA_MEMORY_USAGE_GPU_ONLY);
+        // All the instances start on the full detail
+        vkCmdFillBuffer(current_frame.cmd_buffer, 
+                        renderer.object_lod_buffer.buffer, 
+                        0u, 
+                        VK_WHOLE_SIZE, 
+                        0u);
+    }
+
+    // The frame's previous draws from the buffer were waited with its fence
+    vkCmdFillBuffer(current_frame.cmd_buffer, 
+                    current_frame.indirect_draw_buffer.buffer, 
+                    0u, 
+                    INDIRECT_DRAW_COUNTS_SIZE, 
+                    0u);
+
+    {
+        // Also after the levels written by the previous frame's culling
+        VkMemoryBarrier2 clear_to_cull = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        };
+        VkDependencyInfo dep_info = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .memoryBarrierCount = 1u,
+            .pMemoryBarriers = &clear_to_cull
+        };
+        vkCmdPipelineBarrier2(current_frame.cmd_buffer, &dep_info);
+    }
+
+    vkCmdBindPipeline(  current_frame.cmd_buffer, 
+                        VK_PIPELINE_BIND_POINT_COMPUTE,
+                        renderer.object_cull_compute_pipeline);
+
+    vkCmdBindDescriptorSets(current_frame.cmd_buffer, 
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            renderer.object_cull_compute_pipeline_layout,
+                            0u,
+                            1u,
+                            &current_frame.gpu_comon_scene_descriptor_set,
+                            0u,
+                            nullptr);
+
+    // Error on mesh units at distance 1, to pixels (abs, the Y flip of the projection)
+    const Render::sObjectCullPushConstant push_constants = {
+        .instance_buffer = current_frame.instance_buffer_address,
+        .mesh_draw_buffer = renderer.geometry_pool.mesh_draw_buffer_address,
+        .indirect_draw_buffer = current_frame.indirect_draw_buffer_address,
+        .object_lod_buffer = renderer.object_lod_buffer_address,
+        .object_count = renderer.scene_object_count,
+        .command_capacity = current_frame.indirect_draw_capacity,
+        .projection_scale = std::abs(renderer.scene_global_data.proj[1][1]) * renderer.swapchain_data.extent.height * 0.5f,
+        .lod_error_threshold = LOD_ERROR_THRESHOLD_PIXELS,
+        .lod_hysteresis = LOD_HYSTERESIS,
+        .pad = 0u
+    };
+
+    vkCmdPushConstants( current_frame.cmd_buffer, 
+                        renderer.object_cull_compute_pipeline_layout, 
+                        VK_SHADER_STAGE_COMPUTE_BIT, 
+                        0u, 
+                        sizeof(Render::sObjectCullPushConstant), 
+                        &push_constants);
+
+    vkCmdDispatch(  current_frame.cmd_buffer, 
+                    (renderer.scene_object_count + OBJECT_CULL_GROUP_SIZE - 1u) / OBJECT_CULL_GROUP_SIZE, 
+                    1u, 
+                    1u );
+
+    {
+        VkMemoryBarrier2 cull_to_draw = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+            .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT
         };
+        VkDependencyInfo dep_info = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .memoryBarrierCount = 1u,
+            .pMemoryBarriers = &cull_to_draw
+        };
+        vkCmdPipelineBarrier2(current_frame.cmd_buffer, &dep_info);
+    }
+}
 
-        vkCmdPushConstants(current_frame.cmd_buffer, renderer.render_mesh_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0u, sizeof(Render::sMeshPushConstant), &push_constants);
-        vkCmdBindIndexBuffer(current_frame.cmd_buffer, curr_mesh.index_buffer.buffer, 0u, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(current_frame.cmd_buffer, curr_mesh.index_count, 1u, 0u, 0u, 0u);
+// The objects are drawn from the pool's index buffer, without meshlet culling
+// An index buffer can only be bound with a type, so there is a draw per index type
+void render_geometry_indirect(Render::sBackend &renderer) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+
+    begin_geometry_rendering(renderer, 0u);
+    bind_geometry_state(renderer, current_frame.cmd_buffer);
+
+    if (renderer.scene_object_count > 0u) {
+        const VkIndexType index_types[2u] = { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 };
+        for(uint32_t i = 0u; i < 2u; i++) {
+            vkCmdBindIndexBuffer(current_frame.cmd_buffer, renderer.geometry_pool.index_buffer.buffer, 0u, index_types[i]);
+
+            vkCmdDrawIndexedIndirectCount(  current_frame.cmd_buffer, 
+                                            current_frame.indirect_draw_buffer.buffer, 
+                                            INDIRECT_DRAW_COUNTS_SIZE + i * current_frame.indirect_draw_capacity * sizeof(VkDrawIndexedIndirectCommand), 
+                                            current_frame.indirect_draw_buffer.buffer, 
+                                            i * sizeof(uint32_t), 
+                                            current_frame.indirect_draw_capacity, 
+                                            sizeof(VkDrawIndexedIndirectCommand));
+        }
     }
 
     vkCmdEndRendering(current_frame.cmd_buffer);
+}
+
+void copy_to_swapchain(Render::sBackend &renderer) {
+    Render::sFrame &current_frame = renderer.get_current_frame();
+
+    VK_Helpers::copy_image_image(   current_frame.cmd_buffer, 
+                                    renderer.draw_image.image, 
+                                    { renderer.draw_image.dims.width, renderer.draw_image.dims.height, 1 }, 
+                                    renderer.swapchain_data.images[current_frame.current_swapchain_index], 
+                                    { renderer.swapchain_data.extent.width, renderer.swapchain_data.extent.height, 1 });
 }
\ No newline at end of file
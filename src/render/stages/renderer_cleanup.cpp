@@ -3,14 +3,73 @@
 #include <VkBootstrap.h>
 
 void Render::sBackend::clean() {
+    vkDeviceWaitIdle(gpu_instance.device);
+
     for(uint32_t i = FRAME_BUFFER_COUNT; i > 0u; i--) {
-        vkDestroyFence(gpu_instance.device, in_flight_frames[i].render_fence, nullptr);
-        vkDestroySemaphore(gpu_instance.device, in_flight_frames[i].render_semaphore, nullptr);
-        vkDestroySemaphore(gpu_instance.device, in_flight_frames[i].swapchain_semaphore, nullptr);
+        sFrame &frame = in_flight_frames[i - 1u];
+
+        vkDestroyFence(gpu_instance.device, frame.render_fence, nullptr);
+        vkDestroySemaphore(gpu_instance.device, frame.render_semaphore, nullptr);
+        vkDestroySemaphore(gpu_instance.device, frame.swapchain_semaphore, nullptr);
+
+        vkDestroyCommandPool(gpu_instance.device, frame.cmd_pool, nullptr);
+        for(uint32_t j = 0u; j < recording_thread_count; j++) {
+            vkDestroyCommandPool(gpu_instance.device, frame.draw_cmd_pools[j], nullptr);
+        }
+        if (gpu_instance.has_transfer_queue) {
+            vkDestroyCommandPool(gpu_instance.device, frame.transfer_cmd_pool, nullptr);
+        }
 
-        vkDestroyCommandPool(gpu_instance.device, in_flight_frames[i].cmd_pool, nullptr);
+        frame.staging_ring.clean();
+        frame.staging_to_resolve.clean();
+
+        if (frame.instance_buffer.size > 0u) {
+            clean_buffer(frame.instance_buffer);
+        }
+        if (frame.indirect_draw_buffer.size > 0u) {
+            clean_buffer(frame.indirect_draw_buffer);
+        }
     }
 
+    async_staging_to_resolve.clean();
+    staging_copy_scratch.clean();
+
+    texture_loader.clean();
+    for(uint32_t i = 0u; i < textures.count; i++) {
+        if (textures[i].image != VK_NULL_HANDLE) {
+            clean_image(textures[i]);
+        }
+    }
+    textures.clean();
+
+    mesh_streamer.clean();
+    meshes.clean();
+    mesh_instances.clean();
+    instance_bounds.clean();
+    bounds_instances.clean();
+    visible_bounds.clean();
+    mesh_first_instance.clean();
+    mesh_instance_count.clean();
+    sorted_instances.clean();
+    render_queue.clean();
+    if (object_lod_buffer.size > 0u) {
+        clean_buffer(object_lod_buffer);
+    }
+    vkDestroyImageView(gpu_instance.device, draw_image.image_view, nullptr);
+    vkDestroyImageView(gpu_instance.device, depth_image.image_view, nullptr);
+    render_graph.destroy_transient_images(gpu_instance.device, vk_allocator);
+    render_graph.clean();
+    scene_transforms.clean();
+    geometry_pool.clean();
+    clean_buffer(geometry_pool.vertex_buffer);
+    clean_buffer(geometry_pool.index_buffer);
+    clean_buffer(geometry_pool.meshlet_buffer);
+    clean_buffer(geometry_pool.mesh_draw_buffer);
+    clean_buffer(geometry_pool.culled_index_buffer);
+    clean_buffer(geometry_pool.draw_commands_buffer);
+
+    vkDestroySemaphore(gpu_instance.device, upload_timeline_semaphore, nullptr);
+
     destroy_swapchain(swapchain_data);
 
     vkDestroySurfaceKHR(gpu_instance.instance, gpu_instance.surface, nullptr);
@@ -20,6 +79,4 @@ void Render::sBackend::clean() {
     vkDestroyInstance(gpu_instance.instance, nullptr);
 
     // TODO destroy window
-
-    vkDeviceWaitIdle(gpu_instance.device);
 }
\ No newline at end of file
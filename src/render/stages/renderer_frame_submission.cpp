@@ -3,6 +3,8 @@
 #include <VkBootstrap.h>
 #include <spdlog/spdlog.h>
 #include <stdint.h>
+#include <algorithm>
+#include <glm/glm.hpp>
 
 #include "../../utils.h"
 #include "../render_utils.h"
@@ -11,21 +13,50 @@
 #define VK_TIMEOUT 10000000u
 
 void resolve_staging_buffers(Render::sBackend &instance, Render::sFrame &current_frame);
+void record_staging_copies(const VkCommandBuffer cmd, sDynamicArray<Render::sStagingToResolve> &to_resolve_list, const bool emit_barriers, Render::sStagingCopyScratch &scratch, Render::sUploadStats &stats);
 
 void Render::sBackend::start_frame_capture() {
     sFrame &current_frame = get_current_frame();
     // Wait until the last frame has finished rendering, and reset the fence
-    vkWaitForFences(gpu_instance.device, 
-                    1u, 
-                    &current_frame.render_fence, 
-                    true, 
-                    VK_TIMEOUT);
+    // No timeout: its staging ranges & the per frame buffers are recycled right after
+    vk_assert_msg(  vkWaitForFences(gpu_instance.device, 
+                                    1u, 
+                                    &current_frame.render_fence, 
+                                    true, 
+                                    UINT64_MAX),
+                    "Error waiting for the frame fence");
 
     vkResetFences(  gpu_instance.device, 
                     1u, 
                     &current_frame.render_fence );
 
-    // Delete from prev frame
+    // The async uploads of this frame read from its staging ring too
+    if (current_frame.transfer_submitted_value > 0u) {
+        VkSemaphoreWaitInfo wait_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext = nullptr,
+            .flags = 0u,
+            .semaphoreCount = 1u,
+            .pSemaphores = &upload_timeline_semaphore,
+            .pValues = &current_frame.transfer_submitted_value
+        };
+        // No timeout: the staging memory is recycled right after, the transfers have to be done reading it
+        vk_assert_msg(  vkWaitSemaphores(gpu_instance.device, &wait_info, UINT64_MAX),
+                        "Error waiting for the async uploads");
+    }
+
+    // The previous submission of this frame is done, give its staging memory back
+    clean_prev_staging_buffers(current_frame);
+
+    // Textures decoded on the workers since the last frame, staged on this one
+    if (!texture_loader.is_idle()) {
+        texture_loader.poll_uploads(this, &current_frame);
+    }
+
+    // Same for the imported meshes, under the mesh streamer's budget
+    if (!mesh_streamer.is_idle()) {
+        mesh_streamer.poll_uploads(this, &current_frame);
+    }
 
     // Get the current swapchain
     VkResult swapchain_adquire_result = vkAcquireNextImageKHR(  gpu_instance.device, 
@@ -60,68 +91,54 @@ void Render::sBackend::start_frame_capture() {
 
     const uint32_t swapchain_idx = current_frame.current_swapchain_index;
 
-    // Clean the previous frame's staging buffers
-    clean_prev_staging_buffers(current_frame);
-
+    upload_stats = {};
+    submit_async_uploads(current_frame);
     resolve_staging_buffers(*this, current_frame);
 
     current_frame.descriptor_allocator.clear_descriptors();
 
-    // Set the swapchain into general mode
-    // TODO: check other iamge layouts, more effectives for rendering
-    VK_Helpers::transition_image_layout(current_frame.cmd_buffer, 
-                                        swapchain_data.images[swapchain_idx], 
-                                        VK_IMAGE_LAYOUT_UNDEFINED, 
-                                        VK_IMAGE_LAYOUT_GENERAL);
-
-    VK_Helpers::transition_image_layout(current_frame.cmd_buffer, 
-                                        draw_image.image, 
-                                        VK_IMAGE_LAYOUT_UNDEFINED, 
-                                        VK_IMAGE_LAYOUT_GENERAL);
-                                        
-    VK_Helpers::transition_image_layout(current_frame.cmd_buffer, 
-                                        depth_image.image, 
-                                        VK_IMAGE_LAYOUT_UNDEFINED, 
-                                        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+    // The frame's images are transitioned by the render graph, as the passes use them
+    // The swapchain image is only safe to use after the acquire semaphore wait
+    render_graph.begin_frame();
+    current_frame.swapchain_graph_idx = render_graph.import_image(  swapchain_data.images[swapchain_idx], 
+                                                                    VK_IMAGE_ASPECT_COLOR_BIT, 
+                                                                    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
 }
 
 
 void Render::sBackend::end_frame_capture() {
     sFrame &current_frame = get_current_frame();
 
-    VK_Helpers::transition_image_layout(current_frame.cmd_buffer,
-                                        draw_image.image, 
-                                        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 
-                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-    VK_Helpers::transition_image_layout(current_frame.cmd_buffer,
-                                        swapchain_data.images[current_frame.current_swapchain_index], 
-                                        VK_IMAGE_LAYOUT_UNDEFINED, 
-                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    VK_Helpers::copy_image_image(   current_frame.cmd_buffer, 
-                                    draw_image.image, 
-                                    { draw_image.dims.width, draw_image.dims.height, 1 }, 
-                                    swapchain_data.images[current_frame.current_swapchain_index], 
-                                    { swapchain_data.extent.width, swapchain_data.extent.height, 1 });
-
-    // Transformt the swapchain to renderable
-    VK_Helpers::transition_image_layout(current_frame.cmd_buffer,
-                                        swapchain_data.images[current_frame.current_swapchain_index], 
-                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-                                        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-    
     vk_assert_msg(  vkEndCommandBuffer(current_frame.cmd_buffer), 
                     "Error closing the command buffer");
 
     // Prepare submission
     VkCommandBufferSubmitInfo cmd_info = VK_Helpers::create_cmd_buffer_submit_info(current_frame.cmd_buffer);
-    VkSemaphoreSubmitInfo wait_info = VK_Helpers::create_submit_semphore_info(  VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, 
-                                                                                current_frame.swapchain_semaphore);
+    VkSemaphoreSubmitInfo wait_infos[2u] = {};
+    uint32_t wait_count = 1u;
+    wait_infos[0u] = VK_Helpers::create_submit_semphore_info(   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, 
+                                                                current_frame.swapchain_semaphore);
+
+    // Only wait for the async uploads that this frame reads, and are still not finished
+    if (current_frame.upload_wait_value > 0u) {
+        uint64_t completed_upload_value = 0u;
+        vkGetSemaphoreCounterValue(gpu_instance.device, upload_timeline_semaphore, &completed_upload_value);
+
+        if (completed_upload_value < current_frame.upload_wait_value) {
+            // The meshlet culling reads the geometry on compute
+            wait_infos[wait_count++] = VK_Helpers::create_submit_semphore_info( VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, 
+                                                                                upload_timeline_semaphore,
+                                                                                current_frame.upload_wait_value);
+        }
+    }
+    current_frame.upload_wait_value = 0u;
+
     VkSemaphoreSubmitInfo signal_info = VK_Helpers::create_submit_semphore_info(    VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, 
                                                                                     current_frame.render_semaphore);
     VkSubmitInfo2 submit = VK_Helpers::create_cmd_submit(   &cmd_info, 
                                                             &signal_info, 
-                                                            &wait_info  );
+                                                            wait_infos,
+                                                            wait_count  );
 
     vk_assert_msg(  vkQueueSubmit2( gpu_instance.graphic_queue.queue, 
                                     1u, 
@@ -148,62 +165,399 @@ void Render::sBackend::end_frame_capture() {
 }
 
 void Render::sBackend::clean_prev_staging_buffers(  Render::sFrame &current_frame  ) {
-    for(uint32_t i = 0u; i < current_frame.staging_to_clean_count; i++) {
-        clean_buffer(current_frame.staging_to_clean[i]);
+    current_frame.staging_ring.recycle();
+}
+
+void Render::sBackend::submit_async_uploads(  Render::sFrame &current_frame  ) {
+    if (async_staging_to_resolve.count == 0u) {
+        return;
     }
+
+    // The previous transfer submit of this frame was waited on start_frame_capture
+    vk_assert_msg(  vkResetCommandBuffer(current_frame.transfer_cmd_buffer, 0u), 
+                    "Error reseting the transfer command buffer");
+
+    VkCommandBufferBeginInfo cmd_begin = VK_Helpers::create_cmd_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    vk_assert_msg(  vkBeginCommandBuffer(current_frame.transfer_cmd_buffer, &cmd_begin), 
+                    "Error initializing the transfer command buffer");
+
+    // The resources were stamped with this value when they were staged
+    const uint64_t signal_value = ++upload_timeline_value;
+
+    record_staging_copies(current_frame.transfer_cmd_buffer, async_staging_to_resolve, false, staging_copy_scratch, upload_stats);
+
+    vk_assert_msg(  vkEndCommandBuffer(current_frame.transfer_cmd_buffer), 
+                    "Error closing the transfer command buffer");
+
+    VkCommandBufferSubmitInfo cmd_info = VK_Helpers::create_cmd_buffer_submit_info(current_frame.transfer_cmd_buffer);
+    VkSemaphoreSubmitInfo signal_info = VK_Helpers::create_submit_semphore_info(    VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, 
+                                                                                    upload_timeline_semaphore,
+                                                                                    signal_value);
+    VkSubmitInfo2 submit = VK_Helpers::create_cmd_submit(   &cmd_info, 
+                                                            &signal_info, 
+                                                            nullptr  );
+
+    vk_assert_msg(  vkQueueSubmit2( gpu_instance.transfer_queue.queue, 
+                                    1u, 
+                                    &submit, 
+                                    VK_NULL_HANDLE  ), 
+                    "Error submiting the upload command buffer" );
+
+    async_staging_to_resolve.clear();
 }
 
 void resolve_staging_buffers(   Render::sBackend &instance, 
                                 Render::sFrame &current_frame) {
-    // TODO: group calls by staging buffer
-    // TODO: use just a big staging buffer, per frame, and only delete it if there is an increase in storage size
-    for(uint32_t i = 0u; i < current_frame.staging_to_resolve_count; i++) {
-        Render::sStagingToResolve &to_resolve = current_frame.staging_to_resolve[i];
-
-        if (to_resolve.dst_is_image) {
-            // TODO: transition img from generic, to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-            VkBufferImageCopy copy_region = {
-                .bufferOffset = 0u,
-                .bufferRowLength = 0u,
-                .bufferImageHeight = 0u,
-                .imageSubresource = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, //
-                    .mipLevel = 0u,
-                    .baseArrayLayer = 0u,
-                    .layerCount = 1u
+    record_staging_copies(current_frame.cmd_buffer, current_frame.staging_to_resolve, true, instance.staging_copy_scratch, instance.upload_stats);
+
+    if (instance.upload_stats.merged_regions > 0u) {
+        spdlog::debug(  "Uploads: {} uploads, {} copy commands, {} regions, {} merged", 
+                        instance.upload_stats.uploads, 
+                        instance.upload_stats.copy_commands, 
+                        instance.upload_stats.copy_regions, 
+                        instance.upload_stats.merged_regions);
+    }
+
+    // The staging ranges are recycled when this frame's fence signals,
+    // and the transfer submits up to now are finished
+    current_frame.staging_ring.mark_submitted();
+    current_frame.transfer_submitted_value = instance.upload_timeline_value;
+    current_frame.staging_to_resolve.clear();
+}
+
+inline uint64_t get_resolve_dst_handle(const Render::sStagingToResolve &to_resolve) {
+    return (to_resolve.dst_is_image) ? (uint64_t) to_resolve.dst_image->image : (uint64_t) to_resolve.dst_buffer.raw_buffer->buffer;
+}
+
+inline bool is_same_copy_pair(const Render::sStagingToResolve &a, const Render::sStagingToResolve &b) {
+    return a.src_buffer.raw_buffer->buffer == b.src_buffer.raw_buffer->buffer && 
+            a.dst_is_image == b.dst_is_image &&
+            get_resolve_dst_handle(a) == get_resolve_dst_handle(b);
+}
+
+// Order by (src, dst) pair, and by offset inside the pair, so the contiguous ranges end up together
+bool staging_resolve_order(const Render::sStagingToResolve &a, const Render::sStagingToResolve &b) {
+    const uint64_t a_src = (uint64_t) a.src_buffer.raw_buffer->buffer;
+    const uint64_t b_src = (uint64_t) b.src_buffer.raw_buffer->buffer;
+    if (a_src != b_src) {
+        return a_src < b_src;
+    }
+
+    if (a.dst_is_image != b.dst_is_image) {
+        return b.dst_is_image;
+    }
+
+    const uint64_t a_dst = get_resolve_dst_handle(a);
+    const uint64_t b_dst = get_resolve_dst_handle(b);
+    if (a_dst != b_dst) {
+        return a_dst < b_dst;
+    }
+
+    return a.src_buffer.offset < b.src_buffer.offset;
+}
+
+inline VkImageMemoryBarrier2 image_levels_barrier(const VkImage image,
+                                                    const VkImageLayout old_layout,
+                                                    const VkImageLayout new_layout,
+                                                    const VkPipelineStageFlags2 src_stage,
+                                                    const VkAccessFlags2 src_access,
+                                                    const VkPipelineStageFlags2 dst_stage,
+                                                    const VkAccessFlags2 dst_access,
+                                                    const uint32_t base_level,
+                                                    const uint32_t level_count) {
+    return {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = src_stage,
+        .srcAccessMask = src_access,
+        .dstStageMask = dst_stage,
+        .dstAccessMask = dst_access,
+        .oldLayout = old_layout,
+        .newLayout = new_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = base_level,
+            .levelCount = level_count,
+            .baseArrayLayer = 0u,
+            .layerCount = 1u
+        }
+    };
+}
+
+inline void record_image_barriers(const VkCommandBuffer cmd, const sDynamicArray<VkImageMemoryBarrier2> &barriers) {
+    if (barriers.count == 0u) {
+        return;
+    }
+
+    VkDependencyInfo dep_info = {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext = nullptr,
+        .imageMemoryBarrierCount = barriers.count,
+        .pImageMemoryBarriers = barriers.data
+    };
+
+    vkCmdPipelineBarrier2(cmd, &dep_info);
+}
+
+// Blits each level from the previous one, a level at a time for all the images, so there is one barrier per level
+// Leaves the levels [0, mip_levels - 1) on TRANSFER_SRC, and the last one on TRANSFER_DST
+void record_mip_chain_blits(const VkCommandBuffer cmd, 
+                            const sDynamicArray<sImage*> &images, 
+                            const sDynamicArray<bool> &needs_blit,
+                            sDynamicArray<VkImageMemoryBarrier2> &barriers) {
+    uint32_t max_mip_levels = 0u;
+    for(uint32_t i = 0u; i < images.count; i++) {
+        if (needs_blit[i]) {
+            max_mip_levels = glm::max(max_mip_levels, images[i]->mip_levels);
+        }
+    }
+
+    for(uint32_t level = 1u; level < max_mip_levels; level++) {
+        barriers.clear();
+        for(uint32_t i = 0u; i < images.count; i++) {
+            if (needs_blit[i] && level < images[i]->mip_levels) {
+                barriers.push(image_levels_barrier( images[i]->image,
+                                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                    VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                                                    VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                                    VK_PIPELINE_STAGE_2_BLIT_BIT,
+                                                    VK_ACCESS_2_TRANSFER_READ_BIT,
+                                                    level - 1u, 1u));
+            }
+        }
+        record_image_barriers(cmd, barriers);
+
+        for(uint32_t i = 0u; i < images.count; i++) {
+            if (!needs_blit[i] || level >= images[i]->mip_levels) {
+                continue;
+            }
+
+            const VkExtent3D &dims = images[i]->dims;
+            const VkImageBlit blit_region = {
+                .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1u, 0u, 1u },
+                .srcOffsets = { 
+                    {0, 0, 0}, 
+                    {(int32_t) glm::max(dims.width >> (level - 1u), 1u), (int32_t) glm::max(dims.height >> (level - 1u), 1u), 1}
                 },
-                .imageExtent = to_resolve.dst_image->dims
+                .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0u, 1u },
+                .dstOffsets = { 
+                    {0, 0, 0}, 
+                    {(int32_t) glm::max(dims.width >> level, 1u), (int32_t) glm::max(dims.height >> level, 1u), 1}
+                }
             };
 
-            vkCmdCopyBufferToImage( current_frame.cmd_buffer,
-                                    to_resolve.src_buffer.raw_buffer->buffer,
-                                    to_resolve.dst_image->image,
-                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                    1u,
-                                    &copy_region);
+            vkCmdBlitImage( cmd,
+                            images[i]->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            images[i]->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            1u, &blit_region,
+                            VK_FILTER_LINEAR);
+        }
+    }
+}
 
-            // TODO: transition from VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        } else {
-            VkBufferCopy region = {
-                .srcOffset = to_resolve.src_buffer.offset,
-                .dstOffset = to_resolve.dst_buffer.offset,
-                .size = to_resolve.src_buffer.size,
-            };
+void record_staging_copies( const VkCommandBuffer cmd, 
+                            sDynamicArray<Render::sStagingToResolve> &to_resolve_list,
+                            const bool emit_barriers,
+                            Render::sStagingCopyScratch &scratch,
+                            Render::sUploadStats &stats) {
+    sDynamicArray<VkBufferCopy> &buffer_regions = scratch.buffer_regions;
+    sDynamicArray<VkBufferImageCopy> &image_regions = scratch.image_regions;
+    sDynamicArray<VkBufferMemoryBarrier2> &buffer_barriers = scratch.buffer_barriers;
+    sDynamicArray<VkImageMemoryBarrier2> &image_barriers = scratch.image_barriers;
+    sDynamicArray<sImage*> &dst_images = scratch.dst_images;
+    sDynamicArray<bool> &dst_images_need_blit = scratch.dst_images_need_blit;
+
+    buffer_barriers.clear();
+    image_barriers.clear();
+    dst_images.clear();
+    dst_images_need_blit.clear();
+
+    std::sort(  to_resolve_list.data, 
+                to_resolve_list.data + to_resolve_list.count, 
+                staging_resolve_order);
+
+    stats.uploads += to_resolve_list.count;
+
+    for(uint32_t i = 0u; i < to_resolve_list.count; i++) {
+        const Render::sStagingToResolve &to_resolve = to_resolve_list[i];
+        if (!to_resolve.dst_is_image) {
+            continue;
+        }
 
-            vkCmdCopyBuffer(current_frame.cmd_buffer, 
-                            to_resolve.src_buffer.raw_buffer->buffer, 
-                            to_resolve.dst_buffer.raw_buffer->buffer, 
-                            1u, 
-                            &region);
+        uint32_t image_idx = 0u;
+        while(image_idx < dst_images.count && dst_images[image_idx] != to_resolve.dst_image) {
+            image_idx++;
+        }
+
+        if (image_idx == dst_images.count) {
+            dst_images.push(to_resolve.dst_image);
+            dst_images_need_blit.push(to_resolve.dst_image->mip_levels > 1u);
+        }
+
+        // The mips were generated on the CPU
+        if (to_resolve.dst_mip_level > 0u) {
+            dst_images_need_blit[image_idx] = false;
         }
-       
     }
 
-    for(uint32_t i = 0u; i < current_frame.staging_buffer_count; i++) {
-        current_frame.staging_to_clean[i] = current_frame.staging_buffers[i];     
+    // Images are uploaded whole, once, so the previous contents can be discarded
+    for(uint32_t i = 0u; i < dst_images.count; i++) {
+        image_barriers.push(image_levels_barrier(   dst_images[i]->image,
+                                                    VK_IMAGE_LAYOUT_UNDEFINED,
+                                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                    VK_PIPELINE_STAGE_2_NONE,
+                                                    VK_ACCESS_2_NONE,
+                                                    VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                                                    VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                                    0u, VK_REMAINING_MIP_LEVELS));
     }
+    record_image_barriers(cmd, image_barriers);
+
+    uint32_t group_start = 0u;
+    while(group_start < to_resolve_list.count) {
+        const Render::sStagingToResolve &first_resolve = to_resolve_list[group_start];
 
-    current_frame.staging_to_clean_count = current_frame.staging_buffer_count;
-    current_frame.staging_buffer_count = 0u;
-    current_frame.staging_to_resolve_count = 0u;
+        uint32_t group_end = group_start + 1u;
+        while(group_end < to_resolve_list.count && is_same_copy_pair(first_resolve, to_resolve_list[group_end])) {
+            group_end++;
+        }
+
+        if (first_resolve.dst_is_image) {
+            image_regions.clear();
+
+            for(uint32_t i = group_start; i < group_end; i++) {
+                const Render::sStagingToResolve &to_resolve = to_resolve_list[i];
+
+                image_regions.push({
+                    .bufferOffset = to_resolve.src_buffer.offset,
+                    .bufferRowLength = 0u,
+                    .bufferImageHeight = 0u,
+                    .imageSubresource = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, //
+                        .mipLevel = to_resolve.dst_mip_level,
+                        .baseArrayLayer = 0u,
+                        .layerCount = 1u
+                    },
+                    .imageOffset = {
+                        (int32_t) to_resolve.dst_copy_pos.width,
+                        (int32_t) to_resolve.dst_copy_pos.height,
+                        (int32_t) to_resolve.dst_copy_pos.depth
+                    },
+                    .imageExtent = to_resolve.img_size
+                });
+            }
+
+            vkCmdCopyBufferToImage( cmd,
+                                    first_resolve.src_buffer.raw_buffer->buffer,
+                                    first_resolve.dst_image->image,
+                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                    image_regions.count,
+                                    image_regions.data);
+
+            stats.copy_regions += image_regions.count;
+        } else {
+            buffer_regions.clear();
+
+            VkDeviceSize dst_range_start = first_resolve.dst_buffer.offset;
+            VkDeviceSize dst_range_end = first_resolve.dst_buffer.offset;
+
+            for(uint32_t i = group_start; i < group_end; i++) {
+                const Render::sStagingToResolve &to_resolve = to_resolve_list[i];
+
+                VkBufferCopy *last_region = (buffer_regions.count > 0u) ? &buffer_regions[buffer_regions.count - 1u] : nullptr;
+
+                // Contiguous on the staging buffer & on the destination: extend the last region
+                if (last_region && 
+                    last_region->srcOffset + last_region->size == to_resolve.src_buffer.offset &&
+                    last_region->dstOffset + last_region->size == to_resolve.dst_buffer.offset) {
+                    last_region->size += to_resolve.src_buffer.size;
+                    stats.merged_regions++;
+                } else {
+                    buffer_regions.push({
+                        .srcOffset = to_resolve.src_buffer.offset,
+                        .dstOffset = to_resolve.dst_buffer.offset,
+                        .size = to_resolve.src_buffer.size,
+                    });
+                }
+
+                dst_range_start = glm::min<VkDeviceSize>(dst_range_start, to_resolve.dst_buffer.offset);
+                dst_range_end = glm::max<VkDeviceSize>(dst_range_end, to_resolve.dst_buffer.offset + to_resolve.src_buffer.size);
+            }
+
+            vkCmdCopyBuffer(cmd, 
+                            first_resolve.src_buffer.raw_buffer->buffer, 
+                            first_resolve.dst_buffer.raw_buffer->buffer, 
+                            buffer_regions.count, 
+                            buffer_regions.data);
+
+            stats.copy_regions += buffer_regions.count;
+
+            // One barrier for the whole written range of the destination
+            buffer_barriers.push({
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                .pNext = nullptr,
+                .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | 
+                                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                .dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = first_resolve.dst_buffer.raw_buffer->buffer,
+                .offset = dst_range_start,
+                .size = dst_range_end - dst_range_start
+            });
+        }
+
+        stats.copy_commands++;
+        group_start = group_end;
+    }
+
+    record_mip_chain_blits(cmd, dst_images, dst_images_need_blit, image_barriers);
+
+    // All the images ready for sampling on a single barrier
+    image_barriers.clear();
+    for(uint32_t i = 0u; i < dst_images.count; i++) {
+        const uint32_t mip_levels = dst_images[i]->mip_levels;
+        const VkPipelineStageFlags2 sampling_stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+        if (dst_images_need_blit[i]) {
+            image_barriers.push(image_levels_barrier(   dst_images[i]->image,
+                                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                        VK_PIPELINE_STAGE_2_BLIT_BIT,
+                                                        VK_ACCESS_2_TRANSFER_READ_BIT,
+                                                        sampling_stages,
+                                                        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                                                        0u, mip_levels - 1u));
+        }
+
+        // Only the last level is still on TRANSFER_DST after the blits
+        const uint32_t dst_base_level = (dst_images_need_blit[i]) ? mip_levels - 1u : 0u;
+        image_barriers.push(image_levels_barrier(   dst_images[i]->image,
+                                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                    VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                                                    VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                                    sampling_stages,
+                                                    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                                                    dst_base_level, VK_REMAINING_MIP_LEVELS));
+    }
+    record_image_barriers(cmd, image_barriers);
+
+    // All the destinations on a single barrier, the transfer queue is synced with the timeline semaphore instead
+    if (emit_barriers && buffer_barriers.count > 0u) {
+        VkDependencyInfo dep_info = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .bufferMemoryBarrierCount = buffer_barriers.count,
+            .pBufferMemoryBarriers = buffer_barriers.data
+        };
+
+        vkCmdPipelineBarrier2(cmd, &dep_info);
+    }
 }
\ No newline at end of file
@@ -7,11 +7,14 @@
 #include <VkBootstrap.h>
 
 #include "../../parsers/mesh_parser.h"
+#include "../../parsers/gltf_file.h"
 #include "../../common.h"
 #include "../vk_helpers.h"
 #include "../resources/descriptor_set.h"
 #include "../resources/pipeline.h"
 #include "../resources/gpu_buffers.h"
+#include "../../geometry/meshlet_builder.h"
+#include "../../utils/job_system.h"
 
 bool initialize_window(Render::sBackend::sDeviceInstance &instance);
 bool initialize_vulkan(Render::sBackend::sDeviceInstance &instance);
@@ -20,10 +23,12 @@ bool initialize_command_buffers(Render::sBackend &instance);
 bool initialize_sync_structs(Render::sBackend &instance);
 bool initialize_memory_alloc(Render::sBackend &instance);
 bool initialize_descriptors(Render::sBackend &instance);
+bool initialize_geometry_pool(Render::sBackend &instance);
 bool initialize_mesh_pipelines(Render::sBackend &instance);
 bool initialize_compute_pipelines(Render::sBackend &instance);
 bool initialize_graphics_pipelines(Render::sBackend &instance);
 bool initialize_img_uploads(Render::sBackend &instance);
+void benchmark_draw_recording(Render::sBackend &renderer, const uint32_t draw_count);
 
 bool Render::sBackend::init() {
     bool is_initialized = true;
@@ -35,11 +40,17 @@ bool Render::sBackend::init() {
     is_initialized &= initialize_sync_structs(*this);
     is_initialized &= initialize_swapchain(*this);
     is_initialized &= initialize_descriptors(*this);
+    is_initialized &= initialize_geometry_pool(*this);
     is_initialized &= initialize_mesh_pipelines(*this);
     is_initialized &= initialize_img_uploads(*this);
     is_initialized &= initialize_compute_pipelines(*this);
     is_initialized &= initialize_graphics_pipelines(*this);
 
+    // Needs the mesh pipeline & the draw command pools
+    if (DRAW_RECORDING_BENCHMARK && is_initialized) {
+        benchmark_draw_recording(*this, DRAW_RECORDING_BENCHMARK_COUNT);
+    }
+
     return is_initialized;
 }
 
@@ -95,20 +106,36 @@ bool initialize_vulkan(Render::sBackend::sDeviceInstance &instance) {
             .dynamicRendering = true
         };
 
+        // 1.1 features, the meshlet culling copies 16 bit indices
+        VkPhysicalDeviceVulkan11Features features_11 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
+            .pNext = nullptr,
+            .storageBuffer16BitAccess = true
+        };
+
         // 1.2 features
         VkPhysicalDeviceVulkan12Features features_12 = {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
             .pNext = nullptr,
+            .drawIndirectCount = true,
             .descriptorIndexing = true,
+            .timelineSemaphore = true,
             .bufferDeviceAddress = true
         };
 
+        // The object culling writes the object index as the first instance of its draw
+        VkPhysicalDeviceFeatures features = {
+            .drawIndirectFirstInstance = true
+        };
+
         vkb::PhysicalDeviceSelector selector { vkb_instance };
 
         vkb::Result<vkb::PhysicalDevice> result = selector
                     .set_minimum_version(1u, 3u)
                     .set_required_features_13(features_13)
                     .set_required_features_12(features_12)
+                    .set_required_features_11(features_11)
+                    .set_required_features(features)
                     .set_surface(instance.surface)
                     .select();
 
@@ -119,6 +146,12 @@ bool initialize_vulkan(Render::sBackend::sDeviceInstance &instance) {
 
         vkb::PhysicalDevice physical_device = result.value();
 
+        // Optional, the compressed textures are transcoded to uncompressed formats without it
+        VkPhysicalDeviceFeatures optional_features = {
+            .textureCompressionBC = true
+        };
+        instance.supports_bc_compression = physical_device.enable_features_if_present(optional_features);
+
         vkb::DeviceBuilder device_builder { physical_device };
 
         vkb::Result<vkb::Device> result_device = device_builder.build();
@@ -138,6 +171,18 @@ bool initialize_vulkan(Render::sBackend::sDeviceInstance &instance) {
     {
         instance.graphic_queue.queue = vkb_device.get_queue(vkb::QueueType::graphics).value();
         instance.graphic_queue.family = vkb_device.get_queue_index(vkb::QueueType::graphics).value();
+
+        // Transfer-only family for async uploads, if there is none, uploads go on the graphics queue
+        vkb::Result<uint32_t> transfer_family = vkb_device.get_dedicated_queue_index(vkb::QueueType::transfer);
+        if (transfer_family) {
+            instance.transfer_queue.queue = vkb_device.get_dedicated_queue(vkb::QueueType::transfer).value();
+            instance.transfer_queue.family = transfer_family.value();
+            instance.has_transfer_queue = true;
+        } else {
+            spdlog::info("No dedicated transfer queue, uploading on the graphics queue");
+            instance.transfer_queue = instance.graphic_queue;
+            instance.has_transfer_queue = false;
+        }
     }
     
     return true;
@@ -164,19 +209,47 @@ bool initialize_swapchain(Render::sBackend &instance) {
         1u
     };
 
-    instance.draw_image = instance.create_image(    IMG_FORMAT_RGBA_16BIT_SFLOAT,
-                                                    image_usages, 
-                                                    VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), 
-                                                    draw_image_extent   );
-    
-    // Depth buffer
-    //VkImageUsageFlags depth_uses = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-
-    instance.depth_image = instance.create_image(   IMG_FORMAT_D_32BIT_SFLOAT, 
-                                                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 
-                                                    VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), 
-                                                    draw_image_extent, 
-                                                    VK_IMAGE_ASPECT_DEPTH_BIT   );
+    // Only used inside the frame: transient images of the render graph, aliased with the targets of other passes
+    Render::sRenderGraph &graph = instance.render_graph;
+    instance.draw_image = { .dims = draw_image_extent, .format = IMG_FORMAT_RGBA_16BIT_SFLOAT, .mip_levels = 1u };
+    instance.draw_image_graph_idx = graph.add_transient_image(  VK_Helpers::image2D_create_info((VkFormat) instance.draw_image.format, image_usages, draw_image_extent), 
+                                                                VK_IMAGE_ASPECT_COLOR_BIT);
+
+    instance.depth_image = { .dims = draw_image_extent, .format = IMG_FORMAT_D_32BIT_SFLOAT, .mip_levels = 1u };
+    instance.depth_image_graph_idx = graph.add_transient_image( VK_Helpers::image2D_create_info((VkFormat) instance.depth_image.format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, draw_image_extent), 
+                                                                VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    // The lifetimes come from the passes of a frame, declared (not executed) without a swapchain image
+    graph.begin_frame();
+    instance.get_current_frame().swapchain_graph_idx = graph.import_image(VK_NULL_HANDLE, VK_IMAGE_ASPECT_COLOR_BIT, VK_PIPELINE_STAGE_2_NONE);
+    instance.add_frame_passes();
+    if (!graph.allocate_transient_images(instance.gpu_instance.device, instance.vk_allocator)) {
+        spdlog::error("Error allocating the transient images");
+        return false;
+    }
+    graph.begin_frame();
+
+    spdlog::info("Transient images: {} KB on {} allocations, {} KB without aliasing", 
+                    graph.transient_allocated_size / 1024u, 
+                    graph.memory_blocks.count, 
+                    graph.transient_requested_size / 1024u);
+
+    sImage *targets[2u] = { &instance.draw_image, &instance.depth_image };
+    const uint32_t target_graph_idx[2u] = { instance.draw_image_graph_idx, instance.depth_image_graph_idx };
+    for(uint32_t i = 0u; i < 2u; i++) {
+        targets[i]->image = graph.images[target_graph_idx[i]].image;
+        VkImageViewCreateInfo view_create_info = VK_Helpers::image_view2D_create_info(  (VkFormat) targets[i]->format, 
+                                                                                        targets[i]->image, 
+                                                                                        graph.images[target_graph_idx[i]].aspect);
+        VkResult view_res = vkCreateImageView(  instance.gpu_instance.device, 
+                                                &view_create_info, 
+                                                nullptr, 
+                                                &targets[i]->image_view);
+        if (view_res != VK_SUCCESS) {
+            spdlog::error("Error creating the render target views");
+            return false;
+        }
+    }
 
     return true;
 }
@@ -211,6 +284,72 @@ bool initialize_command_buffers(Render::sBackend &instance) {
         }
     }
 
+    // Secondary command buffers for the draws, a pool per recording thread of each frame in flight
+    const uint32_t thread_count = sJobSystem::get().worker_count + 1u;
+    instance.recording_thread_count = (thread_count < RENDER_MAX_RECORDING_THREADS) ? thread_count : RENDER_MAX_RECORDING_THREADS;
+
+    VkCommandPoolCreateInfo draw_pool_create_info = VK_Helpers::create_cmd_pool_info(   instance.gpu_instance.graphic_queue.family, 
+                                                                                        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+    for(uint32_t i = 0u; i < FRAME_BUFFER_COUNT; i++) {
+        for(uint32_t j = 0u; j < instance.recording_thread_count; j++) {
+            VkResult create_pool_res = vkCreateCommandPool(
+                                            instance.gpu_instance.device, 
+                                            &draw_pool_create_info, 
+                                            nullptr, 
+                                            &instance.in_flight_frames[i].draw_cmd_pools[j]);
+            if (create_pool_res != VK_SUCCESS) {
+                spdlog::error("Error creating draw command pool");
+                return false;
+            }
+
+            VkCommandBufferAllocateInfo cmd_alloc_info = VK_Helpers::create_cmd_buffer_alloc_info(instance.in_flight_frames[i].draw_cmd_pools[j], 1u);
+            cmd_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+            VkResult allocate_cmd_res = vkAllocateCommandBuffers(
+                                            instance.gpu_instance.device, 
+                                            &cmd_alloc_info, 
+                                            &instance.in_flight_frames[i].draw_cmd_buffers[j]);
+
+            if (allocate_cmd_res != VK_SUCCESS) {
+                spdlog::error("Error allocating draw command buffer");
+                return false;
+            }
+        }
+    }
+
+    if (!instance.gpu_instance.has_transfer_queue) {
+        return true;
+    }
+
+    // Command buffer & pool for the async uploads of each frame in flight
+    VkCommandPoolCreateInfo transfer_pool_create_info = VK_Helpers::create_cmd_pool_info(   instance.gpu_instance.transfer_queue.family, 
+                                                                                            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+
+    for(uint32_t i = 0u; i < FRAME_BUFFER_COUNT; i++) {
+        VkResult create_pool_res = vkCreateCommandPool(
+                                        instance.gpu_instance.device, 
+                                        &transfer_pool_create_info, 
+                                        nullptr, 
+                                        &instance.in_flight_frames[i].transfer_cmd_pool);
+        if (create_pool_res != VK_SUCCESS) {
+            spdlog::error("Error creating transfer command pool");
+            return false;
+        }
+        
+        VkCommandBufferAllocateInfo cmd_alloc_info = VK_Helpers::create_cmd_buffer_alloc_info(instance.in_flight_frames[i].transfer_cmd_pool, 1u);
+
+        VkResult allocate_cmd_res = vkAllocateCommandBuffers(
+                                        instance.gpu_instance.device, 
+                                        &cmd_alloc_info, 
+                                        &instance.in_flight_frames[i].transfer_cmd_buffer);
+
+        if (allocate_cmd_res != VK_SUCCESS) {
+            spdlog::error("Error allocating transfer command buffer");
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -246,6 +385,26 @@ bool initialize_sync_structs(Render::sBackend &instance) {
             return false;
         }
     }
+
+    // Timeline semaphore for the uploads on the transfer queue
+    VkSemaphoreTypeCreateInfo timeline_type_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0u
+    };
+    sempahore_create_info.pNext = &timeline_type_info;
+
+    VkResult sem_timeline = vkCreateSemaphore(  instance.gpu_instance.device, 
+                                                &sempahore_create_info, 
+                                                nullptr, 
+                                                &instance.upload_timeline_semaphore);
+    if (sem_timeline != VK_SUCCESS) {
+        spdlog::error("Error creating upload timeline semaphore");
+        return false;
+    }
+    instance.upload_timeline_value = 0u;
+
     return true;
 }
 
@@ -260,6 +419,15 @@ bool initialize_memory_alloc(Render::sBackend &instance) {
     vmaCreateAllocator( &alloc_create_info, 
                         &instance.vk_allocator);
 
+    // Persistently mapped staging memory for each frame
+    // Shared with the transfer queue, that reads it for the async uploads
+    const uint32_t transfer_family = (instance.gpu_instance.has_transfer_queue) ? instance.gpu_instance.transfer_queue.family : UINT32_MAX;
+    for(uint32_t i = 0u; i < FRAME_BUFFER_COUNT; i++) {
+        instance.in_flight_frames[i].staging_ring.init( instance.vk_allocator, 
+                                                        instance.gpu_instance.graphic_queue.family, 
+                                                        transfer_family);
+    }
+
     // TODO: push destroy?
 
     return true;
@@ -312,7 +480,7 @@ bool initialize_descriptors(Render::sBackend &instance) {
 
     // Global scene data ds layout
     instance.gpu_comon_scene_data_descriptor_set_layout = 
-        sDescriptorLayoutBuilder::create(instance.gpu_instance.device, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+        sDescriptorLayoutBuilder::create(instance.gpu_instance.device, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT)
             .add_biding(0u, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
             .build();
 
@@ -359,6 +527,70 @@ bool initialize_descriptors(Render::sBackend &instance) {
     return true;
 }
 
+// Compute pipeline with the scene data set & a push constant range
+static bool create_scene_compute_pipeline(  Render::sBackend &instance, 
+                                            const char* shader_dir, 
+                                            const uint32_t push_constant_size, 
+                                            VkPipelineLayout *pipeline_layout, 
+                                            VkPipeline *pipeline) {
+    VkPushConstantRange push_constant = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0u,
+        .size = push_constant_size
+    };
+
+    VkPipelineLayoutCreateInfo pipe_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .setLayoutCount = 1u,
+        .pSetLayouts = &instance.gpu_comon_scene_data_descriptor_set_layout,
+        .pushConstantRangeCount = 1u,
+        .pPushConstantRanges = &push_constant
+    };
+
+    if (vkCreatePipelineLayout( instance.gpu_instance.device, 
+                                &pipe_layout_create_info,
+                                nullptr,
+                                pipeline_layout) != VK_SUCCESS) {
+        spdlog::error("Error creating the pipeline layout of {}", shader_dir);
+        return false;
+    }
+
+    VkShaderModule shader_module;
+    if (!VK_Helpers::load_shader_module(shader_dir, 
+                                        instance.gpu_instance.device, 
+                                        &shader_module)) {
+        spdlog::error("Error building the shader module {}", shader_dir);
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipe_create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = nullptr,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shader_module,
+            .pName = "main"
+        },
+        .layout = *pipeline_layout
+    };
+
+    const VkResult result = vkCreateComputePipelines(   instance.gpu_instance.device,
+                                                        VK_NULL_HANDLE,
+                                                        1u,
+                                                        &pipe_create_info,
+                                                        nullptr,
+                                                        pipeline);
+
+    vkDestroyShaderModule(  instance.gpu_instance.device, 
+                            shader_module, 
+                            nullptr);
+
+    return result == VK_SUCCESS;
+}
+
 bool initialize_compute_pipelines(Render::sBackend &instance) {
     VkPushConstantRange push_constant = {
         .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
@@ -424,6 +656,25 @@ bool initialize_compute_pipelines(Render::sBackend &instance) {
 
     // TODO: delete add  to future delete queue pipeline and pipline layout
 
+    // Culling passes, reading the scene data
+    if (!create_scene_compute_pipeline( instance, 
+                                        "../shaders/meshlet_cull.comp.spv", 
+                                        sizeof(Render::sMeshletCullPushConstant), 
+                                        &instance.meshlet_cull_compute_pipeline_layout, 
+                                        &instance.meshlet_cull_compute_pipeline)) {
+        spdlog::error("Error creating the meshlet cull pipeline");
+        return false;
+    }
+
+    if (!create_scene_compute_pipeline( instance, 
+                                        "../shaders/object_cull.comp.spv", 
+                                        sizeof(Render::sObjectCullPushConstant), 
+                                        &instance.object_cull_compute_pipeline_layout, 
+                                        &instance.object_cull_compute_pipeline)) {
+        spdlog::error("Error creating the object cull pipeline");
+        return false;
+    }
+
     return true;
 }
 
@@ -432,7 +683,9 @@ bool initialize_graphics_pipelines(Render::sBackend &instance) {
 
     VkShaderModule triangle_frag_shader, triangle_vertex_shader;
     {
-        if (!VK_Helpers::load_shader_module(    "../shaders/mesh.vert.spv", 
+        // The vertex pulling depends on the pool's vertex layout
+        const char* vertex_shader_dir = (instance.geometry_pool.use_compact_vertices) ? "../shaders/mesh_compact.vert.spv" : "../shaders/mesh.vert.spv";
+        if (!VK_Helpers::load_shader_module(    vertex_shader_dir, 
                                                 device, 
                                                 &triangle_vertex_shader)) {
             spdlog::error("Error when building the mesh verte shaders");
@@ -545,8 +798,83 @@ bool initialize_img_uploads(Render::sBackend &instance) {
     return true;
 }
 
+bool initialize_geometry_pool(Render::sBackend &instance) {
+    Render::sGeometryPool &pool = instance.geometry_pool;
+
+    pool.init(  GEOMETRY_POOL_VERTEX_CAPACITY, 
+                GEOMETRY_POOL_INDEX_CAPACITY,
+                GEOMETRY_POOL_MESHLET_CAPACITY,
+                GEOMETRY_POOL_COMPACT_VERTICES);
+
+    pool.vertex_buffer = instance.create_buffer(    GEOMETRY_POOL_VERTEX_CAPACITY * pool.vertex_size, 
+                                                    GEOMETRY_POOL_VERTEX_USAGE,
+                                                    VMA_MEMORY_USAGE_GPU_ONLY);
+
+    // Read by the meshlet culling too
+    pool.index_buffer = instance.create_buffer( GEOMETRY_POOL_INDEX_CAPACITY * sizeof(uint32_t), 
+                                                GEOMETRY_POOL_INDEX_USAGE,
+                                                VMA_MEMORY_USAGE_GPU_ONLY);
+
+    pool.meshlet_buffer = instance.create_buffer(   GEOMETRY_POOL_MESHLET_CAPACITY * sizeof(Geometry::sMeshlet), 
+                                                    GEOMETRY_POOL_MESHLET_USAGE,
+                                                    VMA_MEMORY_USAGE_GPU_ONLY);
+
+    // Only new entries are written, after the frames that could read them
+    pool.draw_capacity = GEOMETRY_POOL_INITIAL_DRAW_CAPACITY;
+    pool.mesh_draw_buffer = instance.create_buffer( GEOMETRY_POOL_INITIAL_DRAW_CAPACITY * sizeof(Render::sGPUMeshDraw), 
+                                                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                                    VMA_MEMORY_USAGE_CPU_TO_GPU,
+                                                    true);
+
+    // Written on the GPU each frame by the meshlet culling
+    pool.culled_index_buffer = instance.create_buffer(  GEOMETRY_POOL_INDEX_CAPACITY * sizeof(uint32_t), 
+                                                        GEOMETRY_POOL_CULLED_INDEX_USAGE,
+                                                        VMA_MEMORY_USAGE_GPU_ONLY);
+
+    pool.draw_commands_buffer = instance.create_buffer( GEOMETRY_POOL_INITIAL_DRAW_CAPACITY * sizeof(VkDrawIndexedIndirectCommand), 
+                                                        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                                        VMA_MEMORY_USAGE_GPU_ONLY);
+
+    VkBufferDeviceAddressInfo device_adress_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .pNext = nullptr,
+        .buffer = pool.vertex_buffer.buffer
+    };
+    pool.vertex_buffer_address = vkGetBufferDeviceAddress(instance.gpu_instance.device, &device_adress_info);
+
+    device_adress_info.buffer = pool.index_buffer.buffer;
+    pool.index_buffer_address = vkGetBufferDeviceAddress(instance.gpu_instance.device, &device_adress_info);
+
+    device_adress_info.buffer = pool.meshlet_buffer.buffer;
+    pool.meshlet_buffer_address = vkGetBufferDeviceAddress(instance.gpu_instance.device, &device_adress_info);
+
+    device_adress_info.buffer = pool.mesh_draw_buffer.buffer;
+    pool.mesh_draw_buffer_address = vkGetBufferDeviceAddress(instance.gpu_instance.device, &device_adress_info);
+
+    device_adress_info.buffer = pool.culled_index_buffer.buffer;
+    pool.culled_index_buffer_address = vkGetBufferDeviceAddress(instance.gpu_instance.device, &device_adress_info);
+
+    device_adress_info.buffer = pool.draw_commands_buffer.buffer;
+    pool.draw_commands_buffer_address = vkGetBufferDeviceAddress(instance.gpu_instance.device, &device_adress_info);
+
+    return true;
+}
+
 bool initialize_mesh_pipelines(Render::sBackend &instance) {
-    instance.mesh_count = Parsers::gltf_to_mesh("../resources/test_meshes.glb", "../resources/", instance.meshes, &instance, &instance.get_current_frame());
+    // Parsed once for both imports
+    Parsers::sGltfFile *scene_file = Parsers::open_gltf_file("../resources/test_meshes.glb", "../resources/");
+    if (scene_file != nullptr) {
+        // Queued first, so the workers decode the textures while the meshes are imported
+        instance.texture_loader.select_transcode_formats(instance);
+        Parsers::gltf_to_textures(*scene_file, &instance.texture_loader, &instance.textures);
+        // Imported on a worker & uploaded over the next frames, the first frame does not wait for it
+        instance.mesh_streamer.load_gltf(scene_file);
+        Parsers::release_gltf_file(scene_file);
+    }
+
+    if (FRUSTUM_CULLING_BENCHMARK) {
+        Render::benchmark_frustum_culling(FRUSTUM_CULLING_BENCHMARK_COUNT);
+    }
 
     // TODO: deletion of the mesh
     return true;
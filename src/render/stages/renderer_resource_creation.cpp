@@ -1,11 +1,16 @@
 #include "../renderer.h"
 
+#include <cstring>
 #include <vk_mem_alloc.h>
+#include <spdlog/spdlog.h>
 #include <glm/gtc/integer.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include "../../utils.h"
 #include "../vk_helpers.h"
 #include "../render_utils.h"
+#include "../pixel_conversion.h"
+#include "../../geometry/meshlet_builder.h"
 
 // TODO: Delete
 sImage Render::sBackend::create_image(  const eImageFormats img_format, 
@@ -13,7 +18,8 @@ sImage Render::sBackend::create_image(  const eImageFormats img_format,
                                         const VkMemoryPropertyFlags mem_flags,
                                         const VkExtent3D& img_dims, 
                                         const VkImageAspectFlagBits view_flags,
-                                        const bool mipmapped) {
+                                        const bool mipmapped,
+                                        const uint32_t mip_levels) {
     sImage result = {
         .dims = img_dims,
         .format = img_format,
@@ -24,7 +30,11 @@ sImage Render::sBackend::create_image(  const eImageFormats img_format,
                                                                         img_dims);
     if (mipmapped) {
         img_create_info.mipLevels = glm::floor(glm::log2(glm::max(img_dims.width, img_dims.height))) + 1u;
+        if (mip_levels > 0u) {
+            img_create_info.mipLevels = glm::min(img_create_info.mipLevels, mip_levels);
+        }
     }
+    result.mip_levels = img_create_info.mipLevels;
     
     VmaAllocationCreateInfo img_alloc_info = {
         .usage = VMA_MEMORY_USAGE_GPU_ONLY,
@@ -41,7 +51,8 @@ sImage Render::sBackend::create_image(  const eImageFormats img_format,
     
     VkImageViewCreateInfo img_view_create_info = VK_Helpers::image_view2D_create_info(  (VkFormat) img_format, 
                                                                                         result.image, 
-                                                                                        view_flags );
+                                                                                        view_flags,
+                                                                                        result.mip_levels );
 
     vk_assert_msg(  vkCreateImageView(  gpu_instance.device, 
                                         &img_view_create_info, 
@@ -52,6 +63,129 @@ sImage Render::sBackend::create_image(  const eImageFormats img_format,
     return result;
 }
 
+// Size of a channel, for the CPU mip generation
+static inline uint32_t get_channel_size(const eImageFormats format) {
+    switch (format) {
+        case IMG_FORMAT_R_16BIT_SFLOAT:
+        case IMG_FORMAT_RGBA_16BIT_SFLOAT:
+            return sizeof(uint16_t);
+        case IMG_FORMAT_R_32BIT_SFLOAT:
+        case IMG_FORMAT_RGBA_32BIT_SFLOAT:
+        case IMG_FORMAT_D_32BIT_SFLOAT:
+            return sizeof(float);
+        default:
+            return sizeof(uint8_t);
+    }
+}
+
+// 2x2 box filter, the last row & column are repeated on odd sizes
+// The color of the sRGB formats is averaged on linear space, the alpha is already linear
+static void downsample_mip_level(   const uint8_t *src, 
+                                    const uint32_t src_width, 
+                                    const uint32_t src_height, 
+                                    const eImageFormats format, 
+                                    uint8_t *dst) {
+    const uint32_t channel_size = get_channel_size(format);
+    const uint32_t channel_count = (uint32_t) get_pixel_size(format) / channel_size;
+    const uint32_t dst_width = glm::max(src_width / 2u, 1u);
+    const uint32_t dst_height = glm::max(src_height / 2u, 1u);
+    const bool is_srgb = format == IMG_FORMAT_RGBA_8BIT_SRGB || format == IMG_FORMAT_BRGA_8BIT_SRGB;
+
+    for(uint32_t y = 0u; y < dst_height; y++) {
+        const uint32_t y0 = glm::min(y * 2u, src_height - 1u), y1 = glm::min(y * 2u + 1u, src_height - 1u);
+
+        for(uint32_t x = 0u; x < dst_width; x++) {
+            const uint32_t x0 = glm::min(x * 2u, src_width - 1u), x1 = glm::min(x * 2u + 1u, src_width - 1u);
+            const uint64_t src_texels[4u] = {
+                (uint64_t) y0 * src_width + x0, (uint64_t) y0 * src_width + x1,
+                (uint64_t) y1 * src_width + x0, (uint64_t) y1 * src_width + x1
+            };
+            const uint64_t dst_texel = (uint64_t) y * dst_width + x;
+
+            for(uint32_t c = 0u; c < channel_count; c++) {
+                if (is_srgb && c < 3u) {
+                    float sum = 0.0f;
+                    for(uint32_t k = 0u; k < 4u; k++) {
+                        sum += Render::srgb_to_linear(src[src_texels[k] * channel_count + c]);
+                    }
+                    dst[dst_texel * channel_count + c] = Render::linear_to_srgb(sum * 0.25f);
+                } else if (channel_size == sizeof(uint8_t)) {
+                    uint32_t sum = 2u;
+                    for(uint32_t k = 0u; k < 4u; k++) {
+                        sum += src[src_texels[k] * channel_count + c];
+                    }
+                    dst[dst_texel * channel_count + c] = (uint8_t) (sum / 4u);
+                } else if (channel_size == sizeof(uint16_t)) {
+                    const uint16_t *src_values = (const uint16_t*) src;
+                    float sum = 0.0f;
+                    for(uint32_t k = 0u; k < 4u; k++) {
+                        sum += glm::unpackHalf1x16(src_values[src_texels[k] * channel_count + c]);
+                    }
+                    ((uint16_t*) dst)[dst_texel * channel_count + c] = glm::packHalf1x16(sum * 0.25f);
+                } else {
+                    const float *src_values = (const float*) src;
+                    float sum = 0.0f;
+                    for(uint32_t k = 0u; k < 4u; k++) {
+                        sum += src_values[src_texels[k] * channel_count + c];
+                    }
+                    ((float*) dst)[dst_texel * channel_count + c] = sum * 0.25f;
+                }
+            }
+        }
+    }
+}
+
+void    Render::sBackend::create_image( sImage *to_create,
+                                        const void *level_data,
+                                        const uint32_t level_count,
+                                        const eImageFormats img_format, 
+                                        const VkImageUsageFlags usage, 
+                                        const VkMemoryPropertyFlags mem_flags, 
+                                        const VkExtent3D& img_dims,
+                                        Render::sFrame &frame_to_upload) {
+    *to_create = create_image(  img_format, 
+                                usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT, 
+                                mem_flags, 
+                                img_dims, 
+                                VK_IMAGE_ASPECT_COLOR_BIT,
+                                level_count > 1u,
+                                level_count );
+
+    const uint8_t *level_pixels = (const uint8_t*) level_data;
+    for(uint32_t level = 0u; level < to_create->mip_levels; level++) {
+        const VkExtent3D level_dims = { glm::max(img_dims.width >> level, 1u), glm::max(img_dims.height >> level, 1u), 1u };
+
+        upload_to_gpu(  level_pixels, 
+                        img_format,
+                        level_dims,
+                        to_create,
+                        {0u, 0u, 0u},
+                        &frame_to_upload,
+                        level );
+        level_pixels += get_image_data_size(img_format, level_dims);
+    }
+}
+
+bool Render::sBackend::supports_sampled_format(const eImageFormats format) const {
+    if (is_block_compressed(format) && !gpu_instance.supports_bc_compression) {
+        return false;
+    }
+
+    VkFormatProperties format_properties = {};
+    vkGetPhysicalDeviceFormatProperties(gpu_instance.gpu, (VkFormat) format, &format_properties);
+
+    const VkFormatFeatureFlags sampled_features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    return (format_properties.optimalTilingFeatures & sampled_features) == sampled_features;
+}
+
+bool Render::sBackend::supports_linear_blit(const eImageFormats format) const {
+    VkFormatProperties format_properties = {};
+    vkGetPhysicalDeviceFormatProperties(gpu_instance.gpu, (VkFormat) format, &format_properties);
+
+    const VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (format_properties.optimalTilingFeatures & blit_features) == blit_features;
+}
+
 void    Render::sBackend::create_image( sImage *to_create,
                                         void *raw_img_data,
                                         const eImageFormats img_format, 
@@ -60,21 +194,70 @@ void    Render::sBackend::create_image( sImage *to_create,
                                         const VkExtent3D& img_dims,
                                         Render::sFrame &frame_to_upload, 
                                         const bool mipmapped,
-                                        const VkImageAspectFlagBits view_flags) {
+                                        const VkImageAspectFlagBits view_flags,
+                                        const eImageFormats src_format,
+                                        const uint32_t conversion_flags) {
+    // The blocks cannot be filtered, their levels come with the data
+    assert(!(mipmapped && is_block_compressed(img_format)) && "Block compressed images need their mip levels");
 
+    // Mips are blitted from the level 0 on the resolve, if the format cannot be filtered they are generated here
+    const bool generate_mips_on_cpu = mipmapped && !supports_linear_blit(img_format);
+
+    // The pixels are copied from the staging ring, & read back for the blits
     *to_create = create_image(    img_format, 
-                                        usage, 
+                                        usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT | ((mipmapped) ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0u), 
                                         mem_flags, 
                                         img_dims, 
                                         view_flags,
                                         mipmapped   );
 
-    upload_to_gpu(  raw_img_data, 
-                    img_format,
-                    img_dims,
-                    to_create,
-                    {0u, 0u, 0u},
-                    &frame_to_upload );
+    // Converted while it is copied to the staging memory
+    const eImageFormats data_format = (src_format == IMG_FORMAT_UNDEF) ? img_format : src_format;
+    upload_converted_to_gpu(raw_img_data, 
+                            data_format,
+                            conversion_flags,
+                            img_dims,
+                            to_create,
+                            {0u, 0u, 0u},
+                            &frame_to_upload );
+
+    if (!generate_mips_on_cpu) {
+        return;
+    }
+
+    // The staging memory is write only, the filter needs its own copy of the converted level 0
+    uint8_t *converted_level = nullptr;
+    if (data_format != img_format || conversion_flags != PIXEL_CONVERSION_NONE) {
+        converted_level = (uint8_t*) malloc(get_image_data_size(img_format, img_dims));
+        convert_pixels(raw_img_data, data_format, converted_level, img_format, (uint64_t) img_dims.width * img_dims.height, conversion_flags);
+    }
+
+    const uint8_t *src_level = (converted_level != nullptr) ? converted_level : (const uint8_t*) raw_img_data;
+    uint8_t *levels[2u] = {
+        (uint8_t*) malloc(get_pixel_size(img_format) * glm::max(img_dims.width / 2u, 1u) * glm::max(img_dims.height / 2u, 1u)),
+        (uint8_t*) malloc(get_pixel_size(img_format) * glm::max(img_dims.width / 4u, 1u) * glm::max(img_dims.height / 4u, 1u))
+    };
+
+    VkExtent3D level_dims = img_dims;
+    for(uint32_t level = 1u; level < to_create->mip_levels; level++) {
+        // Ping pong between the two scratch levels, the second one is always big enough
+        uint8_t *dst_level = levels[(level - 1u) % 2u];
+        downsample_mip_level(src_level, level_dims.width, level_dims.height, img_format, dst_level);
+
+        level_dims = { glm::max(level_dims.width / 2u, 1u), glm::max(level_dims.height / 2u, 1u), 1u };
+        upload_to_gpu(  dst_level, 
+                        img_format,
+                        level_dims,
+                        to_create,
+                        {0u, 0u, 0u},
+                        &frame_to_upload,
+                        level );
+        src_level = dst_level;
+    }
+
+    free(levels[0u]);
+    free(levels[1u]);
+    free(converted_level);
 }
 
 
@@ -91,6 +274,15 @@ Render::sGPUBuffer Render::sBackend::create_buffer( const size_t buffer_size,
         .usage = usage
     };
 
+    // Buffers that can be written from the transfer queue are shared between both families,
+    // so there is no need for queue ownership transfers on the async uploads
+    const uint32_t queue_families[2u] = { gpu_instance.graphic_queue.family, gpu_instance.transfer_queue.family };
+    if (gpu_instance.has_transfer_queue && (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT)) {
+        buff_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buff_create_info.queueFamilyIndexCount = 2u;
+        buff_create_info.pQueueFamilyIndices = queue_families;
+    }
+
     VmaAllocationCreateInfo vma_alloc_info = {
         .flags = (mapped_on_startup) ? VMA_ALLOCATION_CREATE_MAPPED_BIT : 0u,
         .usage = mem_usage,
@@ -113,75 +305,345 @@ void Render::sBackend::clean_buffer(const Render::sGPUBuffer &buffer) {
     vmaDestroyBuffer(vk_allocator, buffer.buffer, buffer.alloc);
 }
 
+void Render::sBackend::clean_image(const sImage &image) {
+    vkDestroyImageView(gpu_instance.device, image.image_view, nullptr);
+    vmaDestroyImage(vk_allocator, image.image, image.alloc);
+}
+
+static inline glm::vec2 octahedral_encode(const glm::vec3 &direction) {
+    const float manhattan_length = glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z);
+    if (manhattan_length <= 0.0f) {
+        return {0.0f, 0.0f};
+    }
+
+    const glm::vec3 n = direction / manhattan_length;
+    if (n.z >= 0.0f) {
+        return {n.x, n.y};
+    }
+
+    // Fold the lower hemisphere over the diagonals
+    return {    (1.0f - glm::abs(n.y)) * ((n.x >= 0.0f) ? 1.0f : -1.0f),
+                (1.0f - glm::abs(n.x)) * ((n.y >= 0.0f) ? 1.0f : -1.0f) };
+}
+
+static void encode_compact_vertices(const Render::sVertex *vertices,
+                                    const uint32_t vertex_count,
+                                    const glm::vec3 &position_min,
+                                    const glm::vec3 &position_extent,
+                                    Render::sCompactVertex *result) {
+    const glm::vec3 inv_extent = 1.0f / position_extent;
+
+    for(uint32_t i = 0u; i < vertex_count; i++) {
+        const Render::sVertex &vertex = vertices[i];
+        Render::sCompactVertex &compact = result[i];
+
+        const glm::vec3 unorm_position = glm::clamp((vertex.position - position_min) * inv_extent, 0.0f, 1.0f);
+        const uint32_t position_xy = glm::packUnorm2x16({unorm_position.x, unorm_position.y});
+        const uint32_t position_zw = glm::packUnorm2x16({unorm_position.z, 0.0f});
+        memcpy(&compact.position[0u], &position_xy, sizeof(uint32_t));
+        memcpy(&compact.position[2u], &position_zw, sizeof(uint32_t));
+
+        const uint32_t normal = glm::packSnorm2x16(octahedral_encode(vertex.normal));
+        const uint32_t tangent = glm::packSnorm2x16(octahedral_encode(vertex.tangent));
+        const uint32_t uv = glm::packHalf2x16(vertex.uv);
+        memcpy(compact.normal, &normal, sizeof(uint32_t));
+        memcpy(compact.tangent, &tangent, sizeof(uint32_t));
+        memcpy(compact.uv, &uv, sizeof(uint32_t));
+
+        // The meshes without colors get their normal as color on the import, unorm8 would clamp its negative side
+        const bool is_normal_color = glm::vec3(vertex.color) == vertex.normal;
+        compact.color = (is_normal_color) ? 0u : glm::packUnorm4x8(glm::clamp(vertex.color, 0.0f, 1.0f));
+    }
+}
+
+// Doubles the capacity until the required count fits (the blocks never hand out ranges past the max counts)
+static uint32_t get_grown_capacity(const uint32_t capacity, const uint64_t required_count) {
+    uint64_t new_capacity = capacity;
+    while(new_capacity < required_count) {
+        new_capacity *= 2u;
+    }
+    return (uint32_t) new_capacity;
+}
+
+// The old buffer is kept until the copy is done
+static void replace_pool_buffer(Render::sBackend &renderer, 
+                                const VkCommandBuffer cmd, 
+                                Render::sGPUBuffer *buffer, 
+                                VkDeviceAddress *buffer_address, 
+                                const size_t new_size, 
+                                const VkBufferUsageFlags usage, 
+                                const bool keep_content, 
+                                Render::sGPUBuffer *old_buffer) {
+    *old_buffer = *buffer;
+    *buffer = renderer.create_buffer(new_size, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+    // The uploads staged on the old buffer are recorded on the new one, with the same timeline value
+    buffer->upload_timeline_value = old_buffer->upload_timeline_value;
+
+    if (keep_content) {
+        const VkBufferCopy region = {
+            .srcOffset = 0u,
+            .dstOffset = 0u,
+            .size = old_buffer->size
+        };
+        vkCmdCopyBuffer(cmd, old_buffer->buffer, buffer->buffer, 1u, &region);
+    }
+
+    const VkBufferDeviceAddressInfo device_adress_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .pNext = nullptr,
+        .buffer = buffer->buffer
+    };
+    *buffer_address = vkGetBufferDeviceAddress(renderer.gpu_instance.device, &device_adress_info);
+}
+
+// The pool buffers are shared by the frames in flight, they are replaced once the GPU is idle,
+// & their content copied on a one time submit. Rare (the capacities double), same as the mesh draw buffers
+void Render::sBackend::grow_geometry_pool(  const uint64_t vertex_count, 
+                                            const uint64_t index_count, 
+                                            const uint64_t meshlet_count, 
+                                            const uint64_t culled_index_count) {
+    sGeometryPool &pool = geometry_pool;
+    if (vertex_count <= pool.vertex_capacity && index_count <= pool.index_capacity && 
+        meshlet_count <= pool.meshlet_capacity && culled_index_count <= pool.culled_index_capacity) {
+        return;
+    }
+
+    vkDeviceWaitIdle(gpu_instance.device);
+
+    VkCommandPool copy_pool = VK_NULL_HANDLE;
+    VkCommandPoolCreateInfo pool_create_info = VK_Helpers::create_cmd_pool_info(gpu_instance.graphic_queue.family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    vk_assert_msg(  vkCreateCommandPool(gpu_instance.device, &pool_create_info, nullptr, &copy_pool), 
+                    "Error creating the geometry pool copy command pool");
+
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    VkCommandBufferAllocateInfo cmd_alloc_info = VK_Helpers::create_cmd_buffer_alloc_info(copy_pool, 1u);
+    vk_assert_msg(  vkAllocateCommandBuffers(gpu_instance.device, &cmd_alloc_info, &cmd), 
+                    "Error allocating the geometry pool copy command buffer");
+
+    VkCommandBufferBeginInfo cmd_begin = VK_Helpers::create_cmd_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    vk_assert_msg(  vkBeginCommandBuffer(cmd, &cmd_begin), 
+                    "Error beginning the geometry pool copy command buffer");
+
+    sGPUBuffer old_buffers[4u] = {};
+    uint32_t old_buffer_count = 0u;
+
+    if (vertex_count > pool.vertex_capacity) {
+        const uint32_t new_capacity = get_grown_capacity(pool.vertex_capacity, vertex_count);
+        spdlog::info("Growing the geometry pool from {} to {} vertices", pool.vertex_capacity, new_capacity);
+
+        replace_pool_buffer(*this, cmd, &pool.vertex_buffer, &pool.vertex_buffer_address, (size_t) new_capacity * pool.vertex_size, GEOMETRY_POOL_VERTEX_USAGE, true, &old_buffers[old_buffer_count++]);
+        pool.vertex_capacity = new_capacity;
+    }
+
+    if (index_count > pool.index_capacity) {
+        const uint32_t new_capacity = get_grown_capacity(pool.index_capacity, index_count);
+        spdlog::info("Growing the geometry pool from {} to {} indices", pool.index_capacity, new_capacity);
+
+        replace_pool_buffer(*this, cmd, &pool.index_buffer, &pool.index_buffer_address, (size_t) new_capacity * sizeof(uint32_t), GEOMETRY_POOL_INDEX_USAGE, true, &old_buffers[old_buffer_count++]);
+        pool.index_capacity = new_capacity;
+    }
+
+    if (meshlet_count > pool.meshlet_capacity) {
+        const uint32_t new_capacity = get_grown_capacity(pool.meshlet_capacity, meshlet_count);
+        spdlog::info("Growing the geometry pool from {} to {} meshlets", pool.meshlet_capacity, new_capacity);
+
+        replace_pool_buffer(*this, cmd, &pool.meshlet_buffer, &pool.meshlet_buffer_address, (size_t) new_capacity * sizeof(Geometry::sMeshlet), GEOMETRY_POOL_MESHLET_USAGE, true, &old_buffers[old_buffer_count++]);
+        pool.meshlet_capacity = new_capacity;
+    }
+
+    if (culled_index_count > pool.culled_index_capacity) {
+        const uint32_t new_capacity = get_grown_capacity(pool.culled_index_capacity, culled_index_count);
+        replace_pool_buffer(*this, cmd, &pool.culled_index_buffer, &pool.culled_index_buffer_address, (size_t) new_capacity * sizeof(uint32_t), GEOMETRY_POOL_CULLED_INDEX_USAGE, false, &old_buffers[old_buffer_count++]);
+        pool.culled_index_capacity = new_capacity;
+    }
+
+    vk_assert_msg(  vkEndCommandBuffer(cmd), 
+                    "Error ending the geometry pool copy command buffer");
+
+    VkCommandBufferSubmitInfo cmd_info = VK_Helpers::create_cmd_buffer_submit_info(cmd);
+    VkSubmitInfo2 submit = VK_Helpers::create_cmd_submit(&cmd_info, nullptr, nullptr);
+    vk_assert_msg(  vkQueueSubmit2(gpu_instance.graphic_queue.queue, 1u, &submit, VK_NULL_HANDLE), 
+                    "Error submitting the geometry pool copy");
+    vk_assert_msg(  vkQueueWaitIdle(gpu_instance.graphic_queue.queue), 
+                    "Error waiting for the geometry pool copy");
+
+    vkDestroyCommandPool(gpu_instance.device, copy_pool, nullptr);
+    for(uint32_t i = 0u; i < old_buffer_count; i++) {
+        clean_buffer(old_buffers[i]);
+    }
+}
+
 bool Render::sBackend::create_gpu_mesh( Render::sGPUMesh *new_mesh,
                                         const uint32_t *indices, 
                                         const uint32_t index_count, 
                                         const sVertex *vertices, 
                                         const uint32_t vertex_count,
+                                        const Geometry::sMeshlet *meshlets,
+                                        const uint32_t meshlet_count,
+                                        const sMeshLOD *lods,
+                                        const uint32_t lod_count,
                                         sFrame *frame_to_arrive ) {
-    const size_t vertex_buffer_size = vertex_count * sizeof(sVertex);
-    const size_t index_buffer_size = index_count * sizeof(uint32_t);
+    // Small meshes use 16 bit indices (0xFFFF is left out, it is the restart index)
+    const bool use_16bit_indices = vertex_count < UINT16_MAX;
+    const uint32_t index_size = (use_16bit_indices) ? sizeof(uint16_t) : sizeof(uint32_t);
 
-    new_mesh->vertex_buffer = create_buffer( vertex_buffer_size, 
-                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-                                            VMA_MEMORY_USAGE_GPU_ONLY);
-    
-    new_mesh->index_buffer = create_buffer(  index_buffer_size, 
-                                            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                            VMA_MEMORY_USAGE_GPU_ONLY);
-    
-    VkBufferDeviceAddressInfo device_adress_info = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-        .pNext = nullptr,
-        .buffer = new_mesh->vertex_buffer.buffer
-    };
-    new_mesh->vertex_buffer_address = vkGetBufferDeviceAddress(gpu_instance.device, &device_adress_info);
+    // Get the ranges on the scene's vertex, index & meshlet buffers
+    if (!geometry_pool.alloc_vertices(vertex_count, &new_mesh->vertex_alloc, &new_mesh->first_vertex)) {
+        return false;
+    }
+
+    if (!geometry_pool.alloc_indices(index_count, index_size, &new_mesh->index_alloc, &new_mesh->first_index)) {
+        geometry_pool.free_vertices(new_mesh->vertex_alloc);
+        return false;
+    }
+
+    if (!geometry_pool.alloc_meshlets(meshlet_count, &new_mesh->meshlet_alloc, &new_mesh->first_meshlet)) {
+        geometry_pool.free_vertices(new_mesh->vertex_alloc);
+        geometry_pool.free_indices(new_mesh->index_alloc);
+        return false;
+    }
+
+    // The culling only writes the selected level, the range fits the biggest one
+    uint32_t culled_index_count = (lod_count > 0u) ? 0u : index_count;
+    for(uint32_t i = 0u; i < lod_count && i < MESH_MAX_LODS; i++) {
+        culled_index_count = (lods[i].index_count > culled_index_count) ? lods[i].index_count : culled_index_count;
+    }
+
+    if (!geometry_pool.alloc_culled_indices(culled_index_count, index_size, &new_mesh->culled_index_alloc, &new_mesh->first_culled_index)) {
+        geometry_pool.free_vertices(new_mesh->vertex_alloc);
+        geometry_pool.free_indices(new_mesh->index_alloc);
+        geometry_pool.free_meshlets(new_mesh->meshlet_alloc);
+        return false;
+    }
 
-    upload_to_gpu(indices, index_buffer_size, &new_mesh->index_buffer, 0u, frame_to_arrive);
-    upload_to_gpu(vertices, vertex_buffer_size, &new_mesh->vertex_buffer, 0u, frame_to_arrive);
+    // The ranges can end past the buffers, they grow before anything is staged on them
+    // The index ends are in bytes on the blocks, counted as 32 bit indices on the capacities
+    grow_geometry_pool( (uint64_t) new_mesh->first_vertex + vertex_count, 
+                        (((uint64_t) new_mesh->first_index + index_count) * index_size + sizeof(uint32_t) - 1u) / sizeof(uint32_t), 
+                        (uint64_t) new_mesh->first_meshlet + meshlet_count, 
+                        (((uint64_t) new_mesh->first_culled_index + culled_index_count) * index_size + sizeof(uint32_t) - 1u) / sizeof(uint32_t));
 
     new_mesh->index_count = index_count;
+    new_mesh->vertex_count = vertex_count;
+    new_mesh->meshlet_count = meshlet_count;
+    new_mesh->index_type = (use_16bit_indices) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+    new_mesh->lod_count = (lod_count < MESH_MAX_LODS) ? lod_count : MESH_MAX_LODS;
+    memcpy(new_mesh->lods, lods, sizeof(sMeshLOD) * new_mesh->lod_count);
+    new_mesh->current_lod = 0u;
+
+    // AABB & the sphere around its center, for the culling & the LOD selection
+    {
+        glm::vec3 aabb_min = vertices[0u].position, aabb_max = vertices[0u].position;
+        for(uint32_t i = 1u; i < vertex_count; i++) {
+            aabb_min = glm::min(aabb_min, vertices[i].position);
+            aabb_max = glm::max(aabb_max, vertices[i].position);
+        }
 
-    // TODO: error management
-    return true;
-}
+        new_mesh->bounds_center = (aabb_min + aabb_max) * 0.5f;
+        new_mesh->bounds_extent = (aabb_max - aabb_min) * 0.5f;
+        new_mesh->bounds_radius = 0.0f;
+        for(uint32_t i = 0u; i < vertex_count; i++) {
+            const float distance = glm::length(vertices[i].position - new_mesh->bounds_center);
+            new_mesh->bounds_radius = (distance > new_mesh->bounds_radius) ? distance : new_mesh->bounds_radius;
+        }
+    }
 
-void Render::sBackend::upload_to_gpu(   const void* data, 
-                                        const size_t upload_size, 
-                                        sGPUBuffer *gpu_dst_buffer, 
-                                        const size_t dst_offset, 
-                                        sFrame *frame_to_upload ) {
-    assert_msg( frame_to_upload->staging_buffer_count < MAX_STAGING_BUFFER_COUNT, 
-                "Too many staging buffers in a frame!");
+    // The conversions are written straight to the staging memory
+    if (use_16bit_indices) {
+        uint16_t *staged_indices = (uint16_t*) stage_buffer_upload( index_count * sizeof(uint16_t), 
+                                                                    &geometry_pool.index_buffer, 
+                                                                    new_mesh->first_index * sizeof(uint16_t), 
+                                                                    frame_to_arrive, 
+                                                                    true);
+        for(uint32_t i = 0u; i < index_count; i++) {
+            staged_indices[i] = (uint16_t) indices[i];
+        }
+    } else {
+        upload_to_gpu(  indices, 
+                        index_count * sizeof(uint32_t), 
+                        &geometry_pool.index_buffer, 
+                        new_mesh->first_index * sizeof(uint32_t), 
+                        frame_to_arrive, 
+                        true);
+    }
 
-    uint32_t staging_idx = frame_to_upload->staging_buffer_count++;
-    frame_to_upload->staging_buffers[staging_idx] = create_buffer(  upload_size,
-                                                                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                                    VMA_MEMORY_USAGE_CPU_ONLY,
-                                                                    true    );
+    if (geometry_pool.use_compact_vertices) {
+        glm::vec3 position_max = vertices[0u].position;
+        new_mesh->position_min = vertices[0u].position;
+        for(uint32_t i = 1u; i < vertex_count; i++) {
+            new_mesh->position_min = glm::min(new_mesh->position_min, vertices[i].position);
+            position_max = glm::max(position_max, vertices[i].position);
+        }
+        // Flat meshes would divide by 0
+        new_mesh->position_extent = glm::max(position_max - new_mesh->position_min, glm::vec3(1e-6f));
+
+        sCompactVertex *staged_vertices = (sCompactVertex*) stage_buffer_upload(vertex_count * sizeof(sCompactVertex), 
+                                                                                &geometry_pool.vertex_buffer, 
+                                                                                new_mesh->first_vertex * sizeof(sCompactVertex), 
+                                                                                frame_to_arrive, 
+                                                                                true);
+        encode_compact_vertices(vertices, vertex_count, new_mesh->position_min, new_mesh->position_extent, staged_vertices);
+    } else {
+        upload_to_gpu(  vertices, 
+                        vertex_count * sizeof(sVertex), 
+                        &geometry_pool.vertex_buffer, 
+                        new_mesh->first_vertex * sizeof(sVertex), 
+                        frame_to_arrive, 
+                        true);
+    }
 
-    // Get the mapped address of teh buffer on the CPU
-    void* mapped_staging_buffer;
-    vmaMapMemory(vk_allocator, frame_to_upload->staging_buffers[staging_idx].alloc, &mapped_staging_buffer);
+    upload_to_gpu(  meshlets, 
+                    meshlet_count * sizeof(Geometry::sMeshlet), 
+                    &geometry_pool.meshlet_buffer, 
+                    new_mesh->first_meshlet * sizeof(Geometry::sMeshlet), 
+                    frame_to_arrive, 
+                    true);
 
-    // Copy the data to the CPU side mapped stating buffer
-    memcpy(mapped_staging_buffer, data, upload_size);
+    // The pool buffers are stamped on every upload, the mesh keeps the value of its own data
+    new_mesh->upload_timeline_value = geometry_pool.vertex_buffer.upload_timeline_value;
 
-    vmaUnmapMemory(vk_allocator, frame_to_upload->staging_buffers[staging_idx].alloc);
+    return true;
+}
+
+void* Render::sBackend::stage_buffer_upload(   const size_t upload_size, 
+                                                sGPUBuffer *gpu_dst_buffer, 
+                                                const size_t dst_offset, 
+                                                sFrame *frame_to_upload,
+                                                const bool async_upload ) {
+    // Get a range of the frame's staging ring, it is always mapped on the CPU
+    const sGPUBufferView staging_view = frame_to_upload->staging_ring.alloc(upload_size);
 
     // Add to the list of the resolves, for when whe have the cmd buffer started n running
-    frame_to_upload->staging_to_resolve[frame_to_upload->staging_to_resolve_count++] = {
-        .src_buffer = {
-            .raw_buffer = &frame_to_upload->staging_buffers[staging_idx],
-            .offset = 0u,
-            .size = upload_size
-        },
+    // Async ones are submitted on the transfer queue on the next capture, and the frames that use them wait for them
+    sDynamicArray<sStagingToResolve> *resolve_list = &frame_to_upload->staging_to_resolve;
+    if (async_upload && gpu_instance.has_transfer_queue) {
+        resolve_list = &async_staging_to_resolve;
+        gpu_dst_buffer->upload_timeline_value = upload_timeline_value + 1u;
+    }
+
+    resolve_list->push({
+        .src_buffer = staging_view,
         .dst_buffer = {
             .raw_buffer = gpu_dst_buffer,
             .offset = dst_offset,
             .size = upload_size
         }
-    };
+    });
+
+    return frame_to_upload->staging_ring.get_mapped(staging_view);
+}
+
+void Render::sBackend::upload_to_gpu(   const void* data, 
+                                        const size_t upload_size, 
+                                        sGPUBuffer *gpu_dst_buffer, 
+                                        const size_t dst_offset, 
+                                        sFrame *frame_to_upload,
+                                        const bool async_upload ) {
+    // Copy the data to the CPU side mapped stating buffer
+    memcpy( stage_buffer_upload(upload_size, gpu_dst_buffer, dst_offset, frame_to_upload, async_upload), 
+            data, 
+            upload_size);
 }
 
 void Render::sBackend::upload_to_gpu(   const void* data, 
@@ -189,37 +651,51 @@ void Render::sBackend::upload_to_gpu(   const void* data,
                                         const VkExtent3D src_img_size, 
                                         sImage *gpu_dst_image, 
                                         const VkExtent3D dst_pos, 
-                                        sFrame *frame_to_upload ) {
-    assert_msg( frame_to_upload->staging_buffer_count < MAX_STAGING_BUFFER_COUNT, 
-                "Too many staging buffers in a frame!");
-
-    const uint32_t upload_size = get_pixel_size(tex_format) * src_img_size.width * src_img_size.height * src_img_size.depth;
-    
-    uint32_t staging_idx = frame_to_upload->staging_buffer_count++;
-    frame_to_upload->staging_buffers[staging_idx] = create_buffer(  upload_size,
-                                                                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                                    VMA_MEMORY_USAGE_CPU_ONLY,
-                                                                    true    );
+                                        sFrame *frame_to_upload,
+                                        const uint32_t mip_level ) {
+    // Copy the data to the CPU side mapped stating buffer
+    memcpy( stage_image_upload(tex_format, src_img_size, gpu_dst_image, dst_pos, frame_to_upload, mip_level), 
+            data, 
+            get_image_data_size(tex_format, src_img_size));
+}
 
-    // Get the mapped address of teh buffer on the CPU
-    void* mapped_staging_buffer;
-    vmaMapMemory(vk_allocator, frame_to_upload->staging_buffers[staging_idx].alloc, &mapped_staging_buffer);
+void Render::sBackend::upload_converted_to_gpu( const void* pixels, 
+                                                const eImageFormats src_format, 
+                                                const uint32_t conversion_flags,
+                                                const VkExtent3D src_img_size, 
+                                                sImage *gpu_dst_image, 
+                                                const VkExtent3D dst_pos, 
+                                                sFrame *frame_to_upload,
+                                                const uint32_t mip_level ) {
+    convert_pixels( pixels, 
+                    src_format, 
+                    stage_image_upload(gpu_dst_image->format, src_img_size, gpu_dst_image, dst_pos, frame_to_upload, mip_level), 
+                    gpu_dst_image->format, 
+                    (uint64_t) src_img_size.width * src_img_size.height * src_img_size.depth, 
+                    conversion_flags);
+}
 
-    // Copy the data to the CPU side mapped stating buffer
-    memcpy(mapped_staging_buffer, data, upload_size);
+void* Render::sBackend::stage_image_upload( const eImageFormats tex_format, 
+                                            const VkExtent3D src_img_size, 
+                                            sImage *gpu_dst_image, 
+                                            const VkExtent3D dst_pos, 
+                                            sFrame *frame_to_upload,
+                                            const uint32_t mip_level ) {
+    const size_t pixel_size = get_pixel_size(tex_format);
+    const size_t upload_size = get_image_data_size(tex_format, src_img_size);
 
-    vmaUnmapMemory(vk_allocator, frame_to_upload->staging_buffers[staging_idx].alloc);
+    // bufferOffset needs to be a multiple of the texel (or block) size and of 4
+    const sGPUBufferView staging_view = frame_to_upload->staging_ring.alloc(upload_size, pixel_size * 4u);
 
     // Add to the list of the resolves, for when whe have the cmd buffer started n running
-    frame_to_upload->staging_to_resolve[frame_to_upload->staging_to_resolve_count++] = {
+    frame_to_upload->staging_to_resolve.push({
         .dst_is_image = true,
-        .src_buffer = {
-            .raw_buffer = &frame_to_upload->staging_buffers[staging_idx],
-            .offset = 0u,
-            .size = upload_size
-        },
+        .src_buffer = staging_view,
         .dst_image = gpu_dst_image,
         .dst_copy_pos = dst_pos,
-        .img_size = src_img_size
-    };
+        .img_size = src_img_size,
+        .dst_mip_level = mip_level
+    });
+
+    return frame_to_upload->staging_ring.get_mapped(staging_view);
 }
\ No newline at end of file
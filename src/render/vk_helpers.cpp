@@ -63,12 +63,12 @@ VkSemaphoreCreateInfo VK_Helpers::create_semaphore_info( const VkSemaphoreCreate
     };
 }
 
-VkSemaphoreSubmitInfo VK_Helpers::create_submit_semphore_info(const VkPipelineStageFlags2 stage_mask, const VkSemaphore semaphore) {
+VkSemaphoreSubmitInfo VK_Helpers::create_submit_semphore_info(const VkPipelineStageFlags2 stage_mask, const VkSemaphore semaphore, const uint64_t value) {
     return {
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
         .pNext = nullptr,
         .semaphore = semaphore,
-        .value = 1u, // To send the semaphore
+        .value = value, // Ignored by binary semaphores, the value to signal/wait on timeline ones
         .stageMask = stage_mask,
         .deviceIndex = 0u
     };
@@ -76,12 +76,13 @@ VkSemaphoreSubmitInfo VK_Helpers::create_submit_semphore_info(const VkPipelineSt
 
 VkSubmitInfo2 VK_Helpers::create_cmd_submit(    const VkCommandBufferSubmitInfo *cmd, 
                                                 const VkSemaphoreSubmitInfo *signal_semaphore_info, 
-                                                const VkSemaphoreSubmitInfo *wait_semphore_info) {
+                                                const VkSemaphoreSubmitInfo *wait_semphore_info,
+                                                const uint32_t wait_semaphore_count) {
     return {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
         .pNext = nullptr,
         
-        .waitSemaphoreInfoCount = (wait_semphore_info == nullptr) ? 0u : 1u,
+        .waitSemaphoreInfoCount = (wait_semphore_info == nullptr) ? 0u : wait_semaphore_count,
         .pWaitSemaphoreInfos = wait_semphore_info,
 
         .commandBufferInfoCount = 1u,
@@ -162,7 +163,8 @@ VkImageCreateInfo VK_Helpers::image2D_create_info(  const VkFormat format,
 
 VkImageViewCreateInfo VK_Helpers::image_view2D_create_info( const VkFormat format, 
                                                             const VkImage &image, 
-                                                            const VkImageAspectFlags &aspect_flags) {
+                                                            const VkImageAspectFlags &aspect_flags,
+                                                            const uint32_t mip_levels) {
     return {
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .pNext = nullptr,
@@ -172,7 +174,7 @@ VkImageViewCreateInfo VK_Helpers::image_view2D_create_info( const VkFormat forma
         .subresourceRange = {
             .aspectMask = aspect_flags,
             .baseMipLevel = 0u,
-            .levelCount = 1u,
+            .levelCount = mip_levels,
             .baseArrayLayer = 0u,
             .layerCount = 1u
         }
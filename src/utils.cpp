@@ -3,6 +3,7 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <spdlog/spdlog.h>
 
@@ -48,4 +49,41 @@ uint8_t str_file_open(   const char* file_dir,
 
     // TODO: should remove the null terminator from the size??
     return bin_file_size / sizeof(char);
+}
+
+uint64_t hash_bytes(const void* data,
+                    const uint64_t size) {
+    // MurmurHash64A: every input bit reaches every hash bit, on the words & on the final mix
+    const uint64_t m = 0xc6a4a7935bd1e995ull;
+    const uint32_t r = 47u;
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ (size * m);
+
+    const uint8_t *bytes = (const uint8_t*) data;
+
+    // A word at a time, the per byte loop is too slow for big assets
+    uint64_t i = 0u;
+    for(; i + 8u <= size; i += 8u) {
+        uint64_t word = 0u;
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+
+        word *= m;
+        word ^= word >> r;
+        word *= m;
+
+        hash ^= word;
+        hash *= m;
+    }
+
+    if (i < size) {
+        for(uint32_t j = 0u; i + j < size; j++) {
+            hash ^= ((uint64_t) bytes[i + j]) << (8u * j);
+        }
+        hash *= m;
+    }
+
+    hash ^= hash >> r;
+    hash *= m;
+    hash ^= hash >> r;
+
+    return hash;
 }
\ No newline at end of file
@@ -8,4 +8,7 @@ void assert_msg(bool test, const char* message);
 
 uint64_t bin_file_open(const char* file_dir, char** raw_file);
 
-uint8_t str_file_open(   const char* file_dir, char** result_buffer    );
\ No newline at end of file
+uint8_t str_file_open(   const char* file_dir, char** result_buffer    );
+
+// MurmurHash64A, for content hashes (baked asset invalidation) & hash tables, not cryptographic
+uint64_t hash_bytes(const void* data, const uint64_t size);
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+* Growable array, for lists that have no sensible upper bound per frame
+* Storage is lazily allocated on the first push, so a zeroed struct is ready to use.
+* Elements are moved with realloc, so only use it for trivially copyable types.
+* clear() keeps the storage around, clean() releases it.
+ */
+
+template<typename T>
+struct sDynamicArray {
+    T *data = nullptr;
+
+    uint32_t count = 0u;
+    uint32_t capacity = 0u;
+
+    void reserve(const uint32_t new_capacity) {
+        if (new_capacity <= capacity) {
+            return;
+        }
+
+        data = (T*) realloc(data, sizeof(T) * new_capacity);
+        capacity = new_capacity;
+    }
+
+    inline T& push(const T& to_add) {
+        if (count == capacity) {
+            reserve((capacity == 0u) ? 16u : capacity * 2u);
+        }
+
+        data[count] = to_add;
+        return data[count++];
+    }
+
+    inline T* push_n(const uint32_t element_count) {
+        if (count + element_count > capacity) {
+            uint32_t new_capacity = (capacity == 0u) ? 16u : capacity;
+            while(new_capacity < count + element_count) {
+                new_capacity *= 2u;
+            }
+            reserve(new_capacity);
+        }
+
+        T* first_added = &data[count];
+        count += element_count;
+        return first_added;
+    }
+
+    inline T& operator[](const uint32_t idx) {
+        return data[idx];
+    }
+
+    inline const T& operator[](const uint32_t idx) const {
+        return data[idx];
+    }
+
+    inline void clear() {
+        count = 0u;
+    }
+
+    void clean() {
+        free(data);
+
+        data = nullptr;
+        count = 0u;
+        capacity = 0u;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "job_system.h"
+
+#include <memory>
+
+// The constructor of a function local static runs once, even with concurrent first calls
+struct sJobSystemInstance {
+    sJobSystem  job_system;
+
+    sJobSystemInstance() {
+        const uint32_t core_count = std::thread::hardware_concurrency();
+        job_system.init((core_count > 1u) ? core_count - 1u : 1u);
+    }
+};
+
+sJobSystem& sJobSystem::get() {
+    static sJobSystemInstance instance;
+    return instance.job_system;
+}
+
+void sJobSystem::init(const uint32_t thread_count) {
+    is_running = true;
+    worker_count = thread_count;
+
+    workers = new std::thread[worker_count];
+    for(uint32_t i = 0u; i < worker_count; i++) {
+        workers[i] = std::thread(&sJobSystem::worker_loop, this);
+    }
+}
+
+void sJobSystem::clean() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        is_running = false;
+    }
+    queue_condition.notify_all();
+
+    for(uint32_t i = 0u; i < worker_count; i++) {
+        workers[i].join();
+    }
+
+    delete[] workers;
+    workers = nullptr;
+    worker_count = 0u;
+}
+
+void sJobSystem::submit(std::function<void()> &&job) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        job_queue.push_back(std::move(job));
+    }
+    queue_condition.notify_one();
+}
+
+bool sJobSystem::try_run_queued_job() {
+    std::function<void()> job;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (job_queue.empty()) {
+            return false;
+        }
+        job = std::move(job_queue.front());
+        job_queue.pop_front();
+    }
+
+    job();
+    return true;
+}
+
+void sJobSystem::worker_loop() {
+    while(true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_condition.wait(lock, [this]() { return !is_running || !job_queue.empty(); });
+
+            if (!is_running && job_queue.empty()) {
+                return;
+            }
+
+            job = std::move(job_queue.front());
+            job_queue.pop_front();
+        }
+
+        job();
+    }
+}
+
+void sJobSystem::parallel_for(  const uint32_t count,
+                                const uint32_t batch_size,
+                                const std::function<void(uint32_t)> &job) {
+    if (count == 0u) {
+        return;
+    }
+
+    const uint32_t batch_count = (count + batch_size - 1u) / batch_size;
+
+    // Shared with the helpers: they can start after this call returned (the queue is busy with other jobs),
+    // and then find every batch claimed. The job is only touched after claiming a batch, while the caller still waits
+    struct sParallelForState {
+        std::atomic<uint32_t>   next_batch = 0u;
+        std::atomic<uint32_t>   finished_batches = 0u;
+    };
+    std::shared_ptr<sParallelForState> state = std::make_shared<sParallelForState>();
+    const std::function<void(uint32_t)> *batch_job = &job;
+
+    auto run_batches = [state, batch_job, batch_count, batch_size, count]() {
+        uint32_t batch = state->next_batch.fetch_add(1u);
+        while(batch < batch_count) {
+            const uint32_t end = (batch + 1u) * batch_size;
+            for(uint32_t i = batch * batch_size; i < end && i < count; i++) {
+                (*batch_job)(i);
+            }
+            state->finished_batches.fetch_add(1u);
+            batch = state->next_batch.fetch_add(1u);
+        }
+    };
+
+    const uint32_t helper_count = (batch_count - 1u < worker_count) ? batch_count - 1u : worker_count;
+    for(uint32_t i = 0u; i < helper_count; i++) {
+        submit(run_batches);
+    }
+
+    run_batches();
+
+    // Every batch is claimed, only wait for the ones still running on the helpers.
+    // Never runs other queued jobs here: the queue has the imports & decodes, too long to run inline on the caller
+    while(state->finished_batches.load() < batch_count) {
+        std::this_thread::yield();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+* Minimal worker pool, shared by the whole app
+* submit() queues fire & forget jobs, parallel_for() splits a range on batches
+* and blocks until all of them are done. The calling thread also claims batches, so it never waits
+* for helpers that did not start yet (nested parallel_fors cannot deadlock), and it never runs other queued jobs.
+ */
+
+struct sJobSystem {
+    std::thread                         *workers = nullptr;
+    uint32_t                            worker_count = 0u;
+
+    std::mutex                          queue_mutex;
+    std::condition_variable             queue_condition;
+    std::deque<std::function<void()>>   job_queue;
+    bool                                is_running = false;
+
+    // Started on the first call with a worker per core (minus the main thread)
+    static sJobSystem& get();
+
+    void init(const uint32_t thread_count);
+    void clean();
+
+    void submit(std::function<void()> &&job);
+    void parallel_for(const uint32_t count, const uint32_t batch_size, const std::function<void(uint32_t)> &job);
+
+    bool try_run_queued_job();
+    void worker_loop();
+};
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool sMappedFile::open(const char* file_dir) {
+    file_handle = CreateFileA(file_dir, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER file_size = {};
+    GetFileSizeEx(file_handle, &file_size);
+    size = (uint64_t) file_size.QuadPart;
+
+    if (size == 0u) {
+        close();
+        return false;
+    }
+
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+    if (mapping_handle == nullptr) {
+        close();
+        return false;
+    }
+
+    data = (const uint8_t*) MapViewOfFile(mapping_handle, FILE_MAP_READ, 0u, 0u, 0u);
+    if (data == nullptr) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void sMappedFile::close() {
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+
+    *this = {};
+}
+
+#else
+
+bool sMappedFile::open(const char* file_dir) {
+    file_descriptor = ::open(file_dir, O_RDONLY);
+    if (file_descriptor < 0) {
+        return false;
+    }
+
+    struct stat file_stats = {};
+    if (fstat(file_descriptor, &file_stats) != 0 || file_stats.st_size == 0) {
+        close();
+        return false;
+    }
+    size = (uint64_t) file_stats.st_size;
+
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    // The whole file is read front to back on the loads
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    data = (const uint8_t*) mapping;
+
+    return true;
+}
+
+void sMappedFile::close() {
+    if (data) {
+        munmap((void*) data, size);
+    }
+    if (file_descriptor >= 0) {
+        ::close(file_descriptor);
+    }
+
+    *this = {};
+}
+
+#endif
\ No newline at end of file
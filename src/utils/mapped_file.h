@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+* Read only memory map of a whole file, the pages are loaded by the OS on access
+ */
+
+struct sMappedFile {
+    const uint8_t   *data = nullptr;
+    uint64_t        size = 0u;
+
+#ifdef _WIN32
+    void            *file_handle = nullptr;
+    void            *mapping_handle = nullptr;
+#else
+    int             file_descriptor = -1;
+#endif
+
+    bool open(const char* file_dir);
+    void close();
+};
\ No newline at end of file